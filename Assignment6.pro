@@ -103,6 +103,10 @@ unix:!macx {
     QMAKE_CXXFLAGS += -Wno-dangling-field
     QMAKE_CXXFLAGS += -Wno-unused-const-variable
     LIBS += -ldl
+
+    # std::thread, used by the batch interface in batch.h
+    QMAKE_CXXFLAGS += -pthread
+    QMAKE_LFLAGS += -pthread
 }
 
 # increase system stack size (helpful for recursive programs)
@@ -127,6 +131,8 @@ DEFINES += SPL_CONSOLE_ECHO
 DEFINES += SPL_CONSOLE_EXIT_ON_CLOSE
 DEFINES += SPL_VERIFY_JAVA_BACKEND_VERSION
 DEFINES += SPL_PROJECT_VERSION=20141113
+# uncomment to build a headless binary that never launches the Java back end
+# DEFINES += SPL_HEADLESS
 
 # directories examined by Qt Creator when student writes an #include statement
 INCLUDEPATH += $$PWD/lib/StanfordCPPLib/
@@ -0,0 +1,984 @@
+/*
+ * File: bench.cpp
+ * ---------------
+ * This file is the driver for the interpreter benchmarks.  Each
+ * benchmark prints one line of JSON to standard output so that the
+ * results can be collected and compared by scripts.  The command line
+ *
+ *    bench [--iterations n] [--programs directory]
+ *
+ * sets the number of times each program is run and the directory that
+ * holds the corpus of BASIC programs.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "arena.h"
+#include "batch.h"
+#include "bytecode.h"
+#include "cache.h"
+#include "evalstate.h"
+#include "interpreter.h"
+#include "jit.h"
+#include "lexer.h"
+#include "loader.h"
+#include "matrix.h"
+#include "optimizer.h"
+#include "parser.h"
+#include "profiler.h"
+#include "program.h"
+#include "resolver.h"
+#include "scheduler.h"
+#include "statement.h"
+#include "strlib.h"
+#include "threadpool.h"
+#include "tokenscanner.h"
+#include "vm.h"
+
+#ifdef _WIN32
+#  include <windows.h>
+#  include <psapi.h>
+#else
+#  include <sys/resource.h>
+#  include <unistd.h>
+#endif
+
+using namespace std;
+
+/* Constants */
+
+const int LOAD_LINES = 100000;
+const int PARSE_LINES = 20000;
+const int CHURN_LINES = 5000;
+const int CHURN_ROUNDS = 40;
+const int RELINK_EDITS = 200;
+const int STRLIB_VALUES = 200000;
+const int BATCH_PROGRAMS = 4000;
+const int SCHEDULED_PROGRAMS = 500;
+const int MATRIX_SIZE = 256;
+const int MATRIX_ROUNDS = 5;
+const int DEFAULT_ITERATIONS = 3;
+
+#ifdef BENCH_PROGRAMS
+const string DEFAULT_PROGRAMS = BENCH_PROGRAMS;
+#else
+const string DEFAULT_PROGRAMS = "programs";
+#endif
+
+/*
+ * Constant: CORPUS
+ * ----------------
+ * The programs in the corpus directory, each of which stresses one
+ * path through the interpreter:
+ *
+ *  - goto-loop:    a tight loop of GOTO and IF around a single LET
+ *  - if-chain:     a sixteen-way dispatch through consecutive IFs
+ *  - nested-loop:  nested counting loops around arithmetic
+ *  - for-loop:     the same loops written with FOR and NEXT
+ *  - gosub:        a loop that calls a one-line subroutine
+ *  - sieve:        a sieve of Eratosthenes over an array of a million
+ *                  elements, whose subscripts need no checks
+ *  - matmul:       repeated MAT products of two 100 by 100 matrices
+ *  - wide-counter: 64-bit and double accumulators in nested FOR loops
+ *  - print-heavy:  two PRINT statements on every trip through a loop
+ *
+ * The programs with many variables or long blocks of LET statements
+ * are generated by the functions below.
+ */
+
+const char *const CORPUS[] = {
+    "goto-loop", "if-chain", "nested-loop", "for-loop", "gosub", "sieve",
+    "matmul", "wide-counter", "print-heavy"
+};
+
+/*
+ * Class: HashBuffer
+ * -----------------
+ * This stream buffer discards the characters written to it and keeps
+ * only their FNV-1a hash.  Sending PRINT output here keeps the terminal
+ * out of the measurements while still letting the output of the three
+ * engines be compared.
+ */
+
+class HashBuffer : public streambuf {
+public:
+    HashBuffer() { reset(); }
+    void reset() { hash = 2166136261u; }
+    unsigned getHash() const { return hash; }
+protected:
+    virtual int overflow(int ch) {
+        if (ch != EOF) add(ch);
+        return ch;
+    }
+    virtual streamsize xsputn(const char *s, streamsize n) {
+        for (streamsize i = 0; i < n; i++) {
+            add(s[i]);
+        }
+        return n;
+    }
+private:
+    unsigned hash;
+    void add(char ch) { hash = (hash ^ (unsigned char) ch) * 16777619u; }
+};
+
+/* Function prototypes */
+
+void benchmarkLoad(string order, const vector<int> & lineNumbers);
+void benchmarkParse(int nLines);
+void benchmarkLex(int nLines);
+void benchmarkStrlib(int nValues);
+void reportConversion(string function, int calls, double streamTime,
+                      double strlibTime, bool agree);
+void benchmarkChurn(int nLines, int rounds);
+void benchmarkRelink(int nLines, int edits);
+void benchmarkCache(int nLines);
+void benchmarkProgram(string name, string source, int iterations);
+void benchmarkKernels(int size, int rounds);
+void benchmarkBatch(int nPrograms);
+void benchmarkScheduler(int nPrograms, int quantum);
+string countingProgram(int index);
+double runEngine(string engine, Program & program, EvalState & state, int iterations);
+string manyVariablesProgram(int nVariables);
+string straightLineProgram(int nLines);
+string readFile(string filename);
+void loadSource(string source, Program & program, EvalState & state);
+long getPeakRSS();
+long getCurrentRSS();
+double secondsSince(chrono::steady_clock::time_point start);
+
+/* Main program */
+
+int main(int argc, char **argv) {
+    int iterations = DEFAULT_ITERATIONS;
+    string programs = DEFAULT_PROGRAMS;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc) {
+            iterations = max(1, atoi(argv[++i]));
+        } else if (arg == "--programs" && i + 1 < argc) {
+            programs = argv[++i];
+        } else {
+            cerr << "Usage: bench [--iterations n] [--programs directory]" << endl;
+            return 2;
+        }
+    }
+    vector<int> ascending;
+    for (int i = 1; i <= LOAD_LINES; i++) {
+        ascending.push_back(10 * i);
+    }
+    vector<int> descending(ascending.rbegin(), ascending.rend());
+    vector<int> shuffled = ascending;
+    unsigned seed = 12345;
+    for (int i = shuffled.size() - 1; i > 0; i--) {
+        seed = seed * 1103515245 + 12345;
+        swap(shuffled[i], shuffled[(seed >> 8) % (i + 1)]);
+    }
+    benchmarkLoad("ascending", ascending);
+    benchmarkLoad("descending", descending);
+    benchmarkLoad("random", shuffled);
+    benchmarkParse(PARSE_LINES);
+    benchmarkLex(PARSE_LINES);
+    benchmarkStrlib(STRLIB_VALUES);
+    benchmarkChurn(CHURN_LINES, CHURN_ROUNDS);
+    benchmarkRelink(1000, RELINK_EDITS);
+    benchmarkRelink(10000, RELINK_EDITS);
+    benchmarkRelink(100000, RELINK_EDITS);
+    benchmarkCache(PARSE_LINES);
+    benchmarkKernels(MATRIX_SIZE, MATRIX_ROUNDS);
+    for (size_t i = 0; i < sizeof CORPUS / sizeof CORPUS[0]; i++) {
+        string name = CORPUS[i];
+        benchmarkProgram(name, readFile(programs + "/" + name + ".bas"), iterations);
+    }
+    benchmarkProgram("many-variables", manyVariablesProgram(500), iterations);
+    benchmarkProgram("straight-line", straightLineProgram(2000), iterations);
+    benchmarkBatch(BATCH_PROGRAMS);
+    benchmarkScheduler(SCHEDULED_PROGRAMS, 100);
+    benchmarkScheduler(SCHEDULED_PROGRAMS, Scheduler::DEFAULT_QUANTUM);
+    return 0;
+}
+
+/*
+ * Function: benchmarkLoad
+ * Usage: benchmarkLoad(order, lineNumbers);
+ * -----------------------------------------
+ * Measures the time needed to store a program whose lines arrive in the
+ * specified order, then to walk it from first line to last, and then to
+ * delete every line.  The statements themselves are not parsed, so the
+ * times reflect only the cost of the line store in Program.
+ */
+
+void benchmarkLoad(string order, const vector<int> & lineNumbers) {
+    Program program;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t i = 0; i < lineNumbers.size(); i++) {
+        int lineNumber = lineNumbers[i];
+        program.addSourceLine(lineNumber, integerToString(lineNumber) + " REM");
+    }
+    double loadTime = secondsSince(start);
+    start = chrono::steady_clock::now();
+    int count = 0;
+    for (int n = program.getFirstLineNumber(); n != -1; n = program.getNextLineNumber(n)) {
+        count++;
+    }
+    double walkTime = secondsSince(start);
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < lineNumbers.size(); i++) {
+        program.removeSourceLine(lineNumbers[i]);
+    }
+    double removeTime = secondsSince(start);
+    cout << "{\"benchmark\":\"load-" << order << "\""
+         << ",\"lines\":" << count
+         << ",\"load_seconds\":" << loadTime
+         << ",\"walk_seconds\":" << walkTime
+         << ",\"remove_seconds\":" << removeTime
+         << ",\"peak_rss_kb\":" << getPeakRSS()
+         << "}" << endl;
+}
+
+/*
+ * Function: benchmarkParse
+ * Usage: benchmarkParse(nLines);
+ * ------------------------------
+ * Measures the time needed to parse, optimize, and store a generated
+ * program with the specified number of lines, which is the work the
+ * interpreter does when it loads a large program.
+ */
+
+void benchmarkParse(int nLines) {
+    string source = straightLineProgram(nLines);
+    Program program;
+    EvalState state;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    loadSource(source, program, state);
+    double seconds = secondsSince(start);
+    cout << "{\"benchmark\":\"parse\""
+         << ",\"lines\":" << nLines
+         << ",\"seconds\":" << seconds
+         << ",\"lines_per_second\":" << nLines / seconds
+         << ",\"peak_rss_kb\":" << getPeakRSS()
+         << "}" << endl;
+}
+
+/*
+ * Function: benchmarkLex
+ * Usage: benchmarkLex(nLines);
+ * ----------------------------
+ * Measures how fast the lines of a generated program are divided into
+ * tokens, first by a TokenScanner set up as the parser once used it and
+ * then by the Lexer that replaced it.  Each row reports lines per
+ * second, and the token counts are compared to check that the two
+ * agree on where the tokens are.
+ */
+
+void benchmarkLex(int nLines) {
+    string source = straightLineProgram(nLines);
+    vector<string> lines;
+    size_t start = 0;
+    while (start < source.length()) {
+        size_t end = source.find('\n', start);
+        if (end == string::npos) end = source.length();
+        lines.push_back(source.substr(start, end - start));
+        start = end + 1;
+    }
+    chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+    long scannerTokens = 0;
+    TokenScanner scanner;
+    scanner.ignoreWhitespace();
+    scanner.scanNumbers();
+    for (size_t i = 0; i < lines.size(); i++) {
+        scanner.setInput(lines[i]);
+        while (scanner.hasMoreTokens()) {
+            scanner.nextToken();
+            scannerTokens++;
+        }
+    }
+    double scannerTime = secondsSince(begin);
+    begin = chrono::steady_clock::now();
+    long lexerTokens = 0;
+    Lexer lexer;
+    for (size_t i = 0; i < lines.size(); i++) {
+        lexer.setInput(lines[i]);
+        while (lexer.hasMoreTokens()) {
+            lexer.nextToken();
+            lexerTokens++;
+        }
+    }
+    double lexerTime = secondsSince(begin);
+    cout << "{\"benchmark\":\"lex\""
+         << ",\"lines\":" << lines.size()
+         << ",\"tokens\":" << lexerTokens
+         << ",\"scanner_lines_per_second\":" << lines.size() / scannerTime
+         << ",\"lexer_lines_per_second\":" << lines.size() / lexerTime
+         << ",\"speedup\":" << scannerTime / lexerTime
+         << ",\"results_agree\":" << (scannerTokens == lexerTokens ? "true" : "false")
+         << ",\"peak_rss_kb\":" << getPeakRSS()
+         << "}" << endl;
+}
+
+/*
+ * Function: benchmarkStrlib
+ * Usage: benchmarkStrlib(nValues);
+ * --------------------------------
+ * Measures the numeric conversions in strlib.h against the string
+ * streams they were once written with.  Each conversion is applied to
+ * the same nValues numbers or strings both ways, and one row is written
+ * for each function with the nanoseconds per call and whether the two
+ * ways gave the same results.
+ */
+
+void benchmarkStrlib(int nValues) {
+    vector<int> integers;
+    vector<double> reals;
+    vector<string> integerText;
+    vector<string> realText;
+    unsigned seed = 12345;
+    for (int i = 0; i < nValues; i++) {
+        seed = seed * 1103515245 + 12345;
+        integers.push_back((int) seed >> (seed % 24));
+        reals.push_back(integers.back() / 64.0);
+        integerText.push_back(integerToString(integers.back()));
+        realText.push_back(realToString(reals.back()));
+    }
+    bool agree = true;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < nValues; i++) {
+        istringstream stream(integerText[i]);
+        int value;
+        stream >> value;
+        if (stream.fail() || value != integers[i]) agree = false;
+    }
+    double streamTime = secondsSince(start);
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < nValues; i++) {
+        if (stringToInteger(integerText[i]) != integers[i]) agree = false;
+    }
+    reportConversion("stringToInteger", nValues, streamTime, secondsSince(start), agree);
+    agree = true;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < nValues; i++) {
+        istringstream stream(realText[i]);
+        double value;
+        stream >> value;
+        if (stream.fail()) agree = false;
+    }
+    streamTime = secondsSince(start);
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < nValues; i++) {
+        if (!stringIsReal(realText[i])) agree = false;
+    }
+    reportConversion("stringIsReal", nValues, streamTime, secondsSince(start), agree);
+    agree = true;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < nValues; i++) {
+        ostringstream stream;
+        stream << integers[i];
+        if (stream.str() != integerText[i]) agree = false;
+    }
+    streamTime = secondsSince(start);
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < nValues; i++) {
+        if (integerToString(integers[i]) != integerText[i]) agree = false;
+    }
+    reportConversion("integerToString", nValues, streamTime, secondsSince(start), agree);
+    agree = true;
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < nValues; i++) {
+        ostringstream stream;
+        stream << uppercase << reals[i];
+        if (stream.str() != realText[i]) agree = false;
+    }
+    streamTime = secondsSince(start);
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < nValues; i++) {
+        if (realToString(reals[i]) != realText[i]) agree = false;
+    }
+    reportConversion("realToString", nValues, streamTime, secondsSince(start), agree);
+}
+
+void reportConversion(string function, int calls, double streamTime,
+                      double strlibTime, bool agree) {
+    cout << "{\"benchmark\":\"strlib\""
+         << ",\"function\":\"" << function << "\""
+         << ",\"calls\":" << calls
+         << ",\"stream_ns_per_call\":" << 1e9 * streamTime / calls
+         << ",\"strlib_ns_per_call\":" << 1e9 * strlibTime / calls
+         << ",\"speedup\":" << streamTime / strlibTime
+         << ",\"results_agree\":" << (agree ? "true" : "false")
+         << "}" << endl;
+}
+
+/*
+ * Function: benchmarkChurn
+ * Usage: benchmarkChurn(nLines, rounds);
+ * --------------------------------------
+ * Edits a program the way a user at the console does, over and over:
+ * each round loads a generated program, enters every line a second
+ * time so that it replaces the first, deletes every other line, and
+ * then clears the program.  The resident set size is reported after
+ * the first round and after the last, and the two should be the same,
+ * because the statements of each round are freed along with the lines
+ * that own them.
+ */
+
+void benchmarkChurn(int nLines, int rounds) {
+    string source = straightLineProgram(nLines);
+    Program program;
+    EvalState state;
+    long firstRoundKB = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (int pass = 0; pass < 2; pass++) {
+            istringstream in(source);
+            loadProgram(in, program, state);
+        }
+        int lineNumber = program.getFirstLineNumber();
+        while (lineNumber != -1) {
+            int next = program.getNextLineNumber(lineNumber);
+            program.removeSourceLine(lineNumber);
+            lineNumber = (next == -1) ? -1 : program.getNextLineNumber(next);
+        }
+        program.clear();
+        if (round == 0) firstRoundKB = getCurrentRSS();
+    }
+    double seconds = secondsSince(start);
+    long lastRoundKB = getCurrentRSS();
+    cout << "{\"benchmark\":\"churn\""
+         << ",\"lines\":" << nLines
+         << ",\"rounds\":" << rounds
+         << ",\"seconds\":" << seconds
+         << ",\"lines_per_second\":" << 2.0 * nLines * rounds / seconds
+         << ",\"first_round_rss_kb\":" << firstRoundKB
+         << ",\"last_round_rss_kb\":" << lastRoundKB
+         << ",\"rss_growth_kb\":" << lastRoundKB - firstRoundKB
+         << ",\"peak_rss_kb\":" << getPeakRSS()
+         << "}" << endl;
+}
+
+/*
+ * Function: benchmarkRelink
+ * Usage: benchmarkRelink(nLines, edits);
+ * --------------------------------------
+ * Measures what RUN costs after a single line is edited.  A generated
+ * program is linked and compiled once, and then, for each edit, one
+ * line is retyped and the program is linked and compiled again.  The
+ * edits alternate between the target of the program's only jump and a
+ * line in the middle.  Linking should take the same time whatever the
+ * size of the program; compiling still copies every line's code into
+ * place, but compiles only the edited line.
+ */
+
+void benchmarkRelink(int nLines, int edits) {
+    Program program;
+    EvalState state;
+    loadSource(straightLineProgram(nLines), program, state);
+    Bytecode code;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    code.compile(program);
+    double firstTime = secondsSince(start);
+    string target = "40 LET A = A + B * 0 - B / 3\n";
+    string middle = integerToString(40 + 10 * (nLines / 2)) + " LET B = A - B + 1\n";
+    double linkTime = 0;
+    double compileTime = 0;
+    for (int i = 0; i < edits; i++) {
+        loadSource((i % 2 == 0) ? target : middle, program, state);
+        start = chrono::steady_clock::now();
+        program.link();
+        linkTime += secondsSince(start);
+        start = chrono::steady_clock::now();
+        code.compile(program);
+        compileTime += secondsSince(start);
+    }
+    cout << "{\"benchmark\":\"relink\""
+         << ",\"lines\":" << nLines
+         << ",\"edits\":" << edits
+         << ",\"first_compile_seconds\":" << firstTime
+         << ",\"link_ns_per_edit\":" << 1e9 * linkTime / edits
+         << ",\"compile_ns_per_edit\":" << 1e9 * compileTime / edits
+         << "}" << endl;
+}
+
+/*
+ * Function: benchmarkCache
+ * Usage: benchmarkCache(nLines);
+ * ------------------------------
+ * Compares the two ways a program can start with --cache: parsing and
+ * compiling the source and writing the cache file, and loading the
+ * compiled program from that file.  Both are then run, and their output
+ * is compared.  The cache file is written to the current directory and
+ * removed afterwards.
+ */
+
+void benchmarkCache(int nLines) {
+    const string filename = "bench.cache";
+    string source = straightLineProgram(nLines);
+    unsigned long long hash = CodeCache::hashSource(source);
+    HashBuffer output;
+    ostream outputStream(&output);
+    Program program;
+    EvalState compiledState;
+    compiledState.getOutput().setStream(outputStream);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    loadSource(source, program, compiledState);
+    Bytecode code;
+    code.compile(program);
+    bool saved = CodeCache::save(filename, hash, code, compiledState,
+                                 program.getEliminatedNodes());
+    double compileTime = secondsSince(start);
+    executeBytecode(code, compiledState);
+    compiledState.getOutput().flush();
+    unsigned expected = output.getHash();
+    EvalState cachedState;
+    cachedState.getOutput().setStream(outputStream);
+    CodeCache cache;
+    start = chrono::steady_clock::now();
+    bool loaded = saved && cache.load(filename, hash, cachedState);
+    double loadTime = secondsSince(start);
+    output.reset();
+    if (loaded) {
+        executeBytecode(cache.getBytecode(), cachedState);
+        cachedState.getOutput().flush();
+    }
+    remove(filename.c_str());
+    cout << "{\"benchmark\":\"cache\""
+         << ",\"lines\":" << nLines
+         << ",\"words\":" << code.size()
+         << ",\"compile_seconds\":" << compileTime
+         << ",\"load_seconds\":" << loadTime
+         << ",\"speedup\":" << compileTime / loadTime
+         << ",\"mapped\":" << (cache.isMapped() ? "true" : "false")
+         << ",\"results_agree\":" << (loaded && output.getHash() == expected ? "true" : "false")
+         << ",\"peak_rss_kb\":" << getPeakRSS()
+         << "}" << endl;
+}
+
+/*
+ * Function: benchmarkProgram
+ * Usage: benchmarkProgram(name, source, iterations);
+ * --------------------------------------------------
+ * Runs the program the specified number of times on each engine and
+ * prints one line for each.  The number of statements in a run is
+ * counted once beforehand by the profiler, so the timed runs carry no
+ * instrumentation.  The output of each engine is compared with that of
+ * the tree walker, and a benchmark in which they differ is reported as
+ * such.
+ */
+
+void benchmarkProgram(string name, string source, int iterations) {
+    static const char *const ENGINES[] = { "tree", "vm", "jit" };
+    HashBuffer output;
+    ostream outputStream(&output);
+    Program program;
+    EvalState state;
+    state.getOutput().setStream(outputStream);
+    loadSource(source, program, state);
+    Bytecode code;
+    code.compile(program);
+    Profiler profiler;
+    executeBytecode(code, state, profiler);
+    state.getOutput().flush();
+    long long statements = profiler.getTotalCount() * iterations;
+    unsigned expected = 0;
+    for (int i = 0; i < 3; i++) {
+        output.reset();
+        double seconds = runEngine(ENGINES[i], program, state, iterations);
+        if (i == 0) expected = output.getHash();
+        cout << "{\"benchmark\":\"" << name << "\""
+             << ",\"engine\":\"" << ENGINES[i] << "\""
+             << ",\"iterations\":" << iterations
+             << ",\"statements\":" << statements
+             << ",\"seconds\":" << seconds
+             << ",\"statements_per_second\":" << statements / seconds
+             << ",\"ns_per_statement\":" << 1e9 * seconds / statements
+             << ",\"results_agree\":" << (output.getHash() == expected ? "true" : "false")
+             << ",\"peak_rss_kb\":" << getPeakRSS()
+             << "}" << endl;
+    }
+    state.getOutput().setStream(cout);
+}
+
+/*
+ * Function: benchmarkKernels
+ * Usage: benchmarkKernels(size, rounds);
+ * --------------------------------------
+ * Multiplies two square matrices of the given size rounds times with
+ * the plain-loop kernels and again with the kernels that MAT uses on
+ * this processor, and reports the time per product for each, together
+ * with whether the two gave the same result.
+ */
+
+void benchmarkKernels(int size, int rounds) {
+    int n = size * size;
+    vector<int> a(n), b(n), scalarResult(n), result(n);
+    unsigned seed = 12345;
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1103515245 + 12345;
+        a[i] = (int) (seed >> 16) % 1000;
+        seed = seed * 1103515245 + 12345;
+        b[i] = (int) (seed >> 16) % 1000;
+    }
+    const MatrixKernels & scalar = getScalarKernels();
+    const MatrixKernels & kernels = getMatrixKernels();
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        scalar.multiply(&a[0], &b[0], &scalarResult[0], size, size, size);
+    }
+    double scalarTime = secondsSince(start);
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        kernels.multiply(&a[0], &b[0], &result[0], size, size, size);
+    }
+    double kernelTime = secondsSince(start);
+    cout << "{\"benchmark\":\"matrix-kernels\""
+         << ",\"kernels\":\"" << kernels.name << "\""
+         << ",\"size\":" << size
+         << ",\"rounds\":" << rounds
+         << ",\"scalar_ms_per_product\":" << 1e3 * scalarTime / rounds
+         << ",\"kernel_ms_per_product\":" << 1e3 * kernelTime / rounds
+         << ",\"speedup\":" << scalarTime / kernelTime
+         << ",\"results_agree\":" << (result == scalarResult ? "true" : "false")
+         << "}" << endl;
+}
+
+/*
+ * Function: benchmarkBatch
+ * Usage: benchmarkBatch(nPrograms);
+ * ---------------------------------
+ * Runs a batch of small programs of uneven length through runPrograms,
+ * first on a single thread and then on one thread per core, and checks
+ * that both runs produce the same output for every program.
+ */
+
+void benchmarkBatch(int nPrograms) {
+    vector<string> sources;
+    vector<string> inputs;
+    for (int i = 0; i < nPrograms; i++) {
+        sources.push_back(countingProgram(i));
+        inputs.push_back(integerToString(i % 13) + "\n");
+    }
+    ThreadPool single(1);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<ProgramResult> expected = runPrograms(single, sources, inputs);
+    double serialTime = secondsSince(start);
+    ThreadPool pool;
+    start = chrono::steady_clock::now();
+    vector<ProgramResult> results = runPrograms(pool, sources, inputs);
+    double parallelTime = secondsSince(start);
+    bool agree = true;
+    for (int i = 0; i < nPrograms; i++) {
+        if (results[i].output != expected[i].output || results[i].error != ""
+                                                    || expected[i].error != "") {
+            agree = false;
+        }
+    }
+    cout << "{\"benchmark\":\"batch\""
+         << ",\"programs\":" << nPrograms
+         << ",\"threads\":" << pool.getThreadCount()
+         << ",\"serial_seconds\":" << serialTime
+         << ",\"parallel_seconds\":" << parallelTime
+         << ",\"programs_per_second\":" << nPrograms / parallelTime
+         << ",\"speedup\":" << serialTime / parallelTime
+         << ",\"results_agree\":" << (agree ? "true" : "false")
+         << ",\"peak_rss_kb\":" << getPeakRSS()
+         << "}" << endl;
+}
+
+/*
+ * Function: benchmarkScheduler
+ * Usage: benchmarkScheduler(nPrograms, quantum);
+ * ----------------------------------------------
+ * Runs a set of programs of uneven length one after another on the
+ * virtual machine, and then all at once on a single thread under a
+ * Scheduler with the specified quantum.  The difference between the
+ * two times is the cost of time-slicing.  Each program starts with an
+ * INPUT statement, which the benchmark answers when the program blocks.
+ */
+
+void benchmarkScheduler(int nPrograms, int quantum) {
+    vector<string> expected(nPrograms);
+    double serialTime = 0;
+    for (int i = 0; i < nPrograms; i++) {
+        ostringstream output;
+        istringstream input(integerToString(i % 13));
+        istringstream source(countingProgram(i));
+        Program program;
+        EvalState state;
+        state.getOutput().setStream(output);
+        state.setInputStream(&input);
+        loadProgram(source, program, state);
+        Bytecode code;
+        code.compile(program);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        executeBytecode(code, state);
+        state.getOutput().flush();
+        serialTime += secondsSince(start);
+        expected[i] = output.str();
+    }
+    vector<ostringstream *> outputs;
+    vector<Program *> programs;
+    vector<EvalState *> states;
+    vector<Interpreter *> interps;
+    Scheduler scheduler(quantum);
+    for (int i = 0; i < nPrograms; i++) {
+        istringstream source(countingProgram(i));
+        outputs.push_back(new ostringstream);
+        programs.push_back(new Program);
+        states.push_back(new EvalState);
+        states[i]->getOutput().setStream(*outputs[i]);
+        loadProgram(source, *programs[i], *states[i]);
+        interps.push_back(new Interpreter(*programs[i], *states[i]));
+        scheduler.add(*interps[i]);
+    }
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    long long rounds = 0;
+    while (true) {
+        bool more = scheduler.runOnce();
+        rounds++;
+        for (int i = 0; i < nPrograms; i++) {
+            if (scheduler.getStatus(i) == STEP_BLOCKED) {
+                scheduler.provideInput(i, i % 13);
+                more = true;
+            }
+        }
+        if (!more) break;
+    }
+    double scheduledTime = secondsSince(start);
+    long long statements = 0;
+    bool agree = true;
+    for (int i = 0; i < nPrograms; i++) {
+        statements += interps[i]->getStatementCount();
+        if (outputs[i]->str() != expected[i] || scheduler.getError(i) != "") agree = false;
+        delete interps[i];
+        delete states[i];
+        delete programs[i];
+        delete outputs[i];
+    }
+    cout << "{\"benchmark\":\"scheduler\""
+         << ",\"programs\":" << nPrograms
+         << ",\"quantum\":" << quantum
+         << ",\"rounds\":" << rounds
+         << ",\"statements\":" << statements
+         << ",\"serial_seconds\":" << serialTime
+         << ",\"scheduled_seconds\":" << scheduledTime
+         << ",\"ns_per_statement\":" << 1e9 * scheduledTime / statements
+         << ",\"overhead\":" << scheduledTime / serialTime - 1
+         << ",\"results_agree\":" << (agree ? "true" : "false")
+         << ",\"peak_rss_kb\":" << getPeakRSS()
+         << "}" << endl;
+}
+
+/*
+ * Function: countingProgram
+ * Usage: string source = countingProgram(index);
+ * ----------------------------------------------
+ * Returns the program used by the batch and scheduler benchmarks.  It
+ * reads a multiplier and sums a loop whose length depends on index, so
+ * that the programs in a set run for very different times.
+ */
+
+string countingProgram(int index) {
+    int limit = 1000 + (index * 7919) % 20000;
+    return "10 INPUT N\n20 LET S = 0\n30 LET I = 0\n"
+           "40 LET S = S + I * N\n50 LET I = I + 1\n"
+           "60 IF I < " + integerToString(limit) + " THEN 40\n"
+           "70 PRINT S\n";
+}
+
+/*
+ * Function: runEngine
+ * Usage: double seconds = runEngine(engine, program, state, iterations);
+ * ----------------------------------------------------------------------
+ * Runs the program repeatedly on the named engine and returns the total
+ * time.  Compiling to bytecode or native code happens once, before the
+ * clock starts, and the variables are cleared before every run.  When
+ * no native code can be generated, the "jit" engine falls back to the
+ * virtual machine, just as RUN JIT does.
+ */
+
+double runEngine(string engine, Program & program, EvalState & state, int iterations) {
+    Bytecode code;
+    JitCode jit;
+    if (engine != "tree") code.compile(program);
+    if (engine == "jit") jit.compile(code);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        state.clearVariableList();
+        if (engine == "tree") {
+            program.restoreData(state);
+            Statement *stmt = program.getFirstStatement();
+            while (stmt != NULL) {
+                state.setNextStatement(stmt->getNext());
+                stmt->execute(state);
+                stmt = state.getNextStatement();
+            }
+        } else if (engine == "vm") {
+            executeBytecode(code, state);
+        } else {
+            executeJit(jit, state);
+        }
+        state.getOutput().flush();
+    }
+    return secondsSince(start);
+}
+
+/*
+ * Function: manyVariablesProgram
+ * Usage: string source = manyVariablesProgram(nVariables);
+ * --------------------------------------------------------
+ * Returns a program whose loop updates each of nVariables variables
+ * from its neighbor, which spreads the work across many slots.
+ */
+
+string manyVariablesProgram(int nVariables) {
+    ostringstream out;
+    int lineNumber = 10;
+    for (int i = 0; i < nVariables; i++) {
+        out << lineNumber << " LET V" << i << " = " << i << "\n";
+        lineNumber += 10;
+    }
+    out << lineNumber << " LET N = 0\n";
+    lineNumber += 10;
+    int loop = lineNumber;
+    for (int i = 0; i < nVariables; i++) {
+        int j = (i + 1) % nVariables;
+        out << lineNumber << " LET V" << i << " = V" << j << " - V" << i << " / 2\n";
+        lineNumber += 10;
+    }
+    out << lineNumber << " LET N = N + 1\n";
+    out << lineNumber + 10 << " IF N < 200 THEN " << loop << "\n";
+    out << lineNumber + 20 << " PRINT V0\n";
+    return out.str();
+}
+
+/*
+ * Function: straightLineProgram
+ * Usage: string source = straightLineProgram(nLines);
+ * ---------------------------------------------------
+ * Returns a program consisting of a block of nLines LET statements with
+ * no jumps among them, which a loop at the end runs twenty times.
+ */
+
+string straightLineProgram(int nLines) {
+    ostringstream out;
+    out << "10 LET A = 1\n20 LET B = 2\n30 LET N = 0\n";
+    int lineNumber = 40;
+    for (int i = 0; i < nLines; i++) {
+        if (i % 2 == 0) {
+            out << lineNumber << " LET A = A + B * " << i % 7 << " - B / 3\n";
+        } else {
+            out << lineNumber << " LET B = A - B + " << i % 5 << "\n";
+        }
+        lineNumber += 10;
+    }
+    out << lineNumber << " LET N = N + 1\n";
+    out << lineNumber + 10 << " IF N < 20 THEN 40\n";
+    out << lineNumber + 20 << " PRINT A\n";
+    return out.str();
+}
+
+/*
+ * Function: readFile
+ * Usage: string source = readFile(filename);
+ * ------------------------------------------
+ * Returns the contents of the file, exiting with a message if it
+ * cannot be opened.
+ */
+
+string readFile(string filename) {
+    ifstream infile(filename.c_str());
+    if (infile.fail()) {
+        cerr << "bench: can't open " << filename << endl;
+        exit(1);
+    }
+    ostringstream contents;
+    contents << infile.rdbuf();
+    return contents.str();
+}
+
+/*
+ * Function: loadSource
+ * Usage: loadSource(source, program, state);
+ * ------------------------------------------
+ * Parses each nonblank line of source, which must begin with a line
+ * number, and stores it in the program, optimizing it on the way just
+ * as the interpreter does.  The lexer reads each line where it lies in
+ * the source, so a line is copied only when it is stored.
+ */
+
+void loadSource(string source, Program & program, EvalState & state) {
+    Lexer lexer;
+    size_t start = 0;
+    while (start < source.length()) {
+        size_t end = source.find('\n', start);
+        if (end == string::npos) end = source.length();
+        lexer.setInput(source.data() + start, end - start);
+        if (lexer.hasMoreTokens()) {
+            int lineNumber = lexer.getInteger(lexer.nextToken());
+            Arena arena;
+            Statement *stmt = parseStatement(lexer, arena);
+            optimizeStatement(stmt, arena);
+            resolveSymbols(stmt, state);
+            program.addSourceLine(lineNumber, source.substr(start, end - start));
+            program.setParsedStatement(lineNumber, stmt, arena);
+        }
+        start = end + 1;
+    }
+}
+
+/*
+ * Function: getPeakRSS
+ * Usage: long kb = getPeakRSS();
+ * ------------------------------
+ * Returns the largest resident set size the process has reached so
+ * far, in kilobytes, or -1 if the system does not report it.
+ */
+
+long getPeakRSS() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof counters)) return -1;
+    return counters.PeakWorkingSetSize / 1024;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+#  ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#  else
+    return usage.ru_maxrss;
+#  endif
+#endif
+}
+
+/*
+ * Function: getCurrentRSS
+ * Usage: long kb = getCurrentRSS();
+ * ---------------------------------
+ * Returns the resident set size of the process right now, in
+ * kilobytes, or -1 if the system does not report it.
+ */
+
+long getCurrentRSS() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof counters)) return -1;
+    return counters.WorkingSetSize / 1024;
+#elif defined(__linux__)
+    ifstream statm("/proc/self/statm");
+    long pages, residentPages;
+    if (!(statm >> pages >> residentPages)) return -1;
+    return residentPages * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+    return -1;
+#endif
+}
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
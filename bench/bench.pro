@@ -0,0 +1,44 @@
+# Benchmarks for the BASIC interpreter
+#
+# This project builds a command-line benchmark driver from the
+# interpreter sources in ../src (all but Basic.cpp, which holds the
+# interactive main program) and the Stanford C++ library.  The driver
+# does not include console.h, so it runs without the Java back-end.
+
+TEMPLATE = app
+CONFIG += console no_include_pwd
+CONFIG -= qt app_bundle
+TARGET = bench
+
+ROOT = $$PWD/..
+
+SOURCES += $$ROOT/lib/StanfordCPPLib/*.cpp
+SOURCES += $$ROOT/lib/StanfordCPPLib/stacktrace/*.cpp
+SOURCES += $$files($$ROOT/src/*.cpp)
+SOURCES -= $$ROOT/src/Basic.cpp
+SOURCES += $$PWD/*.cpp
+
+HEADERS += $$ROOT/lib/StanfordCPPLib/*.h
+HEADERS += $$ROOT/src/*.h
+HEADERS += $$PWD/*.h
+
+INCLUDEPATH += $$ROOT/lib/StanfordCPPLib/
+INCLUDEPATH += $$ROOT/lib/StanfordCPPLib/private/
+INCLUDEPATH += $$ROOT/lib/StanfordCPPLib/stacktrace/
+INCLUDEPATH += $$ROOT/src/
+
+QMAKE_CXXFLAGS += -std=c++11 -O2
+QMAKE_CXXFLAGS_WARN_ON += -Wall -Wextra -Wno-sign-compare -Wno-unused-parameter
+
+!win32 {
+    LIBS += -ldl
+    QMAKE_CXXFLAGS += -pthread
+    QMAKE_LFLAGS += -pthread
+}
+win32 {
+    LIBS += -lpsapi
+}
+
+DEFINES += BENCH_PROGRAMS=\\\"$$PWD/programs\\\"
+
+DEFINES += SPL_PROJECT_VERSION=20141113
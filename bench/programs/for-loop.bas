@@ -0,0 +1,7 @@
+10 LET X = 0
+20 FOR I = 0 TO 999
+30 FOR J = 0 TO 999
+40 LET X = X + (I * J - (I - J)) / 1000
+50 NEXT J
+60 NEXT I
+70 PRINT X
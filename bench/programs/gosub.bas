@@ -0,0 +1,9 @@
+10 LET X = 0
+20 LET I = 0
+30 GOSUB 100
+40 LET I = I + 1
+50 IF I < 1000000 THEN 30
+60 PRINT X
+70 END
+100 LET X = X + I / 1000
+110 RETURN
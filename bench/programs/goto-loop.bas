@@ -0,0 +1,5 @@
+10 LET I = 0
+20 LET I = I + 1
+30 IF I > 999999 THEN 50
+40 GOTO 20
+50 PRINT I
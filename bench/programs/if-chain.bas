@@ -0,0 +1,54 @@
+10 LET I = 0
+20 LET S = 0
+30 LET K = I - I / 16 * 16
+40 IF K = 0 THEN 200
+50 IF K = 1 THEN 220
+60 IF K = 2 THEN 240
+70 IF K = 3 THEN 260
+80 IF K = 4 THEN 280
+90 IF K = 5 THEN 300
+100 IF K = 6 THEN 320
+110 IF K = 7 THEN 340
+120 IF K = 8 THEN 360
+130 IF K = 9 THEN 380
+140 IF K = 10 THEN 400
+150 IF K = 11 THEN 420
+160 IF K = 12 THEN 440
+170 IF K = 13 THEN 460
+180 IF K = 14 THEN 480
+190 IF K = 15 THEN 500
+200 LET S = S + 1
+210 GOTO 600
+220 LET S = S + 2
+230 GOTO 600
+240 LET S = S + 3
+250 GOTO 600
+260 LET S = S + 4
+270 GOTO 600
+280 LET S = S + 5
+290 GOTO 600
+300 LET S = S + 6
+310 GOTO 600
+320 LET S = S + 7
+330 GOTO 600
+340 LET S = S + 8
+350 GOTO 600
+360 LET S = S + 9
+370 GOTO 600
+380 LET S = S + 10
+390 GOTO 600
+400 LET S = S + 11
+410 GOTO 600
+420 LET S = S + 12
+430 GOTO 600
+440 LET S = S + 13
+450 GOTO 600
+460 LET S = S + 14
+470 GOTO 600
+480 LET S = S + 15
+490 GOTO 600
+500 LET S = S + 16
+510 GOTO 600
+600 LET I = I + 1
+610 IF I < 300000 THEN 30
+620 PRINT S
@@ -0,0 +1,15 @@
+10 DIM A(99, 99)
+20 DIM B(99, 99)
+30 DIM C(99, 99)
+40 FOR I = 0 TO 99
+50 FOR J = 0 TO 99
+60 LET A(I, J) = I + J
+70 LET B(I, J) = I - J * 2
+80 NEXT J
+90 NEXT I
+100 FOR K = 1 TO 50
+110 MAT C = A * B
+120 NEXT K
+130 PRINT C(0, 0)
+140 PRINT C(99, 99)
+150 END
@@ -0,0 +1,9 @@
+10 LET X = 0
+20 LET I = 0
+30 LET J = 0
+40 LET X = X + (I * J - (I - J)) / 1000
+50 LET J = J + 1
+60 IF J < 1000 THEN 40
+70 LET I = I + 1
+80 IF I < 1000 THEN 30
+90 PRINT X
@@ -0,0 +1,5 @@
+10 LET I = 0
+20 PRINT I
+30 PRINT I * 3 - 7
+40 LET I = I + 1
+50 IF I < 200000 THEN 20
@@ -0,0 +1,14 @@
+10 DIM P(1000000)
+20 LET C = 0
+30 FOR I = 2 TO 1000
+40 IF P(I) = 1 THEN 80
+50 FOR J = I * I TO 1000000 STEP I
+60 LET P(J) = 1
+70 NEXT J
+80 NEXT I
+90 FOR I = 2 TO 1000000
+100 IF P(I) = 1 THEN 120
+110 LET C = C + 1
+120 NEXT I
+130 PRINT C
+140 END
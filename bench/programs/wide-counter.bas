@@ -0,0 +1,10 @@
+10 LET T% = 0
+20 LET R# = 0
+30 FOR I = 0 TO 999
+40 FOR J = 0 TO 999
+50 LET T% = T% + I * J + 3000000000
+60 LET R# = R# + J / 1000.0
+70 NEXT J
+80 NEXT I
+90 PRINT T%
+100 PRINT R#
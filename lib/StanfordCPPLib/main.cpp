@@ -4,8 +4,12 @@
  * This file defines a default version of the Main function that takes
  * the argc and argv arguments.  This function must be defined in its
  * own module to ensure that it is loaded only if the client doesn't
- * supply one.
+ * supply one.  Because qmake projects link the library's object files
+ * directly rather than through an archive, the default is marked weak
+ * under GCC so that a client definition of main(argc, argv) replaces it.
  * 
+ * @version 2026/10/17
+ * - made the default Main weak so that clients can receive argc and argv
  * @version 2014/10/22
  * - made it work when console.h is not included (uses plain text console)
  * @version 2014/10/08
@@ -20,14 +24,20 @@ namespace exceptions {
 extern void setProgramNameForStackTrace(char* programName);
 }
 
-int Main(int, char* argv[]) {
+#ifdef __GNUC__
+#  define SPL_WEAK __attribute__((weak))
+#else
+#  define SPL_WEAK
+#endif
+
+SPL_WEAK int Main(int, char* argv[]) {
     exceptions::setProgramNameForStackTrace(argv[0]);
 
 //    // this pops up the graphical console, if it is being used
 //    std::cout << "";
 //    std::cout.flush();
 
-    extern int Main();
+    extern int Main() SPL_WEAK;
     return Main();
 }
 #endif // SPL_AUTOGRADER_MODE
@@ -4,6 +4,9 @@
  * This file implements the platform interface by passing commands to
  * a Java back end that manages the display.
  * 
+ * @version 2026/10/17
+ * - added headless mode that leaves cin/cout on the real file descriptors
+ *   and never launches the Java back end
  * @version 2014/11/14
  * - added method to set unit test runtime in MS
  * @version 2014/11/05
@@ -261,6 +264,7 @@ static pid_t javaBackEndPid;
 
 /* Prototypes */
 
+static bool isHeadless(int& argc, char** argv);
 static void initPipe();
 static void putPipe(std::string line);
 static void putPipeLongString(std::string line);
@@ -1680,6 +1684,47 @@ static void putPipeLongString(std::string line) {
     putPipe("LongCommand.end()");
 }
 
+/*
+ * Implementation notes: isHeadless
+ * --------------------------------
+ * In headless mode startupMain calls Main directly: the Java back end
+ * is never launched and cin, cout, and cerr stay bound to the process's
+ * own file descriptors.  The mode is selected by compiling with
+ * SPL_HEADLESS defined, by setting the environment variable SPL_HEADLESS
+ * (or the older NOCONSOLE) to a value that begins with t, y, or 1, or by
+ * passing --headless on the command line.  The flag is removed from argv
+ * so that Main never sees it.  Because nothing else writes through the C
+ * stdio buffers, the C++ streams are also unsynchronized from them.
+ */
+static bool isHeadlessFlag(const char* value) {
+    if (value == NULL) return false;
+    char ch = tolower(value[0]);
+    return ch == 't' || ch == 'y' || ch == '1';
+}
+
+static bool isHeadless(int& argc, char** argv) {
+#ifdef SPL_HEADLESS
+    bool headless = true;
+#else
+    bool headless = isHeadlessFlag(getenv("SPL_HEADLESS"))
+            || isHeadlessFlag(getenv("NOCONSOLE"));
+#endif
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--headless") {
+            for (int j = i; j < argc; j++) {
+                argv[j] = argv[j + 1];
+            }
+            argc--;
+            headless = true;
+            break;
+        }
+    }
+    if (headless) {
+        std::ios::sync_with_stdio(false);
+    }
+    return headless;
+}
+
 #ifdef _WIN32
 
 /* Windows implementation of interface to Java back end */
@@ -1714,6 +1759,14 @@ static WINBOOL WinCheck(WINBOOL result) {
 
 int startupMain(int argc, char **argv) {
     extern int Main(int argc, char **argv);
+    if (isHeadless(argc, argv)) {
+        programName = getRoot(getTail(std::string(argv[0])));
+#ifndef SPL_AUTOGRADER_MODE
+        return Main(argc, argv);
+#else
+        return 0;
+#endif // SPL_AUTOGRADER_MODE
+    }
     startupMainDontRunMain(argc, argv);
 
 #ifndef SPL_AUTOGRADER_MODE
@@ -1882,10 +1935,8 @@ static std::string getOption(std::string key) {
     return optionTable.get(key);
 }
 
-#ifdef SPL_AUTOGRADER_MODE
-int startupMain(int /*argc*/, char** argv) {
-#else
 int startupMain(int argc, char **argv) {
+#ifndef SPL_AUTOGRADER_MODE
     extern int Main(int argc, char **argv);
 #endif
     std::string arg0 = argv[0];
@@ -1900,8 +1951,7 @@ int startupMain(int argc, char **argv) {
             chdir(cwd.c_str());
         }
     }
-    char *noConsoleFlag = getenv("NOCONSOLE");
-    if (noConsoleFlag != NULL && startsWith(std::string(noConsoleFlag), "t")) {
+    if (isHeadless(argc, argv)) {
 #ifdef SPL_AUTOGRADER_MODE
         return 0;
 #else
@@ -3,6 +3,9 @@
  * ----------------
  * This file implements the simpio.h interface.
  * 
+ * @version 2026/10/17
+ * - getInteger and getReal parse with strlib rather than string streams
+ * - getYesOrNo stops at the end of the input rather than reprompting
  * @version 2014/10/19
  * - alphabetized functions
  * - converted many funcs to take const string& rather than string for efficiency
@@ -14,8 +17,8 @@
 #include <cctype>
 #include <fstream>
 #include <iostream>
-#include <sstream>
 #include <string>
+#include "strlib.h"
 
 static const std::string GETINTEGER_DEFAULT_PROMPT = "Enter an integer: ";
 static const std::string GETINTEGER_DEFAULT_REPROMPT = "Illegal integer format. Try again.";
@@ -30,8 +33,9 @@ static void appendSpace(std::string& prompt);
  * Implementation notes: getInteger, getReal
  * -----------------------------------------
  * Each of these functions reads a complete input line and then uses the
- * <sstream> library to parse that line into a value of the desired type.
- * If that fails, the implementation asks the user for a new value.
+ * conversion functions in strlib.h to parse that line into a value of
+ * the desired type.  If that fails, the implementation asks the user
+ * for a new value.
  */
 
 int getInteger(const std::string& prompt,
@@ -43,9 +47,8 @@ int getInteger(const std::string& prompt,
         std::cout << promptCopy;
         std::string line;
         getline(std::cin, line);
-        std::istringstream stream(line);
-        stream >> value >> std::ws;
-        if (!stream.fail() && stream.eof()) {
+        if (stringIsInteger(line)) {
+            value = stringToInteger(line);
             break;
         }
         std::cout << (reprompt.empty() ? GETINTEGER_DEFAULT_REPROMPT : reprompt) << std::endl;
@@ -93,9 +96,8 @@ double getReal(const std::string& prompt,
         std::cout << promptCopy;
         std::string line;
         getline(std::cin, line);
-        std::istringstream stream(line);
-        stream >> value >> std::ws;
-        if (!stream.fail() && stream.eof()) {
+        if (stringIsReal(line)) {
+            value = stringToReal(line);
             break;
         }
         std::cout << (reprompt.empty() ? GETREAL_DEFAULT_REPROMPT : reprompt) << std::endl;
@@ -115,7 +117,9 @@ bool getYesOrNo(const std::string& prompt,
     while (true) {
         std::cout << promptCopy;
         std::string line;
-        getline(std::cin, line);
+        if (!getline(std::cin, line)) {
+            line = defaultValue.empty() ? "n" : defaultValue;
+        }
         if (line.empty()) {
             line = defaultValue;
         }
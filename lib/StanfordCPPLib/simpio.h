@@ -102,6 +102,10 @@ double getReal(const std::string& prompt = "",
  * pressing Enter will be equivalent to having typed that value.
  * This is useful where the default Y/N answer is Yes or No and you want to
  * let the user avoid typing.
+ *
+ * If the input ends before the user answers, the function returns the
+ * answer given by defaultValue, or false if there is none, rather than
+ * reprompting forever.
  */
 bool getYesOrNo(const std::string& prompt = "",
                 const std::string& reprompt = "",
@@ -3,6 +3,8 @@
  * ----------------
  * This file implements the strlib.h interface.
  * 
+ * @version 2026/10/17
+ * - numeric parsing and formatting no longer use string streams
  * @version 2014/10/31
  * - fixed infinite loop bug in stringReplace function
  * @version 2014/10/19
@@ -14,6 +16,12 @@
 
 #include "strlib.h"
 #include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
@@ -21,6 +29,13 @@
 
 /* Function prototypes */
 
+static std::string formatInteger(long long n);
+static bool scanInteger(const std::string& str, long long minValue, long long maxValue,
+                        long long& value);
+static bool scanReal(const std::string& str, double& value);
+static bool scanBool(const std::string& str, bool& value);
+static const char *skipSpace(const char *cp, const char *end);
+
 std::string boolToString(bool b) {
     return (b ? "true" : "false");
 }
@@ -68,28 +83,30 @@ bool equalsIgnoreCase(const std::string& s1, const std::string& s2) {
 /*
  * Implementation notes: numeric conversion
  * ----------------------------------------
- * These functions use the <sstream> library to perform the conversion.
+ * These functions once used the <sstream> library to perform the
+ * conversion, and they still produce and accept exactly what a string
+ * stream in the classic locale would.  Building a stream allocates
+ * memory and consults the locale on every call, however, so integers
+ * are now converted digit by digit in a local buffer, and real numbers
+ * are formatted by snprintf with the "%G" conversion that the stream
+ * used internally.
  */
 std::string doubleToString(double d) {
     return realToString(d);
 }
 
 std::string integerToString(int n) {
-    std::ostringstream stream;
-    stream << n;
-    return stream.str();
+    return formatInteger(n);
 }
 
 std::string longToString(long n) {
-    std::ostringstream stream;
-    stream << n;
-    return stream.str();
+    return formatInteger(n);
 }
 
 std::string realToString(double d) {
-    std::ostringstream stream;
-    stream << std::uppercase << d;
-    return stream.str();
+    char buffer[32];
+    int length = snprintf(buffer, sizeof buffer, "%G", d);
+    return std::string(buffer, length);
 }
 
 bool startsWith(const std::string& str, char prefix) {
@@ -114,31 +131,23 @@ bool stringIsDouble(const std::string& str) {
 }
 
 bool stringIsInteger(const std::string& str) {
-    std::istringstream stream(str);
-    int value;
-    stream >> value >> std::ws;
-    return !(stream.fail() || !stream.eof());
+    long long value;
+    return scanInteger(str, INT_MIN, INT_MAX, value);
 }
 
 bool stringIsLong(const std::string& str) {
-    std::istringstream stream(str);
-    long value;
-    stream >> value >> std::ws;
-    return !(stream.fail() || !stream.eof());
+    long long value;
+    return scanInteger(str, LONG_MIN, LONG_MAX, value);
 }
 
 bool stringIsReal(const std::string& str) {
-    std::istringstream stream(str);
     double value;
-    stream >> value >> std::ws;
-    return !(stream.fail() || !stream.eof());
+    return scanReal(str, value);
 }
 
 bool stringToBool(const std::string& str) {
-    std::istringstream stream(str);
-    bool value;
-    stream >> std::boolalpha >> value >> std::ws;
-    if (stream.fail() || !stream.eof()) {
+    bool value = false;
+    if (!scanBool(str, value)) {
         error("stringToBool: Illegal bool format (" + str + ")");
     }
     return value;
@@ -157,35 +166,145 @@ double stringToDouble(const std::string& str) {
 }
 
 int stringToInteger(const std::string& str) {
-    std::istringstream stream(str);
-    int value;
-    stream >> value >> std::ws;
-    if (stream.fail() || !stream.eof()) {
+    long long value;
+    if (!scanInteger(str, INT_MIN, INT_MAX, value)) {
         error("stringToInteger: Illegal integer format (" + str + ")");
     }
-    return value;
+    return (int) value;
 }
 
 long stringToLong(const std::string& str) {
-    std::istringstream stream(str);
-    long value;
-    stream >> value >> std::ws;
-    if (stream.fail() || !stream.eof()) {
+    long long value;
+    if (!scanInteger(str, LONG_MIN, LONG_MAX, value)) {
         error("stringToInteger: Illegal long format (" + str + ")");
     }
-    return value;
+    return (long) value;
 }
 
 double stringToReal(const std::string& str) {
-    std::istringstream stream(str);
     double value;
-    stream >> value >> std::ws;
-    if (stream.fail() || !stream.eof()) {
+    if (!scanReal(str, value)) {
         error("stringToReal: Illegal floating-point format (" + str + ")");
     }
     return value;
 }
 
+/*
+ * Implementation notes: formatInteger
+ * -----------------------------------
+ * The digits are generated from right to left into a buffer large
+ * enough for any long long.  The magnitude is computed in unsigned
+ * arithmetic so that the most negative value needs no special case.
+ */
+static std::string formatInteger(long long n) {
+    char buffer[24];
+    char *cp = buffer + sizeof buffer;
+    unsigned long long magnitude = (n < 0) ? 0 - (unsigned long long) n : n;
+    do {
+        *--cp = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (n < 0) *--cp = '-';
+    return std::string(cp, buffer + sizeof buffer - cp);
+}
+
+/*
+ * Implementation notes: scanInteger, scanReal, scanBool
+ * -----------------------------------------------------
+ * Each of these functions accepts exactly the strings that reading the
+ * value from an istringstream and then skipping whitespace to the end
+ * of the string would accept: optional leading and trailing whitespace
+ * around an optional sign and decimal digits, with a value in range.
+ * A real number may also have a fraction and an exponent, but not the
+ * infinities, NaNs and hexadecimal forms that strtod understands, so
+ * the text is checked here and passed to strtod only for the final
+ * conversion.  As with a stream, a value too large for a double is an
+ * error and one too small to represent becomes zero.
+ */
+static bool scanInteger(const std::string& str, long long minValue, long long maxValue,
+                        long long& value) {
+    const char *cp = str.data();
+    const char *end = cp + str.length();
+    cp = skipSpace(cp, end);
+    bool negative = false;
+    if (cp < end && (*cp == '+' || *cp == '-')) {
+        negative = (*cp == '-');
+        cp++;
+    }
+    unsigned long long limit = negative ? 0 - (unsigned long long) minValue : maxValue;
+    unsigned long long magnitude = 0;
+    const char *start = cp;
+    while (cp < end && isdigit((unsigned char) *cp)) {
+        unsigned digit = *cp++ - '0';
+        if (magnitude > (limit - digit) / 10) return false;
+        magnitude = 10 * magnitude + digit;
+    }
+    if (cp == start || skipSpace(cp, end) != end) return false;
+    value = negative ? (long long) (0 - magnitude) : (long long) magnitude;
+    return true;
+}
+
+static bool scanReal(const std::string& str, double& value) {
+    const char *cp = str.c_str();
+    const char *end = cp + str.length();
+    cp = skipSpace(cp, end);
+    const char *start = cp;
+    if (cp < end && (*cp == '+' || *cp == '-')) cp++;
+    int digits = 0;
+    while (cp < end && isdigit((unsigned char) *cp)) {
+        cp++;
+        digits++;
+    }
+    if (cp < end && *cp == '.') {
+        cp++;
+        while (cp < end && isdigit((unsigned char) *cp)) {
+            cp++;
+            digits++;
+        }
+    }
+    if (digits == 0) return false;
+    if (cp < end && (*cp == 'e' || *cp == 'E')) {
+        cp++;
+        if (cp < end && (*cp == '+' || *cp == '-')) cp++;
+        if (cp == end || !isdigit((unsigned char) *cp)) return false;
+        while (cp < end && isdigit((unsigned char) *cp)) {
+            cp++;
+        }
+    }
+    if (skipSpace(cp, end) != end) return false;
+    char *stop;
+    errno = 0;
+    double result = strtod(start, &stop);
+    if (stop != cp) return false;
+    if (errno == ERANGE && std::fabs(result) == HUGE_VAL) return false;
+    value = result;
+    return true;
+}
+
+static bool scanBool(const std::string& str, bool& value) {
+    const char *cp = skipSpace(str.data(), str.data() + str.length());
+    const char *end = str.data() + str.length();
+    while (end > cp && isspace((unsigned char) end[-1])) {
+        end--;
+    }
+    size_t length = end - cp;
+    if (length == 4 && memcmp(cp, "true", 4) == 0) {
+        value = true;
+    } else if (length == 5 && memcmp(cp, "false", 5) == 0) {
+        value = false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static const char *skipSpace(const char *cp, const char *end) {
+    while (cp < end && isspace((unsigned char) *cp)) {
+        cp++;
+    }
+    return cp;
+}
+
 /*
  * Implementation notes: case conversion
  * -------------------------------------
@@ -9,37 +9,66 @@
  */
 
 #include <cctype>
+#include <csignal>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <sstream>
 #include <string>
+#include "arena.h"
+#include "bytecode.h"
+#include "cache.h"
 #include "console.h"
 #include "exp.h"
+#include "interpreter.h"
+#include "jit.h"
+#include "keywords.h"
+#include "lexer.h"
+#include "loader.h"
+#include "optimizer.h"
 #include "parser.h"
+#include "profiler.h"
 #include "program.h"
-#include "tokenscanner.h"
+#include "resolver.h"
 #include "simpio.h"
 #include "strlib.h"
 #include "statement.h"
+#include "vm.h"
 using namespace std;
 
-/* Constant Variable  */
+/* Constants */
 
-const int STOP = -999;
+const int RUN_SLICE = 10000;
 
 /* Function prototypes */
 
 void processLine(string line, Program & program, EvalState & state);
+int runBatch(int argc, char **argv, Program & program, EvalState & state);
+void runBytecode(Program & program, EvalState & state);
+void runCached(istream & infile, string cacheFile, bool native,
+               Program & program, EvalState & state, int & eliminated);
+void runInterruptible(Program & program, EvalState & state);
+void runJit(Program & program, EvalState & state);
+void runProfile(Program & program, EvalState & state, ostream & os);
+void runTreeWalker(Program & program, EvalState & state);
+bool isRunMode(Lexer & lexer, Keyword mode);
 bool userEntersProgramLine(string token);
 
 /* Main program */
 
-int main() {
+int main(int argc, char **argv) {
     EvalState state;
     Program program;
+    if (argc > 1) return runBatch(argc, argv, program, state);
     cout << "Welcome to BASIC. Type HELP if you need assistance." << endl;
     while (true) {
+        string line = getLine();
+        if (cin.fail()) break;
         try {
-            processLine(getLine(), program, state);
+            processLine(line, program, state);
+            state.getOutput().flush();
         } catch (ErrorException & ex) {
+            state.getOutput().flush();
             cerr << "Error: " << ex.getMessage() << endl;
         }
     }
@@ -61,34 +90,35 @@ int main() {
 
 void processLine(string line, Program & program, EvalState & state) {
 
-    TokenScanner scanner;
-    scanner.ignoreWhitespace();
-    scanner.scanNumbers();
-    scanner.setInput(line);
-    string firstToken = toUpperCase(scanner.nextToken());
+    Lexer lexer;
+    lexer.setInput(line);
+    Token firstToken = lexer.nextToken();
+    Keyword command = lexer.getKeyword(firstToken);
     int lineNumber = 0;
     Statement *stmt = NULL;
 
-    if(stringIsReal(firstToken) && scanner.hasMoreTokens()) {
+    if(firstToken.kind == TOKEN_NUMBER && lexer.hasMoreTokens()) {
 
-        lineNumber = stringToInteger(firstToken);
-        stmt = parseStatement(scanner);
-        program.addSourceLine(lineNumber, line);
-        program.setParsedStatement(lineNumber, stmt);
+        lineNumber = lexer.getInteger(firstToken);
+        addProgramLine(lineNumber, lexer, line, program, state);
 
-    } else if (stringIsReal(firstToken) && !scanner.hasMoreTokens()){
+    } else if (firstToken.kind == TOKEN_NUMBER && !lexer.hasMoreTokens()){
 
-        lineNumber = stringToInteger(firstToken);
+        lineNumber = lexer.getInteger(firstToken);
         program.removeSourceLine(lineNumber);
 
-    } else if (((firstToken == "INPUT") || (firstToken == "PRINT") || (firstToken == "LET"))
-               && scanner.hasMoreTokens()) {
+    } else if ((command == KEYWORD_INPUT || command == KEYWORD_PRINT
+                || command == KEYWORD_LET || command == KEYWORD_DIM
+                || command == KEYWORD_MAT) && lexer.hasMoreTokens()) {
 
-        scanner.saveToken(firstToken);
-        stmt = parseStatement(scanner);
+        Arena arena;
+        lexer.unreadToken();
+        stmt = parseStatement(lexer, arena);
+        optimizeStatement(stmt, arena);
+        resolveSymbols(stmt, state);
         stmt->execute(state);
 
-    } else if (firstToken == "LIST" && !scanner.hasMoreTokens()) {
+    } else if (command == KEYWORD_LIST && !lexer.hasMoreTokens()) {
 
         lineNumber = program.getFirstLineNumber();
         while (lineNumber != -1) {
@@ -96,28 +126,37 @@ void processLine(string line, Program & program, EvalState & state) {
             lineNumber = program.getNextLineNumber(lineNumber);
         }
 
-    } else if (firstToken == "CLEAR" && !scanner.hasMoreTokens()) {
+    } else if (command == KEYWORD_CLEAR && !lexer.hasMoreTokens()) {
 
         program.clear();
         state.clearVariableList();
 
 
-    } else if (firstToken == "RUN") {
+    } else if (command == KEYWORD_RUN && !lexer.hasMoreTokens()) {
 
-        lineNumber = program.getFirstLineNumber();
-        state.setCurrentLine(lineNumber);
-        while((lineNumber == -1) || (state.getCurrentLine() != STOP)) {
-            if(lineNumber == -1) break;
-            stmt = program.getParsedStatement(state.getCurrentLine());
-            lineNumber = program.getNextLineNumber(state.getCurrentLine());
-            state.setCurrentLine(lineNumber);
-            stmt->execute(state);
-        }
+        runInterruptible(program, state);
+
+    } else if (command == KEYWORD_RUN && isRunMode(lexer, KEYWORD_TREE)) {
+
+        runTreeWalker(program, state);
+
+    } else if (command == KEYWORD_RUN && isRunMode(lexer, KEYWORD_JIT)) {
 
-    } else if (firstToken == "HELP" && !scanner.hasMoreTokens()) {
+        runJit(program, state);
+
+    } else if (command == KEYWORD_RUN && isRunMode(lexer, KEYWORD_PROFILE)) {
+
+        runProfile(program, state, cout);
+
+    } else if (command == KEYWORD_HELP && !lexer.hasMoreTokens()) {
 
         cout << "Available commands: " << endl;
         cout << "   RUN     - Runs the program" << endl;
+        cout << "   RUN TREE - Runs the program by walking the statement trees" << endl;
+        cout << "             instead of executing compiled bytecode." << endl;
+        cout << "   RUN JIT - Runs the program as native machine code" << endl;
+        cout << "   RUN PROFILE - Runs the program and then reports how many times" << endl;
+        cout << "             each line ran and how long it took." << endl;
         cout << "   LIST    - Lists the program" << endl;
         cout << "   CLEAR   - Clears the program" << endl;
         cout << "   HELP    - Prints this message" << endl;
@@ -126,6 +165,8 @@ void processLine(string line, Program & program, EvalState & state) {
         cout << "             line after the keyword REM is ignored." << endl;
         cout << "   LET     - This statement is an assignment statement. The LET keyword is" << endl;
         cout << "             followed by a variable name, an equal sign, and an expression." << endl;
+        cout << "             A name ending in % holds a 64-bit integer and one ending in #" << endl;
+        cout << "             a double; other variables hold 32-bit integers." << endl;
         cout << "   PRINT   - This statement is followed by an expression, whose value" << endl;
         cout << "             is printed to the console" << endl;
         cout << "   INPUT   - This statement is followed by a variable name and prompts" << endl;
@@ -138,9 +179,30 @@ void processLine(string line, Program & program, EvalState & state) {
         cout << "             continue from line n just as in the GOTO statement. If not, the" << endl;
         cout << "             program continues onto the next line." << endl;
         cout << "   END     - This statement marks the end of the program." << endl;
-
-
-    } else if (firstToken == "QUIT" && !scanner.hasMoreTokens()) {
+        cout << "   FOR     - This statement has the syntax FOR var = exp1 TO exp2 STEP exp3" << endl;
+        cout << "             and runs the lines up to the matching NEXT var once for each" << endl;
+        cout << "             value of var from exp1 to exp2, adding exp3 each time. The" << endl;
+        cout << "             STEP part may be left out, in which case var goes up by 1." << endl;
+        cout << "   NEXT    - This statement is followed by the variable of the FOR loop" << endl;
+        cout << "             that it closes. Loops may be nested." << endl;
+        cout << "   GOSUB   - This statement is followed by a line number and continues the" << endl;
+        cout << "             program from that line, remembering where it was called from." << endl;
+        cout << "   RETURN  - This statement continues the program from the statement after" << endl;
+        cout << "             the most recent GOSUB that has not yet returned." << endl;
+        cout << "   DIM     - This statement has the syntax DIM var(n) or DIM var(n, m) and" << endl;
+        cout << "             makes var an array with subscripts from 0 to n, or 0 to n and" << endl;
+        cout << "             0 to m, whose elements start at 0. An element is written var(i)" << endl;
+        cout << "             or var(i, j) and may be used in expressions and set by LET." << endl;
+        cout << "   MAT     - This statement works on whole arrays. MAT C = A + B, A - B and" << endl;
+        cout << "             A * B add, subtract and multiply matrices, MAT C = (k) * A" << endl;
+        cout << "             multiplies every element by k, MAT C = TRN(A) transposes A and" << endl;
+        cout << "             MAT C = A copies it. MAT READ A fills A from the DATA values" << endl;
+        cout << "             and MAT PRINT A prints A one row to a line." << endl;
+        cout << "   DATA    - This statement is followed by a list of integers separated by" << endl;
+        cout << "             commas, which MAT READ takes in order of line number." << endl;
+
+
+    } else if (command == KEYWORD_QUIT && !lexer.hasMoreTokens()) {
 
         bool userQuit = getYesOrNo("Are you sure you want to quit the program? ");
         if (userQuit) exit(0);
@@ -152,3 +214,293 @@ void processLine(string line, Program & program, EvalState & state) {
     }
 }
 
+/*
+ * Function: isRunMode
+ * Usage: if (isRunMode(lexer, mode)) . . .
+ * ----------------------------------------
+ * Returns true if the rest of the line after RUN consists of the single
+ * word mode.  The token is put back if it does not match, so that the
+ * next call can test for a different mode.
+ */
+
+bool isRunMode(Lexer & lexer, Keyword mode) {
+    Token token = lexer.nextToken();
+    if (lexer.getKeyword(token) == mode && !lexer.hasMoreTokens()) return true;
+    lexer.unreadToken();
+    return false;
+}
+
+/*
+ * Function: runBatch
+ * Usage: int status = runBatch(argc, argv, program, state);
+ * ---------------------------------------------------------
+ * Runs the interpreter non-interactively, as selected by the command
+ * line
+ *
+ *    Basic --run program.bas [--input data.txt] [--tree | --jit | --profile]
+ *          [--flush-interval ms] [--stats] [--cache] [--gosub-depth n]
+ *
+ * The program file is loaded in a single pass and run once, with INPUT
+ * statements reading from the data file if one is given.  The option
+ * --tree selects the statement-walking interpreter in place of the
+ * bytecode virtual machine, and --jit runs the program as native code.
+ * The option --profile runs on the virtual machine and writes a
+ * per-line profile to cerr when the run ends.  The option --cache,
+ * which works with the virtual machine and --jit, keeps the compiled
+ * program in a file named after the program with .cache appended, and
+ * runs from that file instead of parsing the source whenever the source
+ * has not changed since it was written.  The option --gosub-depth sets
+ * how deeply GOSUB statements may nest, which is 1000 by default.
+ * PRINT output is buffered until the run ends, the buffer fills, or an
+ * INPUT statement needs a value; the option --flush-interval also
+ * limits how long output may wait, and --stats reports on cerr, when
+ * the run ends, the bytes written, the number of flushes, and the
+ * number of expression nodes removed by the optimizer.  The return
+ * value is the exit status for the process: 0 if the program ran to
+ * completion, 1 if it could not be parsed or failed while running, and
+ * 2 if the command line was wrong or a file could not be opened.
+ */
+
+int runBatch(int argc, char **argv, Program & program, EvalState & state) {
+    string programFile;
+    string inputFile;
+    string engine = "vm";
+    bool showStats = false;
+    bool useCache = false;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--run" && i + 1 < argc) {
+            programFile = argv[++i];
+        } else if (arg == "--input" && i + 1 < argc) {
+            inputFile = argv[++i];
+        } else if (arg == "--tree") {
+            engine = "tree";
+        } else if (arg == "--jit") {
+            engine = "jit";
+        } else if (arg == "--profile") {
+            engine = "profile";
+        } else if (arg == "--flush-interval" && i + 1 < argc
+                   && stringIsInteger(argv[i + 1])) {
+            state.getOutput().setFlushInterval(stringToInteger(argv[++i]));
+        } else if (arg == "--stats") {
+            showStats = true;
+        } else if (arg == "--cache") {
+            useCache = true;
+        } else if (arg == "--gosub-depth" && i + 1 < argc
+                   && stringIsInteger(argv[i + 1])
+                   && stringToInteger(argv[i + 1]) >= 0) {
+            state.setReturnCapacity(stringToInteger(argv[++i]));
+        } else {
+            programFile = "";
+            break;
+        }
+    }
+    if (useCache && engine != "vm" && engine != "jit") programFile = "";
+    if (programFile == "") {
+        cerr << "Usage: " << argv[0]
+             << " --run program.bas [--input data.txt] [--tree | --jit | --profile]"
+             << " [--flush-interval ms] [--stats] [--cache] [--gosub-depth n]" << endl;
+        return 2;
+    }
+    ifstream infile(programFile.c_str());
+    if (infile.fail()) {
+        cerr << "Error: Can't open " << programFile << endl;
+        return 2;
+    }
+    ifstream datafile;
+    if (inputFile != "") {
+        datafile.open(inputFile.c_str());
+        if (datafile.fail()) {
+            cerr << "Error: Can't open " << inputFile << endl;
+            return 2;
+        }
+        state.setInputStream(&datafile);
+    }
+    int status = 0;
+    int cachedEliminated = 0;
+    try {
+        if (useCache) {
+            runCached(infile, programFile + ".cache", engine == "jit", program, state,
+                      cachedEliminated);
+        } else {
+            loadProgram(infile, program, state);
+            if (engine == "tree") {
+                runTreeWalker(program, state);
+            } else if (engine == "jit") {
+                runJit(program, state);
+            } else if (engine == "profile") {
+                runProfile(program, state, cerr);
+            } else {
+                runBytecode(program, state);
+            }
+        }
+    } catch (ErrorException & ex) {
+        state.getOutput().flush();
+        cerr << "Error: " << ex.getMessage() << endl;
+        status = 1;
+    }
+    state.getOutput().flush();
+    state.setInputStream(NULL);
+    if (showStats) {
+        cerr << "Output: " << state.getOutput().getBytesWritten() << " bytes in "
+             << state.getOutput().getFlushCount() << " flushes" << endl;
+        int eliminated = useCache ? cachedEliminated : program.getEliminatedNodes();
+        cerr << "Optimizer: " << eliminated << " expression nodes eliminated" << endl;
+    }
+    return status;
+}
+
+/*
+ * Function: runBytecode
+ * Usage: runBytecode(program, state);
+ * -----------------------------------
+ * Compiles the program and runs it on the bytecode virtual machine.
+ */
+
+void runBytecode(Program & program, EvalState & state) {
+    Bytecode code;
+    code.compile(program);
+    executeBytecode(code, state);
+}
+
+/*
+ * Function: runCached
+ * Usage: runCached(infile, cacheFile, native, program, state, eliminated);
+ * ------------------------------------------------------------------------
+ * Runs the program whose source is read from infile, on the virtual
+ * machine or, if native is true, as native code.  If cacheFile holds
+ * the compiled form of exactly this source, the program runs from it
+ * without being parsed.  Otherwise the source is loaded and compiled
+ * as usual, and the result is written to cacheFile for the next run.
+ * Failing to write the cache is not an error, since the program can
+ * always be compiled again.  Before the program runs, eliminated is
+ * set to the number of expression nodes the optimizer removed, which
+ * the file records along with the code.
+ */
+
+void runCached(istream & infile, string cacheFile, bool native,
+               Program & program, EvalState & state, int & eliminated) {
+    string source((istreambuf_iterator<char>(infile)), istreambuf_iterator<char>());
+    unsigned long long hash = CodeCache::hashSource(source);
+    CodeCache cache;
+    Bytecode compiled;
+    const Bytecode *code = &compiled;
+    if (cache.load(cacheFile, hash, state)) {
+        code = &cache.getBytecode();
+        eliminated = cache.getEliminatedNodes();
+    } else {
+        istringstream in(source);
+        loadProgram(in, program, state);
+        compiled.compile(program);
+        eliminated = program.getEliminatedNodes();
+        CodeCache::save(cacheFile, hash, compiled, state, eliminated);
+    }
+    if (native) {
+        JitCode jit;
+        jit.compile(*code);
+        executeJit(jit, state);
+    } else {
+        executeBytecode(*code, state);
+    }
+}
+
+/*
+ * Function: runInterruptible
+ * Usage: runInterruptible(program, state);
+ * ----------------------------------------
+ * Runs the program on the virtual machine in slices of RUN_SLICE
+ * statements, which is how RUN works at the console.  Between slices
+ * the interpreter checks whether the user has pressed the interrupt
+ * key, so that a program that loops forever can be stopped without
+ * ending the session.  INPUT statements suspend the program while the
+ * value is read from the console.
+ */
+
+static volatile sig_atomic_t interrupted = 0;
+
+static void handleInterrupt(int sig) {
+    interrupted = 1;
+}
+
+void runInterruptible(Program & program, EvalState & state) {
+    Interpreter interp(program, state);
+    interrupted = 0;
+    void (*previous)(int) = signal(SIGINT, handleInterrupt);
+    try {
+        while (interp.step(RUN_SLICE) != STEP_FINISHED) {
+            if (interrupted) error("Program interrupted");
+            if (interp.getStatus() == STEP_BLOCKED) {
+                interp.provideInput(getInteger(" ? "));
+            }
+        }
+    } catch (ErrorException &) {
+        signal(SIGINT, previous);
+        throw;
+    }
+    signal(SIGINT, previous);
+}
+
+/*
+ * Function: runJit
+ * Usage: runJit(program, state);
+ * ------------------------------
+ * Compiles the program to bytecode and then to native machine code,
+ * and runs the result.  On systems where native code generation is
+ * not available, the bytecode runs on the virtual machine.
+ */
+
+void runJit(Program & program, EvalState & state) {
+    Bytecode code;
+    code.compile(program);
+    JitCode jit;
+    jit.compile(code);
+    executeJit(jit, state);
+}
+
+/*
+ * Function: runProfile
+ * Usage: runProfile(program, state, os);
+ * --------------------------------------
+ * Runs the program on the profiling version of the virtual machine and
+ * writes the per-line profile to os.  The profile is written even if
+ * the program stops with an error, which is then raised again.
+ */
+
+void runProfile(Program & program, EvalState & state, ostream & os) {
+    Bytecode code;
+    code.compile(program);
+    Profiler profiler;
+    try {
+        executeBytecode(code, state, profiler);
+    } catch (ErrorException &) {
+        state.getOutput().flush();
+        profiler.report(program, os);
+        throw;
+    }
+    state.getOutput().flush();
+    profiler.report(program, os);
+}
+
+/*
+ * Function: runTreeWalker
+ * Usage: runTreeWalker(program, state);
+ * -------------------------------------
+ * Runs the program by calling execute on each parsed statement in
+ * turn.  This is the original implementation of RUN, which is kept
+ * so that it can be compared against the bytecode virtual machine.
+ * The program is linked first, so moving from one statement to the
+ * next follows a pointer rather than looking up a line number.  The
+ * DATA values are loaded before the first statement runs, as they are
+ * by the first instruction of the compiled program.
+ */
+
+void runTreeWalker(Program & program, EvalState & state) {
+    state.clearReturns();
+    program.restoreData(state);
+    Statement *stmt = program.getFirstStatement();
+    while (stmt != NULL) {
+        state.setNextStatement(stmt->getNext());
+        stmt->execute(state);
+        stmt = state.getNextStatement();
+    }
+}
@@ -0,0 +1,120 @@
+/*
+ * File: arena.cpp
+ * ---------------
+ * This file implements the Arena class.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include "arena.h"
+using namespace std;
+
+/*
+ * Constant: HEADER_SIZE
+ * ---------------------
+ * The space reserved for the header at the start of each chunk, which
+ * is rounded up so that the first object is as aligned as malloc's
+ * own result.
+ */
+
+static const size_t HEADER_SIZE = 2 * sizeof(void *) > alignof(max_align_t)
+                                ? 2 * sizeof(void *) : alignof(max_align_t);
+
+Arena::Arena() {
+   chunks = NULL;
+   cursor = NULL;
+   limit = NULL;
+   cleanups = NULL;
+   bytesAllocated = 0;
+}
+
+Arena::~Arena() {
+   clear();
+}
+
+Arena::Arena(Arena && other) noexcept {
+   chunks = NULL;
+   cursor = NULL;
+   limit = NULL;
+   cleanups = NULL;
+   bytesAllocated = 0;
+   swap(other);
+}
+
+Arena & Arena::operator=(Arena && other) noexcept {
+   if (this != &other) {
+      clear();
+      swap(other);
+   }
+   return *this;
+}
+
+void Arena::clear() {
+   while (cleanups != NULL) {
+      Cleanup *record = cleanups;
+      cleanups = record->next;
+      record->destroy(record->object);
+   }
+   while (chunks != NULL) {
+      Chunk *next = chunks->next;
+      free(chunks);
+      chunks = next;
+   }
+   cursor = NULL;
+   limit = NULL;
+   bytesAllocated = 0;
+}
+
+void Arena::swap(Arena & other) {
+   std::swap(chunks, other.chunks);
+   std::swap(cursor, other.cursor);
+   std::swap(limit, other.limit);
+   std::swap(cleanups, other.cleanups);
+   std::swap(bytesAllocated, other.bytesAllocated);
+}
+
+size_t Arena::getBytesAllocated() const {
+   return bytesAllocated;
+}
+
+/*
+ * Implementation notes: allocate
+ * ------------------------------
+ * Allocation rounds the cursor up to the alignment and advances it
+ * past the object, which is all that happens in the common case.  When
+ * the current chunk is too full, a new one is started; the old chunk's
+ * remaining space is abandoned.
+ */
+
+void *Arena::allocate(size_t size, size_t alignment) {
+   uintptr_t address = ((uintptr_t) cursor + alignment - 1) & ~(uintptr_t) (alignment - 1);
+   if (cursor == NULL || address + size > (uintptr_t) limit) {
+      addChunk(size + alignment);
+      address = ((uintptr_t) cursor + alignment - 1) & ~(uintptr_t) (alignment - 1);
+   }
+   cursor = (char *) (address + size);
+   return (void *) address;
+}
+
+/*
+ * Implementation notes: addChunk
+ * ------------------------------
+ * Each chunk is twice the size of the one before, up to MAX_CHUNK_SIZE,
+ * so that a single short statement fits in one small chunk while a
+ * large program needs only a few calls to malloc.
+ */
+
+void Arena::addChunk(size_t minimum) {
+   size_t size = (chunks == NULL) ? FIRST_CHUNK_SIZE : min(2 * chunks->size, MAX_CHUNK_SIZE);
+   size = max(size, minimum);
+   Chunk *chunk = (Chunk *) malloc(HEADER_SIZE + size);
+   if (chunk == NULL) throw bad_alloc();
+   chunk->next = chunks;
+   chunk->size = size;
+   chunks = chunk;
+   cursor = (char *) chunk + HEADER_SIZE;
+   limit = cursor + size;
+   bytesAllocated += HEADER_SIZE + size;
+}
@@ -0,0 +1,179 @@
+/*
+ * File: arena.h
+ * -------------
+ * This interface exports the Arena class, which owns the expression
+ * and statement nodes produced by the parser.
+ */
+
+#ifndef _arena_h
+#define _arena_h
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/*
+ * Class: Arena
+ * ------------
+ * This class allocates objects one after another in large chunks of
+ * memory and frees them all at once.  The nodes of a parsed statement
+ * are therefore laid out side by side, and discarding the statement
+ * costs one call to free for each chunk rather than one call to delete
+ * for each node.  Objects are never freed individually: a node that
+ * the optimizer replaces simply stays in the arena until the arena is
+ * cleared.  An arena can be moved but not copied, so that each object
+ * always has exactly one owner.
+ */
+
+class Arena {
+
+public:
+
+/*
+ * Constructor: Arena
+ * Usage: Arena arena;
+ * -------------------
+ * Creates an empty arena.  No memory is allocated until the first
+ * object is created.
+ */
+
+   Arena();
+
+/*
+ * Destructor: ~Arena
+ * Usage: usually implicit
+ * -----------------------
+ * Destroys every object in the arena and frees its memory.
+ */
+
+   ~Arena();
+
+/*
+ * Constructor and operator: move
+ * Usage: Arena arena = std::move(other);
+ *        arena = std::move(other);
+ * -------------------------------------
+ * Transfers the objects in other to this arena, leaving other empty.
+ * Assigning to an arena first clears the objects it held.
+ */
+
+   Arena(Arena && other) noexcept;
+   Arena & operator=(Arena && other) noexcept;
+
+/*
+ * Method: make
+ * Usage: T *object = arena.make<T>(args);
+ * ---------------------------------------
+ * Creates an object of type T in the arena, passing args to its
+ * constructor, and returns a pointer to it.  The object's destructor
+ * runs when the arena is cleared or destroyed.  If the constructor
+ * raises an error, the error passes through and the arena is left as
+ * it was, apart from any objects the constructor itself created.
+ */
+
+   template <typename T, typename... Args>
+   T *make(Args &&... args);
+
+/*
+ * Method: clear
+ * Usage: arena.clear();
+ * ---------------------
+ * Destroys every object in the arena, most recent first, and frees
+ * its memory.
+ */
+
+   void clear();
+
+/*
+ * Method: swap
+ * Usage: arena.swap(other);
+ * -------------------------
+ * Exchanges the contents of this arena and other.
+ */
+
+   void swap(Arena & other);
+
+/*
+ * Method: getBytesAllocated
+ * Usage: size_t bytes = arena.getBytesAllocated();
+ * ------------------------------------------------
+ * Returns the number of bytes the arena has obtained from the system.
+ */
+
+   size_t getBytesAllocated() const;
+
+private:
+
+/* Constants */
+
+   static const size_t FIRST_CHUNK_SIZE = 256;
+   static const size_t MAX_CHUNK_SIZE = 64 * 1024;
+
+/* Each chunk begins with this header */
+
+   struct Chunk {
+      Chunk *next;
+      size_t size;
+   };
+
+/* Each object with a destructor has one of these records */
+
+   struct Cleanup {
+      void (*destroy)(void *);
+      void *object;
+      Cleanup *next;
+   };
+
+/* Instance variables */
+
+   Chunk *chunks;               /* The chunks, most recent first      */
+   char *cursor;                /* The next free byte in chunks       */
+   char *limit;                 /* The end of the current chunk       */
+   Cleanup *cleanups;           /* Destructors to run, newest first   */
+   size_t bytesAllocated;       /* Total size of the chunks           */
+
+/* Private methods */
+
+   void *allocate(size_t size, size_t alignment);
+   void addChunk(size_t minimum);
+
+   template <typename T>
+   static void destroy(void *object) {
+      static_cast<T *>(object)->~T();
+   }
+
+/* Copying would give the objects two owners */
+
+   Arena(const Arena &);
+   Arena & operator=(const Arena &);
+
+};
+
+/*
+ * Implementation notes: make
+ * --------------------------
+ * The cleanup record is allocated before the object is constructed and
+ * linked into the list only afterwards, so that nothing can fail
+ * between constructing the object and recording how to destroy it.
+ * Types that need no destructor, such as plain structures, get no
+ * record at all.
+ */
+
+template <typename T, typename... Args>
+T *Arena::make(Args &&... args) {
+   Cleanup *record = NULL;
+   if (!std::is_trivially_destructible<T>::value) {
+      record = static_cast<Cleanup *>(allocate(sizeof(Cleanup), alignof(Cleanup)));
+   }
+   T *object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+   if (record != NULL) {
+      record->destroy = &Arena::destroy<T>;
+      record->object = object;
+      record->next = cleanups;
+      cleanups = record;
+   }
+   return object;
+}
+
+#endif
@@ -0,0 +1,65 @@
+/*
+ * File: batch.cpp
+ * ---------------
+ * This file implements the batch.h interface.
+ */
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include "batch.h"
+#include "bytecode.h"
+#include "error.h"
+#include "evalstate.h"
+#include "loader.h"
+#include "program.h"
+#include "threadpool.h"
+#include "vm.h"
+using namespace std;
+
+vector<ProgramResult> runPrograms(const vector<string> & sources,
+                                  const vector<string> & inputs, int nThreads) {
+   ThreadPool pool(nThreads);
+   return runPrograms(pool, sources, inputs);
+}
+
+vector<ProgramResult> runPrograms(ThreadPool & pool, const vector<string> & sources,
+                                  const vector<string> & inputs) {
+   vector<ProgramResult> results(sources.size());
+   pool.run(sources.size(), [&](int i) {
+      results[i] = runProgram(sources[i], (i < (int) inputs.size()) ? inputs[i] : "");
+   });
+   return results;
+}
+
+/*
+ * Implementation notes: runProgram
+ * --------------------------------
+ * The streams are declared before the EvalState, so that they outlive
+ * it; the destructor of the state flushes any remaining output into
+ * the string stream.  Because the state always has an input stream,
+ * INPUT never falls back to prompting at the console, which is the one
+ * path through the interpreter that touches process-wide state.
+ */
+
+ProgramResult runProgram(const string & source, const string & input) {
+   ProgramResult result;
+   ostringstream output;
+   istringstream data(input);
+   istringstream infile(source);
+   Program program;
+   EvalState state;
+   state.getOutput().setStream(output);
+   state.setInputStream(&data);
+   try {
+      loadProgram(infile, program, state);
+      Bytecode code;
+      code.compile(program);
+      executeBytecode(code, state);
+   } catch (ErrorException & ex) {
+      result.error = ex.getMessage();
+   }
+   state.getOutput().flush();
+   result.output = output.str();
+   return result;
+}
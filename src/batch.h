@@ -0,0 +1,68 @@
+/*
+ * File: batch.h
+ * -------------
+ * This interface exports an embedding API that runs many independent
+ * BASIC programs at once, spread across the cores of the machine.
+ */
+
+#ifndef _batch_h
+#define _batch_h
+
+#include <string>
+#include <vector>
+#include "threadpool.h"
+
+/*
+ * Type: ProgramResult
+ * -------------------
+ * This type records the outcome of one program in a batch.  The field
+ * output holds everything the program printed, and error holds the
+ * message for the error that stopped it, or is empty if the program
+ * was parsed and ran to completion.
+ */
+
+struct ProgramResult {
+   std::string output;
+   std::string error;
+};
+
+/*
+ * Function: runPrograms
+ * Usage: vector<ProgramResult> results = runPrograms(sources);
+ *        vector<ProgramResult> results = runPrograms(sources, inputs, nThreads);
+ *        vector<ProgramResult> results = runPrograms(pool, sources, inputs);
+ * ------------------------------------------------------------------------------
+ * Parses each string in sources as a complete BASIC program, in the
+ * format read by loadProgram, and runs it on the bytecode virtual
+ * machine.  Each program has its own Program and EvalState, its PRINT
+ * output is captured in a string, and its INPUT statements read from
+ * the corresponding element of inputs, one integer per line; a program
+ * with no element in inputs reads from empty input.  Nothing is read
+ * from the console or written to cout, so the programs can run on any
+ * number of threads at once.
+ *
+ * The programs run on the specified pool, or on a pool of nThreads
+ * threads created for the call, where zero means one thread per
+ * hardware thread.  The results are returned in the order of sources.
+ */
+
+std::vector<ProgramResult> runPrograms(const std::vector<std::string> & sources,
+                                       const std::vector<std::string> & inputs
+                                          = std::vector<std::string>(),
+                                       int nThreads = 0);
+std::vector<ProgramResult> runPrograms(ThreadPool & pool,
+                                       const std::vector<std::string> & sources,
+                                       const std::vector<std::string> & inputs
+                                          = std::vector<std::string>());
+
+/*
+ * Function: runProgram
+ * Usage: ProgramResult result = runProgram(source, input);
+ * --------------------------------------------------------
+ * Runs a single program as described for runPrograms, on the calling
+ * thread.
+ */
+
+ProgramResult runProgram(const std::string & source, const std::string & input);
+
+#endif
@@ -0,0 +1,571 @@
+/*
+ * File: bytecode.cpp
+ * ------------------
+ * This file implements the Bytecode class and the compiler that
+ * lowers a Program into it.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "bytecode.h"
+#include "error.h"
+#include "exp.h"
+#include "program.h"
+#include "statement.h"
+#include "value.h"
+using namespace std;
+
+/*
+ * Constants: ARITHMETIC, JUMPS, LOADS, STORES, PRINTS
+ * ---------------------------------------------------
+ * These tables give the instruction for each operation on values of
+ * each kind, indexed first by the ValueKind.  The arithmetic operators
+ * are in the order ADD_OP, SUB_OP, MUL_OP, DIV_OP, and the comparisons
+ * in the order EQUAL_OP, LESS_OP, GREATER_OP.
+ */
+
+static const Opcode ARITHMETIC[][4] = {
+   { OP_ADD, OP_SUB, OP_MUL, OP_DIV },
+   { OP_ADD_LONG, OP_SUB_LONG, OP_MUL_LONG, OP_DIV_LONG },
+   { OP_ADD_DOUBLE, OP_SUB_DOUBLE, OP_MUL_DOUBLE, OP_DIV_DOUBLE }
+};
+
+static const Opcode JUMPS[][3] = {
+   { OP_JUMP_EQ, OP_JUMP_LT, OP_JUMP_GT },
+   { OP_JUMP_EQ_LONG, OP_JUMP_LT_LONG, OP_JUMP_GT_LONG },
+   { OP_JUMP_EQ_DOUBLE, OP_JUMP_LT_DOUBLE, OP_JUMP_GT_DOUBLE }
+};
+
+static const Opcode LOADS[] = { OP_LOAD, OP_LOAD_LONG, OP_LOAD_DOUBLE };
+static const Opcode STORES[] = { OP_STORE, OP_STORE_LONG, OP_STORE_DOUBLE };
+static const Opcode PRINTS[] = { OP_PRINT, OP_PRINT_LONG, OP_PRINT_DOUBLE };
+
+Bytecode::Bytecode() {
+   maxStack = 0;
+   depth = 0;
+   codeView = NULL;
+   lineView = NULL;
+   startView = NULL;
+   viewSize = 0;
+}
+
+void Bytecode::clear() {
+   code.clear();
+   lines.clear();
+   starts.clear();
+   maxStack = 0;
+   depth = 0;
+   codeView = NULL;
+   lineView = NULL;
+   startView = NULL;
+   viewSize = 0;
+}
+
+/*
+ * Implementation notes: attach
+ * ----------------------------
+ * The accessors read through the view pointers rather than the vectors,
+ * so that code which was compiled here and code which lives in memory
+ * owned by someone else look the same to the rest of the interpreter.
+ */
+
+void Bytecode::attach(const int *words, const int *lineNumbers,
+                      const unsigned char *statementStarts, int n, int maxStack) {
+   clear();
+   codeView = words;
+   lineView = lineNumbers;
+   startView = statementStarts;
+   viewSize = n;
+   this->maxStack = maxStack;
+}
+
+/*
+ * Implementation notes: compile
+ * -----------------------------
+ * The program is linked first, which reports any jump to a missing
+ * line before code is generated.  The compiler then makes a single
+ * pass over the lines in order, compiling any line whose LineCode is
+ * out of date and appending the words for each line to the code.  The
+ * address of each line is recorded as it is reached, and the address
+ * of every jump operand, which still holds the target line number, is
+ * remembered in a fixup list that is patched once all line addresses
+ * are known.  Since the lines are reached in order, the line numbers
+ * form a sorted array in which each target is found by binary search.
+ * A loop jump goes to the first line after its target, or to the final
+ * END if there is none.  Like that END, the OP_RESTORE that comes
+ * before the first line belongs to no line.
+ */
+
+void Bytecode::compile(Program & program) {
+   clear();
+   program.link();
+   vector<int> lineNumbers;
+   vector<int> lineAddresses;
+   vector<int> fixups;
+   vector<int> loopFixups;
+   vector<int> data;
+   if (program.getData(data)) {
+      emit(OP_RESTORE, data.size());
+      for (size_t i = 0; i < data.size(); i++) {
+         emit(OP_DATA, data[i]);
+      }
+      lines.resize(code.size(), -1);
+      starts.resize(code.size(), false);
+   }
+   int lineNumber = program.getFirstLineNumber();
+   while (lineNumber != -1) {
+      lineNumbers.push_back(lineNumber);
+      lineAddresses.push_back(code.size());
+      Statement *stmt = program.getParsedStatement(lineNumber);
+      if (stmt != NULL) {
+         LineCode & lineCode = *program.getLineCode(lineNumber);
+         if (!lineCode.valid) compileLine(stmt, lineCode);
+         int start = code.size();
+         code.insert(code.end(), lineCode.words.begin(), lineCode.words.end());
+         for (size_t i = 0; i < lineCode.jumps.size(); i++) {
+            fixups.push_back(start + lineCode.jumps[i]);
+         }
+         for (size_t i = 0; i < lineCode.loopJumps.size(); i++) {
+            loopFixups.push_back(start + lineCode.loopJumps[i]);
+         }
+         if (lineCode.maxStack > maxStack) maxStack = lineCode.maxStack;
+         lines.resize(code.size(), lineNumber);
+         starts.resize(code.size(), false);
+         if ((int) code.size() > start) starts[start] = true;
+      }
+      lineNumber = program.getNextLineNumber(lineNumber);
+   }
+   emit(OP_END);
+   lines.push_back(-1);
+   starts.push_back(false);
+   codeView = &code[0];
+   lineView = &lines[0];
+   startView = &starts[0];
+   viewSize = code.size();
+   for (size_t i = 0; i < fixups.size(); i++) {
+      int target = code[fixups[i]];
+      int index = lower_bound(lineNumbers.begin(), lineNumbers.end(), target) - lineNumbers.begin();
+      code[fixups[i]] = lineAddresses[index];
+   }
+   for (size_t i = 0; i < loopFixups.size(); i++) {
+      int target = code[loopFixups[i]];
+      size_t index = upper_bound(lineNumbers.begin(), lineNumbers.end(), target) - lineNumbers.begin();
+      code[loopFixups[i]] = (index < lineAddresses.size()) ? lineAddresses[index] : (int) code.size() - 1;
+   }
+}
+
+/*
+ * Implementation notes: compileLine
+ * ---------------------------------
+ * The statement is compiled at the end of the code array as usual and
+ * the words are then moved into the LineCode, so that compileStatement
+ * need not know where its output goes.  The stack depth is measured
+ * from zero, since every statement starts with an empty stack.
+ */
+
+void Bytecode::compileLine(Statement *stmt, LineCode & lineCode) {
+   int start = code.size();
+   int programMax = maxStack;
+   maxStack = 0;
+   lineCode.jumps.clear();
+   lineCode.loopJumps.clear();
+   compileStatement(stmt, lineCode);
+   for (size_t i = 0; i < lineCode.jumps.size(); i++) {
+      lineCode.jumps[i] -= start;
+   }
+   for (size_t i = 0; i < lineCode.loopJumps.size(); i++) {
+      lineCode.loopJumps[i] -= start;
+   }
+   lineCode.words.assign(code.begin() + start, code.end());
+   code.resize(start);
+   lineCode.maxStack = maxStack;
+   lineCode.valid = true;
+   maxStack = programMax;
+}
+
+/*
+ * Implementation notes: compileStatement
+ * --------------------------------------
+ * Each jump is emitted with the target line number as its operand, and
+ * the address of the operand is added to the jumps list of the line, or
+ * to its loopJumps list for the jumps made by FOR and NEXT.  FOR leaves
+ * the start, limit and step on the stack for OP_FOR to store.
+ */
+
+void Bytecode::compileStatement(Statement *stmt, LineCode & lineCode) {
+   switch (stmt->getType()) {
+    case REM_STMT:
+      break;
+    case LET_STMT: {
+      LetStmt *let = (LetStmt *) stmt;
+      ArrayExp *element = let->getElement();
+      if (element != NULL) {
+         compileIndex(element);
+         compileExpression(let->getExp());
+         emit(OP_STORE_ELEMENT, element->getSlot());
+         break;
+      }
+      ValueKind kind = getNameKind(let->getVar());
+      compileExpression(let->getExp(), kind);
+      emit(STORES[kind], let->getSlot());
+      break;
+    }
+    case PRINT_STMT: {
+      Expression *exp = ((PrintStmt *) stmt)->getExp();
+      compileExpression(exp, exp->getKind());
+      emit(PRINTS[exp->getKind()]);
+      break;
+    }
+    case INPUT_STMT:
+      emit(OP_INPUT, ((InputStmt *) stmt)->getSlot());
+      break;
+    case GOTO_STMT:
+      emit(OP_JUMP, ((GotoStmt *) stmt)->getLineNumber());
+      lineCode.jumps.push_back(code.size() - 1);
+      break;
+    case IF_STMT: {
+      IfStmt *ifStmt = (IfStmt *) stmt;
+      ValueKind kind = ifStmt->getKind();
+      compileExpression(ifStmt->getLHS(), kind);
+      compileExpression(ifStmt->getRHS(), kind);
+      emit(JUMPS[kind][ifStmt->getOp() - EQUAL_OP], ifStmt->getLineNumber());
+      lineCode.jumps.push_back(code.size() - 1);
+      break;
+    }
+    case END_STMT:
+      emit(OP_END);
+      break;
+    case FOR_STMT: {
+      ForStmt *forStmt = (ForStmt *) stmt;
+      compileExpression(forStmt->getStart());
+      compileExpression(forStmt->getLimit());
+      compileExpression(forStmt->getStep());
+      emit(OP_FOR, forStmt->getControl(), forStmt->getLoopEndLine());
+      lineCode.loopJumps.push_back(code.size() - 1);
+      break;
+    }
+    case NEXT_STMT: {
+      NextStmt *next = (NextStmt *) stmt;
+      emit(OP_NEXT, next->getControl(), next->getLoopStartLine());
+      lineCode.loopJumps.push_back(code.size() - 1);
+      break;
+    }
+    case GOSUB_STMT:
+      emit(OP_GOSUB, ((GosubStmt *) stmt)->getLineNumber());
+      lineCode.jumps.push_back(code.size() - 1);
+      break;
+    case RETURN_STMT:
+      emit(OP_RETURN);
+      break;
+    case DIM_STMT: {
+      DimStmt *dim = (DimStmt *) stmt;
+      emit(OP_DIM, dim->getSlot(), dim->getRows(), dim->getColumns());
+      break;
+    }
+    case MAT_STMT: {
+      MatStmt *mat = (MatStmt *) stmt;
+      if (mat->getOperation() == MAT_SCALE) {
+         compileExpression(mat->getScalar());
+         emit(OP_MAT_SCALE, mat->getDestSlot(), mat->getLHSSlot());
+      } else {
+         emit(OP_MAT, mat->getOperation(), mat->getDestSlot(), mat->getLHSSlot(),
+              mat->getRHSSlot());
+      }
+      break;
+    }
+    case DATA_STMT:
+      break;
+   }
+}
+
+/*
+ * Implementation notes: compileExpression
+ * ---------------------------------------
+ * Expressions are compiled in postorder, so that the operands of each
+ * operator are on the stack when the operator executes.  As in
+ * CompoundExp::eval, the assignment operator is a special case that
+ * does not evaluate its left operand.  The code leaves a value of the
+ * specified kind on the stack: each subexpression is computed in its
+ * own kind, the operands of an operator in the kind of the operator,
+ * and a conversion follows wherever the kinds differ.  A constant is
+ * simply pushed in the kind that is wanted.
+ */
+
+void Bytecode::compileExpression(Expression *exp, ValueKind kind) {
+   ValueKind own = exp->getKind();
+   switch (exp->getType()) {
+    case CONSTANT:
+      compileConstant((ConstantExp *) exp, kind);
+      return;
+    case IDENTIFIER:
+      emit(LOADS[own], ((IdentifierExp *) exp)->getSlot());
+      break;
+    case ARRAY:
+      compileIndex((ArrayExp *) exp);
+      emit(OP_LOAD_ELEMENT, ((ArrayExp *) exp)->getSlot());
+      break;
+    case COMPOUND: {
+      CompoundExp *cexp = (CompoundExp *) exp;
+      OperatorType op = cexp->getOperator();
+      if (op == ASSIGN_OP) {
+         if (cexp->getLHS()->getType() != IDENTIFIER) {
+            error("Illegal variable in assignment");
+         }
+         compileExpression(cexp->getRHS());
+         emit(OP_DUP);
+         emit(OP_STORE, ((IdentifierExp *) cexp->getLHS())->getSlot());
+         break;
+      }
+      compileExpression(cexp->getLHS(), own);
+      compileExpression(cexp->getRHS(), own);
+      if (op < ADD_OP || op > DIV_OP) error("Illegal operator in expression");
+      emit(ARITHMETIC[own][op - ADD_OP]);
+      break;
+    }
+   }
+   compileConversion(own, kind);
+}
+
+/*
+ * Implementation notes: compileConstant
+ * -------------------------------------
+ * A wide constant is split into the two words that hold it in memory,
+ * which the virtual machine copies back onto the stack unchanged.
+ */
+
+void Bytecode::compileConstant(ConstantExp *constant, ValueKind kind) {
+   int words[2];
+   if (kind == LONG_VALUE) {
+      long long value = constant->getLongValue();
+      memcpy(words, &value, sizeof value);
+   } else if (kind == DOUBLE_VALUE) {
+      double value = constant->getRealValue();
+      memcpy(words, &value, sizeof value);
+   } else {
+      emit(OP_PUSH, constant->getValue());
+      return;
+   }
+   emit(OP_PUSH2, words[0], words[1]);
+}
+
+void Bytecode::compileConversion(ValueKind from, ValueKind to) {
+   static const Opcode CONVERSIONS[][3] = {
+      { OP_COUNT, OP_INT_TO_LONG, OP_INT_TO_DOUBLE },
+      { OP_LONG_TO_INT, OP_COUNT, OP_LONG_TO_DOUBLE },
+      { OP_DOUBLE_TO_INT, OP_DOUBLE_TO_LONG, OP_COUNT }
+   };
+   if (from != to) emit(CONVERSIONS[from][to]);
+}
+
+/*
+ * Implementation notes: compileIndex
+ * ----------------------------------
+ * The code leaves the position of the element on the stack.  If
+ * Program::link has shown that the subscripts are in range, the
+ * position of an element with two subscripts is computed from the
+ * number of columns recorded in the ArrayExp, and that of an element
+ * with one subscript is the subscript itself.
+ */
+
+void Bytecode::compileIndex(ArrayExp *element) {
+   compileExpression(element->getRow());
+   if (element->getColumn() == NULL) {
+      if (element->isChecked()) emit(OP_INDEX, element->getSlot());
+      return;
+   }
+   if (element->isChecked()) {
+      compileExpression(element->getColumn());
+      emit(OP_INDEX2, element->getSlot());
+   } else {
+      emit(OP_PUSH, element->getColumns());
+      emit(OP_MUL);
+      compileExpression(element->getColumn());
+      emit(OP_ADD);
+   }
+}
+
+/*
+ * Implementation notes: emit
+ * --------------------------
+ * Besides appending words to the code array, emit keeps track of the
+ * stack depth at each point so that the virtual machine can allocate
+ * a stack of exactly the right size.  Because every statement leaves
+ * the stack empty, the depth is the same along every path through the
+ * code and can be tracked in straight-line order.
+ */
+
+void Bytecode::emit(Opcode op) {
+   code.push_back(op);
+   adjustStack(getStackEffect(op));
+}
+
+void Bytecode::emit(Opcode op, int operand) {
+   code.push_back(op);
+   code.push_back(operand);
+   adjustStack(getStackEffect(op));
+}
+
+void Bytecode::emit(Opcode op, int first, int second) {
+   code.push_back(op);
+   code.push_back(first);
+   code.push_back(second);
+   adjustStack(getStackEffect(op));
+}
+
+void Bytecode::emit(Opcode op, int first, int second, int third) {
+   code.push_back(op);
+   code.push_back(first);
+   code.push_back(second);
+   code.push_back(third);
+   adjustStack(getStackEffect(op));
+}
+
+void Bytecode::emit(Opcode op, int first, int second, int third, int fourth) {
+   code.push_back(op);
+   code.push_back(first);
+   code.push_back(second);
+   code.push_back(third);
+   code.push_back(fourth);
+   adjustStack(getStackEffect(op));
+}
+
+void Bytecode::emit(Opcode op, const LoopControl & control, int operand) {
+   code.push_back(op);
+   code.push_back(control.counter);
+   code.push_back(control.limit);
+   code.push_back(control.step);
+   code.push_back(operand);
+   adjustStack(getStackEffect(op));
+}
+
+void Bytecode::adjustStack(int delta) {
+   depth += delta;
+   if (depth > maxStack) maxStack = depth;
+}
+
+int getOperandCount(Opcode op) {
+   switch (op) {
+    case OP_PUSH: case OP_LOAD: case OP_STORE: case OP_INPUT:
+    case OP_JUMP: case OP_JUMP_EQ: case OP_JUMP_GT: case OP_JUMP_LT:
+    case OP_GOSUB: case OP_INDEX: case OP_INDEX2:
+    case OP_LOAD_ELEMENT: case OP_STORE_ELEMENT: case OP_RESTORE: case OP_DATA:
+    case OP_LOAD_LONG: case OP_LOAD_DOUBLE: case OP_STORE_LONG: case OP_STORE_DOUBLE:
+    case OP_JUMP_EQ_LONG: case OP_JUMP_GT_LONG: case OP_JUMP_LT_LONG:
+    case OP_JUMP_EQ_DOUBLE: case OP_JUMP_GT_DOUBLE: case OP_JUMP_LT_DOUBLE:
+      return 1;
+    case OP_MAT_SCALE: case OP_PUSH2:
+      return 2;
+    case OP_DIM:
+      return 3;
+    case OP_FOR: case OP_NEXT: case OP_MAT:
+      return 4;
+    default:
+      return 0;
+   }
+}
+
+/*
+ * Implementation notes: getStackEffect, getStackInputs
+ * ----------------------------------------------------
+ * Both count words rather than values, so a 64-bit integer or double
+ * counts twice.
+ */
+
+int getStackEffect(Opcode op) {
+   switch (op) {
+    case OP_PUSH: case OP_LOAD: case OP_DUP:
+    case OP_INT_TO_LONG: case OP_INT_TO_DOUBLE:
+      return 1;
+    case OP_PUSH2: case OP_LOAD_LONG: case OP_LOAD_DOUBLE:
+      return 2;
+    case OP_STORE: case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV:
+    case OP_POP: case OP_PRINT: case OP_INDEX2: case OP_MAT_SCALE:
+    case OP_LONG_TO_INT: case OP_DOUBLE_TO_INT:
+      return -1;
+    case OP_JUMP_EQ: case OP_JUMP_GT: case OP_JUMP_LT: case OP_STORE_ELEMENT:
+    case OP_STORE_LONG: case OP_STORE_DOUBLE:
+    case OP_ADD_LONG: case OP_SUB_LONG: case OP_MUL_LONG: case OP_DIV_LONG:
+    case OP_ADD_DOUBLE: case OP_SUB_DOUBLE: case OP_MUL_DOUBLE: case OP_DIV_DOUBLE:
+    case OP_PRINT_LONG: case OP_PRINT_DOUBLE:
+      return -2;
+    case OP_FOR:
+      return -3;
+    case OP_JUMP_EQ_LONG: case OP_JUMP_GT_LONG: case OP_JUMP_LT_LONG:
+    case OP_JUMP_EQ_DOUBLE: case OP_JUMP_GT_DOUBLE: case OP_JUMP_LT_DOUBLE:
+      return -4;
+    default:
+      return 0;
+   }
+}
+
+int getStackInputs(Opcode op) {
+   switch (op) {
+    case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV:
+    case OP_JUMP_EQ: case OP_JUMP_GT: case OP_JUMP_LT:
+    case OP_INDEX2: case OP_STORE_ELEMENT:
+    case OP_STORE_LONG: case OP_STORE_DOUBLE: case OP_PRINT_LONG: case OP_PRINT_DOUBLE:
+    case OP_LONG_TO_INT: case OP_LONG_TO_DOUBLE: case OP_DOUBLE_TO_INT: case OP_DOUBLE_TO_LONG:
+      return 2;
+    case OP_STORE: case OP_DUP: case OP_POP: case OP_PRINT:
+    case OP_INDEX: case OP_LOAD_ELEMENT: case OP_MAT_SCALE:
+    case OP_INT_TO_LONG: case OP_INT_TO_DOUBLE:
+      return 1;
+    case OP_FOR:
+      return 3;
+    case OP_ADD_LONG: case OP_SUB_LONG: case OP_MUL_LONG: case OP_DIV_LONG:
+    case OP_ADD_DOUBLE: case OP_SUB_DOUBLE: case OP_MUL_DOUBLE: case OP_DIV_DOUBLE:
+    case OP_JUMP_EQ_LONG: case OP_JUMP_GT_LONG: case OP_JUMP_LT_LONG:
+    case OP_JUMP_EQ_DOUBLE: case OP_JUMP_GT_DOUBLE: case OP_JUMP_LT_DOUBLE:
+      return 4;
+    default:
+      return 0;
+   }
+}
+
+OperandKind getOperandKind(Opcode op, int k) {
+   switch (op) {
+    case OP_LOAD: case OP_STORE: case OP_INPUT: case OP_INDEX: case OP_INDEX2:
+    case OP_LOAD_ELEMENT: case OP_STORE_ELEMENT: case OP_MAT_SCALE:
+    case OP_LOAD_LONG: case OP_LOAD_DOUBLE: case OP_STORE_LONG: case OP_STORE_DOUBLE:
+      return OPERAND_SLOT;
+    case OP_DIM:
+      return (k == 1) ? OPERAND_SLOT : OPERAND_VALUE;
+    case OP_MAT:
+      return (k == 1) ? OPERAND_VALUE : OPERAND_SLOT;
+    case OP_JUMP: case OP_JUMP_EQ: case OP_JUMP_GT: case OP_JUMP_LT:
+    case OP_GOSUB:
+    case OP_JUMP_EQ_LONG: case OP_JUMP_GT_LONG: case OP_JUMP_LT_LONG:
+    case OP_JUMP_EQ_DOUBLE: case OP_JUMP_GT_DOUBLE: case OP_JUMP_LT_DOUBLE:
+      return OPERAND_ADDRESS;
+    case OP_FOR: case OP_NEXT:
+      return (k < 4) ? OPERAND_SLOT : OPERAND_ADDRESS;
+    default:
+      return OPERAND_VALUE;
+   }
+}
+
+const int *Bytecode::getCode() const {
+   return codeView;
+}
+
+int Bytecode::size() const {
+   return viewSize;
+}
+
+int Bytecode::getMaxStack() const {
+   return maxStack;
+}
+
+int Bytecode::getLineNumber(int pc) const {
+   return lineView[pc];
+}
+
+bool Bytecode::isStatementStart(int pc) const {
+   return startView[pc] != 0;
+}
+
+const unsigned char *Bytecode::getStatementStarts() const {
+   return startView;
+}
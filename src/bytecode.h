@@ -0,0 +1,281 @@
+/*
+ * File: bytecode.h
+ * ----------------
+ * This interface exports the Bytecode class, which holds a BASIC
+ * program lowered from its Statement and Expression trees into a
+ * flat array of instruction words, along with the compiler that
+ * performs the lowering.
+ */
+
+#ifndef _bytecode_h
+#define _bytecode_h
+
+#include <string>
+#include <vector>
+#include "exp.h"
+#include "program.h"
+#include "value.h"
+
+/*
+ * Type: Opcode
+ * ------------
+ * This enumerated type lists the instructions understood by the
+ * virtual machine in vm.h.  The machine is a simple stack machine:
+ * expressions push their operands and arithmetic instructions pop
+ * two values and push the result.  Each opcode occupies one word in
+ * the code array and is followed by the number of operand words
+ * shown in the comment.  The loop instructions name the three slots
+ * of a LoopControl block, in the order counter, limit, step.  An
+ * element is read or written by position, which OP_INDEX and OP_INDEX2
+ * compute from the subscripts after checking them; when the compiler
+ * knows the subscripts are in range, it computes the position with
+ * ordinary arithmetic instead.  A program that reads DATA begins with
+ * OP_RESTORE, which loads the values of the OP_DATA instructions that
+ * follow it and then jumps past them.
+ *
+ * The instructions from OP_PUSH2 on work with the 64-bit integers and
+ * doubles of typed variables.  Each such value takes two words on the
+ * operand stack, and the compiler chooses the instruction for the kind
+ * of every expression, so that no value carries a tag.  The conversions
+ * change the kind of the value on top of the stack.
+ */
+
+enum Opcode {
+   OP_PUSH,          /* 1: constant value                         */
+   OP_LOAD,          /* 1: variable slot                          */
+   OP_STORE,         /* 1: variable slot                          */
+   OP_ADD,           /* 0                                         */
+   OP_SUB,           /* 0                                         */
+   OP_MUL,           /* 0                                         */
+   OP_DIV,           /* 0                                         */
+   OP_DUP,           /* 0                                         */
+   OP_POP,           /* 0                                         */
+   OP_PRINT,         /* 0                                         */
+   OP_INPUT,         /* 1: variable slot                          */
+   OP_JUMP,          /* 1: code address                           */
+   OP_JUMP_EQ,       /* 1: code address, taken if lhs = rhs       */
+   OP_JUMP_GT,       /* 1: code address, taken if lhs > rhs       */
+   OP_JUMP_LT,       /* 1: code address, taken if lhs < rhs       */
+   OP_END,           /* 0                                         */
+   OP_FOR,           /* 4: loop slots, address taken if no trips  */
+   OP_NEXT,          /* 4: loop slots, address taken to loop      */
+   OP_GOSUB,         /* 1: code address                           */
+   OP_RETURN,        /* 0                                         */
+   OP_DIM,           /* 3: array slot, rows, columns              */
+   OP_INDEX,         /* 1: array slot, checks one subscript       */
+   OP_INDEX2,        /* 1: array slot, checks row and column      */
+   OP_LOAD_ELEMENT,  /* 1: array slot, replaces position by value */
+   OP_STORE_ELEMENT, /* 1: array slot, pops value and position    */
+   OP_MAT,           /* 4: MatOperation, result, lhs, rhs slots   */
+   OP_MAT_SCALE,     /* 2: result and array slots, pops factor    */
+   OP_RESTORE,       /* 1: number of OP_DATA that follow          */
+   OP_DATA,          /* 1: constant value, never executed         */
+   OP_PUSH2,         /* 2: the two words of a wide constant       */
+   OP_LOAD_LONG,     /* 1: variable slot                          */
+   OP_LOAD_DOUBLE,   /* 1: variable slot                          */
+   OP_STORE_LONG,    /* 1: variable slot                          */
+   OP_STORE_DOUBLE,  /* 1: variable slot                          */
+   OP_ADD_LONG,      /* 0                                         */
+   OP_SUB_LONG,      /* 0                                         */
+   OP_MUL_LONG,      /* 0                                         */
+   OP_DIV_LONG,      /* 0                                         */
+   OP_ADD_DOUBLE,    /* 0                                         */
+   OP_SUB_DOUBLE,    /* 0                                         */
+   OP_MUL_DOUBLE,    /* 0                                         */
+   OP_DIV_DOUBLE,    /* 0                                         */
+   OP_PRINT_LONG,    /* 0                                         */
+   OP_PRINT_DOUBLE,  /* 0                                         */
+   OP_JUMP_EQ_LONG,  /* 1: code address, taken if lhs = rhs       */
+   OP_JUMP_GT_LONG,  /* 1: code address, taken if lhs > rhs       */
+   OP_JUMP_LT_LONG,  /* 1: code address, taken if lhs < rhs       */
+   OP_JUMP_EQ_DOUBLE, /* 1: code address, taken if lhs = rhs      */
+   OP_JUMP_GT_DOUBLE, /* 1: code address, taken if lhs > rhs      */
+   OP_JUMP_LT_DOUBLE, /* 1: code address, taken if lhs < rhs      */
+   OP_INT_TO_LONG,   /* 0                                         */
+   OP_INT_TO_DOUBLE, /* 0                                         */
+   OP_LONG_TO_INT,   /* 0                                         */
+   OP_LONG_TO_DOUBLE, /* 0                                        */
+   OP_DOUBLE_TO_INT, /* 0                                         */
+   OP_DOUBLE_TO_LONG, /* 0                                        */
+   OP_COUNT
+};
+
+/*
+ * Functions: getOperandCount, getStackEffect
+ * Usage: int n = getOperandCount(op);
+ *        int delta = getStackEffect(op);
+ * --------------------------------------
+ * Return the number of operand words that follow the opcode in the
+ * code array and the net change that the instruction makes to the
+ * depth of the operand stack.
+ */
+
+int getOperandCount(Opcode op);
+int getStackEffect(Opcode op);
+
+/*
+ * Type: OperandKind
+ * -----------------
+ * This enumerated type says how an operand word is interpreted: as a
+ * constant, as a variable slot, or as a code address.
+ */
+
+enum OperandKind { OPERAND_VALUE, OPERAND_SLOT, OPERAND_ADDRESS };
+
+/*
+ * Functions: getStackInputs, getOperandKind
+ * Usage: int n = getStackInputs(op);
+ *        OperandKind kind = getOperandKind(op, k);
+ * ------------------------------------------------
+ * Return the number of values the instruction reads from the top of
+ * the operand stack, and the kind of its kth operand, counting from
+ * one.  Code that checks or relocates compiled programs uses these to
+ * interpret operands without knowing every opcode.
+ */
+
+int getStackInputs(Opcode op);
+OperandKind getOperandKind(Opcode op, int k);
+
+/*
+ * Class: Bytecode
+ * ---------------
+ * This class stores a compiled BASIC program.  The code array is a
+ * sequence of 32-bit words in which each opcode is followed by its
+ * operands.  Variables are referred to by the EvalState slots that
+ * resolveSymbols assigned to them, and jumps hold absolute code
+ * addresses.
+ */
+
+class Bytecode {
+
+public:
+
+/*
+ * Constructor: Bytecode
+ * Usage: Bytecode code;
+ * ---------------------
+ * Creates an empty code object.  Executing an empty code object
+ * does nothing.
+ */
+
+   Bytecode();
+
+/*
+ * Method: compile
+ * Usage: code.compile(program);
+ * -----------------------------
+ * Replaces the contents of this object with the compiled form of
+ * the program.  The program is linked first, so a jump that
+ * names a missing line raises an error before any code runs.  The
+ * code for each line is kept with the line in the program, so only
+ * lines edited since the last compilation are compiled again; the
+ * rest are copied into place.
+ */
+
+   void compile(Program & program);
+
+/*
+ * Method: attach
+ * Usage: code.attach(words, lines, starts, n, maxStack);
+ * ------------------------------------------------------
+ * Replaces the contents of this object with n words of compiled code
+ * that are held elsewhere, such as in a mapped cache file, together
+ * with the line number of each word, the flags that mark the start of
+ * each statement, and the depth of the operand stack.  Nothing is
+ * copied, so the arrays must remain valid and unchanged for as long as
+ * this object refers to them.
+ */
+
+   void attach(const int *words, const int *lines,
+               const unsigned char *starts, int n, int maxStack);
+
+/*
+ * Method: clear
+ * Usage: code.clear();
+ * --------------------
+ * Removes all instructions.
+ */
+
+   void clear();
+
+/*
+ * Methods: getCode, size
+ * Usage: const int *words = code.getCode();
+ *        int n = code.size();
+ * ----------------------------------------
+ * Return the instruction words and their number.
+ */
+
+   const int *getCode() const;
+   int size() const;
+
+/*
+ * Method: getMaxStack
+ * Usage: int depth = code.getMaxStack();
+ * --------------------------------------
+ * Returns the largest number of values the code ever holds on the
+ * operand stack, which the virtual machine uses to size its stack.
+ */
+
+   int getMaxStack() const;
+
+/*
+ * Method: getLineNumber
+ * Usage: int lineNumber = code.getLineNumber(pc);
+ * -----------------------------------------------
+ * Returns the number of the BASIC line from which the instruction at
+ * address pc was compiled.
+ */
+
+   int getLineNumber(int pc) const;
+
+/*
+ * Method: isStatementStart
+ * Usage: if (code.isStatementStart(pc)) . . .
+ * -------------------------------------------
+ * Returns true if the instruction at address pc is the first one
+ * compiled from a statement.  The operand stack is empty at every such
+ * address, which makes it a safe place to suspend a run.
+ */
+
+   bool isStatementStart(int pc) const;
+   const unsigned char *getStatementStarts() const;
+
+private:
+
+   std::vector<int> code;
+   std::vector<int> lines;
+   std::vector<unsigned char> starts;
+   int maxStack;
+   int depth;
+
+/* The arrays actually in use, which are either the vectors above or
+   arrays supplied to attach */
+
+   const int *codeView;
+   const int *lineView;
+   const unsigned char *startView;
+   int viewSize;
+
+   void compileLine(Statement *stmt, LineCode & lineCode);
+   void compileStatement(Statement *stmt, LineCode & lineCode);
+   void compileExpression(Expression *exp, ValueKind kind = INT_VALUE);
+   void compileConstant(ConstantExp *constant, ValueKind kind);
+   void compileConversion(ValueKind from, ValueKind to);
+   void compileIndex(ArrayExp *element);
+   void emit(Opcode op);
+   void emit(Opcode op, int operand);
+   void emit(Opcode op, int first, int second);
+   void emit(Opcode op, int first, int second, int third);
+   void emit(Opcode op, int first, int second, int third, int fourth);
+   void emit(Opcode op, const LoopControl & control, int operand);
+   void adjustStack(int delta);
+
+/* Copying would leave the views pointing into the original */
+
+   Bytecode(const Bytecode &);
+   Bytecode & operator=(const Bytecode &);
+
+};
+
+#endif
@@ -0,0 +1,375 @@
+/*
+ * File: cache.cpp
+ * ---------------
+ * This file implements the CodeCache class.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "bytecode.h"
+#include "cache.h"
+#include "evalstate.h"
+#include "matrix.h"
+
+#ifdef _WIN32
+#  define CACHE_MMAP 0
+#else
+#  define CACHE_MMAP 1
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+using namespace std;
+
+/*
+ * Implementation notes: file format
+ * ---------------------------------
+ * A cache file is a fixed header followed by four sections:
+ *
+ *   1. the instruction words, as 32-bit integers
+ *   2. the line number of each word, as 32-bit integers
+ *   3. one byte for each word, nonzero where a statement begins,
+ *      padded with zeros to a multiple of four bytes
+ *   4. the variable names in slot order, each ending with a null
+ *
+ * Every section begins at a multiple of four bytes, so the words can be
+ * used in place once the file is mapped.  Integers are stored in the
+ * byte order of the machine that wrote the file; the header records
+ * that order, and a file from a machine with a different one is simply
+ * rejected.  The header also holds an FNV-1a hash of the four sections,
+ * so that a file damaged after it was written is detected.
+ * CACHE_VERSION must change whenever the instruction set or the layout
+ * changes.
+ */
+
+static const char CACHE_MAGIC[4] = { 'B', 'A', 'S', 'C' };
+static const uint32_t CACHE_VERSION = 8;
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+static const uint32_t PAYLOAD_HASH_BASIS = 2166136261u;
+
+struct CacheHeader {
+   char magic[4];
+   uint32_t version;
+   uint32_t byteOrder;
+   uint32_t codeSize;
+   uint64_t sourceHash;
+   int32_t maxStack;
+   uint32_t nameCount;
+   uint32_t nameBytes;
+   uint32_t payloadHash;
+   uint32_t eliminatedNodes;
+};
+
+/* Private function prototypes */
+
+static size_t padToWord(size_t n);
+static uint32_t hashBytes(const void *data, size_t n, uint32_t hash);
+static bool checkCode(const int *code, const unsigned char *starts, int n,
+                      int maxStack, int nameCount);
+
+CodeCache::CodeCache() {
+   memory = NULL;
+   length = 0;
+   eliminated = 0;
+}
+
+CodeCache::~CodeCache() {
+   release();
+}
+
+unsigned long long CodeCache::hashSource(const string & source) {
+   uint64_t hash = 14695981039346656037ULL;
+   for (size_t i = 0; i < source.length(); i++) {
+      hash = (hash ^ (unsigned char) source[i]) * 1099511628211ULL;
+   }
+   return hash;
+}
+
+bool CodeCache::save(const string & filename, unsigned long long hash,
+                     const Bytecode & code, const EvalState & state, int eliminated) {
+   int n = code.size();
+   string names;
+   for (int i = 0; i < state.getSlotCount(); i++) {
+      names += state.getName(i);
+      names += '\0';
+   }
+   CacheHeader header;
+   memset(&header, 0, sizeof header);
+   memcpy(header.magic, CACHE_MAGIC, sizeof CACHE_MAGIC);
+   header.version = CACHE_VERSION;
+   header.byteOrder = BYTE_ORDER_MARK;
+   header.codeSize = n;
+   header.sourceHash = hash;
+   header.maxStack = code.getMaxStack();
+   header.nameCount = state.getSlotCount();
+   header.nameBytes = names.length();
+   header.eliminatedNodes = eliminated;
+   vector<int> lines(n);
+   vector<unsigned char> starts(padToWord(n), 0);
+   for (int pc = 0; pc < n; pc++) {
+      lines[pc] = code.getLineNumber(pc);
+      starts[pc] = code.isStatementStart(pc);
+   }
+   string temp = filename + ".tmp";
+   ofstream out(temp.c_str(), ios::binary | ios::trunc);
+   if (out.fail()) return false;
+   uint32_t payloadHash = PAYLOAD_HASH_BASIS;
+   if (n > 0) {
+      payloadHash = hashBytes(code.getCode(), n * sizeof(int), payloadHash);
+      payloadHash = hashBytes(&lines[0], n * sizeof(int), payloadHash);
+      payloadHash = hashBytes(&starts[0], starts.size(), payloadHash);
+   }
+   header.payloadHash = hashBytes(names.data(), names.length(), payloadHash);
+   out.write((const char *) &header, sizeof header);
+   if (n > 0) {
+      out.write((const char *) code.getCode(), n * sizeof(int));
+      out.write((const char *) &lines[0], n * sizeof(int));
+      out.write((const char *) &starts[0], starts.size());
+   }
+   out.write(names.data(), names.length());
+   out.close();
+   if (out.fail()) {
+      remove(temp.c_str());
+      return false;
+   }
+#ifdef _WIN32
+   remove(filename.c_str());
+#endif
+   if (rename(temp.c_str(), filename.c_str()) != 0) {
+      remove(temp.c_str());
+      return false;
+   }
+   return true;
+}
+
+bool CodeCache::load(const string & filename, unsigned long long hash, EvalState & state) {
+   release();
+   if (!readFile(filename)) return false;
+   if (!attachFile(hash, state)) {
+      release();
+      return false;
+   }
+   return true;
+}
+
+const Bytecode & CodeCache::getBytecode() const {
+   return code;
+}
+
+int CodeCache::getEliminatedNodes() const {
+   return eliminated;
+}
+
+bool CodeCache::isMapped() const {
+   return memory != NULL && relocated.empty();
+}
+
+void CodeCache::release() {
+   code.clear();
+   relocated.clear();
+   eliminated = 0;
+   buffer.clear();
+#if CACHE_MMAP
+   if (memory != NULL) munmap(memory, length);
+#endif
+   memory = NULL;
+   length = 0;
+}
+
+/*
+ * Implementation notes: readFile
+ * ------------------------------
+ * Where mmap is available the file is mapped read-only, so that the
+ * pages are shared with the system's file cache and only those the
+ * program touches are ever read.  Elsewhere the file is read into a
+ * buffer of ints, which gives the same alignment.
+ */
+
+bool CodeCache::readFile(const string & filename) {
+#if CACHE_MMAP
+   int fd = open(filename.c_str(), O_RDONLY);
+   if (fd < 0) return false;
+   struct stat info;
+   if (fstat(fd, &info) != 0 || info.st_size < (off_t) sizeof(CacheHeader)) {
+      close(fd);
+      return false;
+   }
+   void *block = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if (block == MAP_FAILED) return false;
+   memory = block;
+   length = info.st_size;
+   return true;
+#else
+   ifstream in(filename.c_str(), ios::binary);
+   if (in.fail()) return false;
+   in.seekg(0, ios::end);
+   streamoff size = in.tellg();
+   if (size < (streamoff) sizeof(CacheHeader)) return false;
+   in.seekg(0, ios::beg);
+   buffer.resize((size + sizeof(int) - 1) / sizeof(int));
+   if (!in.read((char *) &buffer[0], size)) return false;
+   length = size;
+   return true;
+#endif
+}
+
+/*
+ * Implementation notes: attachFile
+ * --------------------------------
+ * Everything in the header is checked before any section is touched.
+ * The hash of the sections must then match the one in the header, and
+ * the code itself is checked by checkCode, so that a damaged file is
+ * rejected rather than run.  The hash reads every page of the file,
+ * most of which checkCode reads anyway, and both together cost far
+ * less than compiling the program.  The slots are then looked up by
+ * name in the EvalState.  In a fresh state they come out in the same
+ * order as when the file was written, and the code can be used where
+ * it lies.
+ */
+
+bool CodeCache::attachFile(unsigned long long hash, EvalState & state) {
+   const char *base = (memory != NULL) ? (const char *) memory : (const char *) &buffer[0];
+   CacheHeader header;
+   memcpy(&header, base, sizeof header);
+   if (memcmp(header.magic, CACHE_MAGIC, sizeof CACHE_MAGIC) != 0) return false;
+   if (header.version != CACHE_VERSION || header.byteOrder != BYTE_ORDER_MARK) return false;
+   if (header.sourceHash != hash) return false;
+   size_t n = header.codeSize;
+   if (n == 0 || n > length / (2 * sizeof(int))) return false;
+   size_t codeOffset = sizeof header;
+   size_t lineOffset = codeOffset + n * sizeof(int);
+   size_t startOffset = lineOffset + n * sizeof(int);
+   size_t nameOffset = startOffset + padToWord(n);
+   if (nameOffset > length || length - nameOffset != header.nameBytes) return false;
+   if (hashBytes(base + codeOffset, length - codeOffset, PAYLOAD_HASH_BASIS)
+       != header.payloadHash) {
+      return false;
+   }
+   const int *words = (const int *) (base + codeOffset);
+   const int *lines = (const int *) (base + lineOffset);
+   const unsigned char *starts = (const unsigned char *) (base + startOffset);
+   const char *names = base + nameOffset;
+   if (header.nameBytes > 0 && names[header.nameBytes - 1] != '\0') return false;
+   size_t nameCount = 0;
+   for (size_t i = 0; i < header.nameBytes; i++) {
+      if (names[i] == '\0') nameCount++;
+   }
+   if (nameCount != header.nameCount) return false;
+   if (!checkCode(words, starts, n, header.maxStack, nameCount)) return false;
+   vector<int> slots;
+   for (size_t offset = 0; offset < header.nameBytes; offset += strlen(names + offset) + 1) {
+      slots.push_back(state.getSlot(names + offset));
+   }
+   bool moved = false;
+   for (size_t i = 0; i < slots.size(); i++) {
+      if (slots[i] != (int) i) moved = true;
+   }
+   if (moved) {
+      relocated.assign(words, words + n);
+      for (size_t pc = 0; pc < n; pc += 1 + getOperandCount(Opcode(words[pc]))) {
+         Opcode op = Opcode(words[pc]);
+         for (int k = 1; k <= getOperandCount(op); k++) {
+            if (getOperandKind(op, k) == OPERAND_SLOT) {
+               relocated[pc + k] = slots[words[pc + k]];
+            }
+         }
+      }
+      words = &relocated[0];
+   }
+   code.attach(words, lines, starts, n, header.maxStack);
+   eliminated = header.eliminatedNodes;
+   return true;
+}
+
+static size_t padToWord(size_t n) {
+   return (n + 3) & ~(size_t) 3;
+}
+
+/*
+ * Function: hashBytes
+ * Usage: hash = hashBytes(data, n, hash);
+ * ---------------------------------------
+ * Continues the 32-bit FNV-1a hash of a sequence of bytes with the n
+ * bytes at data, so that sections written separately hash the same as
+ * the file that holds them.  Every hash begins as PAYLOAD_HASH_BASIS.
+ */
+
+static uint32_t hashBytes(const void *data, size_t n, uint32_t hash) {
+   const unsigned char *bytes = (const unsigned char *) data;
+   for (size_t i = 0; i < n; i++) {
+      hash = (hash ^ bytes[i]) * 16777619u;
+   }
+   return hash;
+}
+
+/*
+ * Function: checkCode
+ * Usage: if (checkCode(code, starts, n, maxStack, nameCount)) . . .
+ * -----------------------------------------------------------------
+ * Returns true if the code could have been produced by the compiler:
+ * every opcode is known, every operand fits in the code, every slot is
+ * one of the names in the file, every jump lands on the start of a
+ * statement or on the final END, every GOSUB is followed by such an
+ * address for RETURN to go back to, every MAT names an operation that
+ * takes no factor from the stack, every RESTORE is followed by as many
+ * DATA instructions as it counts, the operand stack is empty at each
+ * statement boundary and never underflows or exceeds maxStack, and the
+ * last instruction is END.  The virtual machine relies on all of these.
+ * The position of an array element whose subscripts the compiler found
+ * to be in range is ordinary arithmetic that cannot be checked here;
+ * for that, and for the values of its constants, the code is trusted to
+ * be the translation of the source whose hash it carries, and the hash
+ * of the sections guards it against damage.
+ */
+
+static bool checkCode(const int *code, const unsigned char *starts, int n,
+                      int maxStack, int nameCount) {
+   if (maxStack < 0) return false;
+   int depth = 0;
+   int pc = 0;
+   int last = -1;
+   while (pc < n) {
+      if (code[pc] < 0 || code[pc] >= OP_COUNT) return false;
+      Opcode op = Opcode(code[pc]);
+      int operands = getOperandCount(op);
+      if (operands >= n - pc) return false;
+      if (starts[pc] && depth != 0) return false;
+      if (depth < getStackInputs(op)) return false;
+      depth += getStackEffect(op);
+      if (depth > maxStack) return false;
+      for (int k = 1; k <= operands; k++) {
+         int operand = code[pc + k];
+         if (starts[pc + k]) return false;
+         OperandKind kind = getOperandKind(op, k);
+         if (kind == OPERAND_SLOT && (operand < 0 || operand >= nameCount)) return false;
+         if (kind == OPERAND_ADDRESS) {
+            if (operand < 0 || operand >= n || depth != 0) return false;
+            if (!starts[operand] && operand != n - 1) return false;
+         }
+      }
+      if (op == OP_GOSUB && (pc + 2 >= n || (!starts[pc + 2] && pc + 2 != n - 1))) {
+         return false;
+      }
+      if (op == OP_MAT && (code[pc + 1] < 0 || code[pc + 1] >= MAT_COUNT
+                           || code[pc + 1] == MAT_SCALE)) {
+         return false;
+      }
+      if (op == OP_RESTORE) {
+         int count = code[pc + 1];
+         if (count < 0 || count > (n - pc - 2) / 2) return false;
+         for (int k = 0; k < count; k++) {
+            if (code[pc + 2 + 2 * k] != OP_DATA) return false;
+         }
+      }
+      last = pc;
+      pc += 1 + operands;
+   }
+   return last == n - 1 && code[last] == OP_END && depth == 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * File: cache.h
+ * -------------
+ * This interface exports the CodeCache class, which stores compiled
+ * programs on disk so that they can be run later without parsing the
+ * source again.
+ */
+
+#ifndef _cache_h
+#define _cache_h
+
+#include <string>
+#include <vector>
+#include "bytecode.h"
+#include "evalstate.h"
+
+/*
+ * Class: CodeCache
+ * ----------------
+ * This class reads and writes cache files, each of which holds one
+ * compiled and linked program: the instruction words with every jump
+ * already resolved to an address, the line table, the statement
+ * boundaries, and the names of the variables whose slots the code
+ * refers to.  Each file also records a hash of the source from which
+ * it was compiled, and a file whose hash does not match the current
+ * source is rejected, so a cache can never run an out-of-date program.
+ *
+ * Where the system supports it, a cache file is loaded by mapping it
+ * into memory, and the virtual machine runs the instructions in place.
+ */
+
+class CodeCache {
+
+public:
+
+/*
+ * Constructor: CodeCache
+ * Usage: CodeCache cache;
+ * -----------------------
+ * Creates an object with no program loaded.
+ */
+
+   CodeCache();
+
+/*
+ * Destructor: ~CodeCache
+ * Usage: usually implicit
+ * -----------------------
+ * Releases the loaded file, if any.
+ */
+
+   ~CodeCache();
+
+/*
+ * Method: hashSource
+ * Usage: unsigned long long hash = CodeCache::hashSource(source);
+ * ---------------------------------------------------------------
+ * Returns the 64-bit FNV-1a hash of the source text, which is the key
+ * that identifies a cache file.
+ */
+
+   static unsigned long long hashSource(const std::string & source);
+
+/*
+ * Method: save
+ * Usage: if (CodeCache::save(filename, hash, code, state, eliminated)) . . .
+ * -------------------------------------------------------------------------
+ * Writes the compiled code, together with the names of the variables
+ * in state, the source hash and the number of expression nodes that
+ * the optimizer eliminated, to the named file, and returns true if the
+ * file was written.  The file is written under a temporary name
+ * and then renamed, so a reader never sees a partial file.
+ */
+
+   static bool save(const std::string & filename, unsigned long long hash,
+                    const Bytecode & code, const EvalState & state, int eliminated);
+
+/*
+ * Method: load
+ * Usage: if (cache.load(filename, hash, state)) . . .
+ * ---------------------------------------------------
+ * Loads the named cache file, replacing any file loaded earlier, and
+ * returns true if it holds a valid program compiled from source with
+ * the specified hash.  The variables the program uses are given slots
+ * in state; if those differ from the slots recorded in the file, the
+ * code is copied and its slot operands rewritten.  The method returns
+ * false, leaving nothing loaded, if the file is missing, stale, written
+ * by a different version of the interpreter, or damaged.
+ */
+
+   bool load(const std::string & filename, unsigned long long hash, EvalState & state);
+
+/*
+ * Method: getBytecode
+ * Usage: const Bytecode & code = cache.getBytecode();
+ * ---------------------------------------------------
+ * Returns the loaded program, which may be passed to executeBytecode
+ * or compiled by JitCode.  It remains valid until the next call to
+ * load or until this object is destroyed.
+ */
+
+   const Bytecode & getBytecode() const;
+
+/*
+ * Method: getEliminatedNodes
+ * Usage: int eliminated = cache.getEliminatedNodes();
+ * ---------------------------------------------------
+ * Returns the number of expression nodes that the optimizer eliminated
+ * when the loaded program was compiled, so that a run from the cache
+ * reports the same statistics as the run that wrote it.
+ */
+
+   int getEliminatedNodes() const;
+
+/*
+ * Method: isMapped
+ * Usage: if (cache.isMapped()) . . .
+ * ----------------------------------
+ * Returns true if the loaded program runs directly from the mapped
+ * file, without having been copied.
+ */
+
+   bool isMapped() const;
+
+private:
+
+   Bytecode code;               /* The program, viewed in place        */
+   void *memory;                /* The mapped file, or NULL            */
+   size_t length;               /* The length of the mapping           */
+   std::vector<int> buffer;     /* The file, where it cannot be mapped */
+   std::vector<int> relocated;  /* The code, if its slots had to move  */
+   int eliminated;              /* The nodes the optimizer removed     */
+
+   void release();
+   bool readFile(const std::string & filename);
+   bool attachFile(unsigned long long hash, EvalState & state);
+
+/* Copying would duplicate the mapping */
+
+   CodeCache(const CodeCache &);
+   CodeCache & operator=(const CodeCache &);
+
+};
+
+#endif
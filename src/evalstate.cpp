@@ -7,40 +7,187 @@
  */
 
 #include <string>
+#include "error.h"
 #include "evalstate.h"
-#include "map.h"
+#include "hashmap.h"
+#include "simpio.h"
+#include "strlib.h"
 using namespace std;
 
 /* Implementation of the EvalState class */
 
 EvalState::EvalState() {
-   /* Empty */
+   nextStatement = NULL;
+   input = NULL;
+   dataPosition = 0;
+   setReturnCapacity(DEFAULT_RETURN_CAPACITY);
 }
 
 EvalState::~EvalState() {
    /* Empty */
 }
 
+int EvalState::getSlot(const string & var) {
+   if (slotTable.containsKey(var)) return slotTable.get(var);
+   int slot = names.size();
+   slotTable.put(var, slot);
+   names.push_back(var);
+   values.push_back(0);
+   longValues.push_back(0);
+   realValues.push_back(0);
+   if ((slot & 31) == 0) defined.push_back(0);
+   ArrayInfo empty = { NULL, 0, 0, 0 };
+   arrays.push_back(empty);
+   return slot;
+}
+
+int EvalState::getArraySlot(const string & name) {
+   return getSlot(name + "()");
+}
+
+const string & EvalState::getName(int slot) const {
+   return names[slot];
+}
+
+int EvalState::getSlotCount() const {
+   return names.size();
+}
+
 void EvalState::setValue(string var, int value) {
-   symbolTable.put(var, value);
+   setValue(getSlot(var), value);
 }
 
 int EvalState::getValue(string var) {
-   return symbolTable.get(var);
+   if (!slotTable.containsKey(var)) return 0;
+   return getValue(slotTable.get(var));
 }
 
 bool EvalState::isDefined(string var) {
-   return symbolTable.containsKey(var);
+   return slotTable.containsKey(var) && isDefined(slotTable.get(var));
+}
+
+int *EvalState::getValueArray() {
+   return values.empty() ? NULL : &values[0];
+}
+
+unsigned *EvalState::getDefinedArray() {
+   return defined.empty() ? NULL : &defined[0];
+}
+
+/*
+ * Implementation notes: dimension
+ * -------------------------------
+ * Each array keeps its elements in its own vector, so the storage of
+ * the other arrays stays where it is when one is dimensioned again.
+ */
+
+void EvalState::dimension(int slot, int rows, int columns) {
+    long long size = (long long) rows * ((columns == 0) ? 1 : columns);
+    if (rows <= 0 || columns < 0 || size > MAX_ARRAY_SIZE) {
+        error("DIM: illegal size for array " + names[slot].substr(0, names[slot].length() - 2));
+    }
+    if ((int) arrayStorage.size() <= slot) arrayStorage.resize(slot + 1);
+    arrayStorage[slot].assign(size, 0);
+    ArrayInfo & array = arrays[slot];
+    array.elements = &arrayStorage[slot][0];
+    array.length = (columns == 0) ? rows : 0;
+    array.rows = (columns == 0) ? 0 : rows;
+    array.columns = columns;
+}
+
+void EvalState::subscriptError(int slot) const {
+    string name = names[slot].substr(0, names[slot].length() - 2);
+    if (arrays[slot].elements == NULL) error("Array " + name + " is not dimensioned");
+    error("Subscript out of range for " + name);
+}
+
+ArrayInfo *EvalState::getArrayTable() {
+    return arrays.empty() ? NULL : &arrays[0];
+}
+
+void EvalState::setNextStatement(Statement *stmt) {
+    nextStatement = stmt;
+}
+
+Statement *EvalState::getNextStatement() {
+    return nextStatement;
 }
 
-void EvalState::setCurrentLine(int lineNumber) {
-    currentLine = lineNumber;
+void EvalState::setInputStream(istream *stream) {
+    input = stream;
 }
 
-int EvalState::getCurrentLine() {
-    return currentLine;
+bool EvalState::hasInputStream() const {
+    return input != NULL;
+}
+
+int EvalState::readInput() {
+    output.flush();
+    if (input == NULL) return getInteger(" ? ");
+    string line;
+    if (!getline(*input, line)) error("INPUT: no more input data");
+    line = trim(line);
+    if (!stringIsInteger(line)) error("INPUT: illegal integer \"" + line + "\"");
+    return stringToInteger(line);
+}
+
+void EvalState::clearData() {
+    data.clear();
+    dataPosition = 0;
+}
+
+void EvalState::addData(int value) {
+    data.push_back(value);
+}
+
+int EvalState::readData() {
+    if (dataPosition == data.size()) error("READ: no more DATA");
+    return data[dataPosition++];
+}
+
+OutputBuffer & EvalState::getOutput() {
+    return output;
 }
 
 void EvalState::clearVariableList() {
-    symbolTable.clear();
+    defined.assign(defined.size(), 0);
+    ArrayInfo empty = { NULL, 0, 0, 0 };
+    arrays.assign(arrays.size(), empty);
+    arrayStorage.clear();
+    clearReturns();
+}
+
+void EvalState::clearReturns() {
+    returns.depth = 0;
+}
+
+/*
+ * Implementation notes: setReturnCapacity
+ * ---------------------------------------
+ * The storage always has at least one entry, so that the array pointer
+ * is valid even when no GOSUB is allowed.
+ */
+
+void EvalState::setReturnCapacity(int capacity) {
+    if (capacity < 0) error("setReturnCapacity: capacity must not be negative");
+    returnStorage.assign(capacity + 1, NULL);
+    returns.addresses = &returnStorage[0];
+    returns.depth = 0;
+    returns.capacity = capacity;
+}
+
+int EvalState::getReturnCapacity() const {
+    return returns.capacity;
+}
+
+ReturnStack *EvalState::getReturnStack() {
+    return &returns;
+}
+
+void EvalState::returnOverflow() const {
+    error("More than " + integerToString(returns.capacity) + " nested GOSUB calls");
+}
+
+void EvalState::returnUnderflow() const {
+    error("RETURN without GOSUB");
 }
@@ -9,8 +9,64 @@
 #ifndef _evalstate_h
 #define _evalstate_h
 
+#include <iostream>
 #include <string>
-#include "map.h"
+#include <vector>
+#include "hashmap.h"
+#include "output.h"
+
+class Statement;
+
+/*
+ * Constant: DEFAULT_RETURN_CAPACITY
+ * ---------------------------------
+ * The number of GOSUB statements that may be active at once unless
+ * setReturnCapacity chooses another limit.
+ */
+
+const int DEFAULT_RETURN_CAPACITY = 1000;
+
+/*
+ * Type: ReturnStack
+ * -----------------
+ * This structure describes the stack of return addresses used by GOSUB
+ * and RETURN: an array of capacity entries, of which the first depth
+ * are in use.  The array is allocated once, so a GOSUB costs no more
+ * than a bounds check and a store.
+ */
+
+struct ReturnStack {
+   const void **addresses;
+   int depth;
+   int capacity;
+};
+
+/*
+ * Constant: MAX_ARRAY_SIZE
+ * ------------------------
+ * The largest number of elements that a DIM statement may allocate.
+ */
+
+const int MAX_ARRAY_SIZE = 1 << 27;
+
+/*
+ * Type: ArrayInfo
+ * ---------------
+ * This structure describes the storage of one array.  The elements
+ * are laid out row by row in a single contiguous block.  For an array
+ * with one subscript, length is the number of elements and rows and
+ * columns are zero; for an array with two subscripts, length is zero.
+ * An array that has not been dimensioned has no elements and zero in
+ * every field, so that every subscript is out of range.  A subscript
+ * is therefore checked with a single unsigned comparison.
+ */
+
+struct ArrayInfo {
+   int *elements;
+   int length;
+   int rows;
+   int columns;
+};
 
 /*
  * Class: EvalState
@@ -22,6 +78,13 @@
  * is a symbol table that maps variable names into their values.
  * Several of the exercises, however, require you to include
  * additional information in the EvalState class.
+ *
+ * Each variable name is interned once and assigned a slot, which is
+ * a small integer index into a flat array of values.  A separate bit
+ * map records which slots have been assigned, so that references to
+ * undefined variables can still be reported.  Parsed programs refer
+ * to variables by slot, which makes each access a single array index
+ * rather than a search by name.
  */
 
 class EvalState {
@@ -46,6 +109,149 @@ public:
 
     ~EvalState();
 
+/*
+ * Method: getSlot
+ * Usage: int slot = state.getSlot(var);
+ * -------------------------------------
+ * Returns the slot assigned to the specified variable, assigning the
+ * next free slot if the name has not been seen before.  Slots remain
+ * valid for the lifetime of the EvalState, even across calls to
+ * clearVariableList.
+ */
+
+    int getSlot(const std::string & var);
+
+/*
+ * Method: getArraySlot
+ * Usage: int slot = state.getArraySlot(name);
+ * -------------------------------------------
+ * Returns the slot assigned to the array with the specified name.  An
+ * array is interned under its name followed by parentheses, so the
+ * array A and the simple variable A have different slots.
+ */
+
+    int getArraySlot(const std::string & name);
+
+/*
+ * Method: getName
+ * Usage: string var = state.getName(slot);
+ * ----------------------------------------
+ * Returns the name of the variable assigned to the specified slot.
+ */
+
+    const std::string & getName(int slot) const;
+
+/*
+ * Method: getSlotCount
+ * Usage: int n = state.getSlotCount();
+ * ------------------------------------
+ * Returns the number of slots assigned so far, which are numbered
+ * from zero.
+ */
+
+    int getSlotCount() const;
+
+/*
+ * Methods: setValue, getValue, isDefined
+ * Usage: state.setValue(slot, value);
+ *        int value = state.getValue(slot);
+ *        if (state.isDefined(slot)) . . .
+ * ----------------------------------------
+ * These methods are the slot-based counterparts of the methods below
+ * that take a variable name.  The slot must have been returned by
+ * getSlot on this object.
+ */
+
+    void setValue(int slot, int value);
+    int getValue(int slot) const;
+    bool isDefined(int slot) const;
+
+/*
+ * Methods: setLong, getLong, setDouble, getDouble
+ * Usage: state.setLong(slot, value);
+ *        long long value = state.getLong(slot);
+ *        state.setDouble(slot, value);
+ *        double value = state.getDouble(slot);
+ * ---------------------------------------------
+ * These methods are the counterparts of setValue and getValue for the
+ * variables whose names end in % and #, which hold 64-bit integers and
+ * doubles.  Each kind has an array of its own, indexed by the same
+ * slots, and shares the defined bits with the others.
+ */
+
+    void setLong(int slot, long long value);
+    long long getLong(int slot) const;
+    void setDouble(int slot, double value);
+    double getDouble(int slot) const;
+
+/*
+ * Methods: getValueArray, getDefinedArray
+ * Usage: int *values = state.getValueArray();
+ *        unsigned *defined = state.getDefinedArray();
+ * ----------------------------------------------------
+ * Return the arrays that hold the slot values and the defined bits,
+ * laid out as described under "slot access" below.  These exist for
+ * the native code generated by jit.h, which reads and writes the
+ * arrays directly.  The pointers remain valid until getSlot assigns a
+ * new slot.
+ */
+
+    int *getValueArray();
+    unsigned *getDefinedArray();
+
+/*
+ * Method: dimension
+ * Usage: state.dimension(slot, rows, columns);
+ * --------------------------------------------
+ * Gives the array at slot rows elements, or rows * columns elements
+ * if columns is not zero, all set to zero.  Any earlier contents of
+ * the array are discarded.
+ */
+
+    void dimension(int slot, int rows, int columns);
+
+/*
+ * Methods: checkIndex, getElement, setElement
+ * Usage: int index = state.checkIndex(slot, i);
+ *        int index = state.checkIndex(slot, row, column);
+ *        int value = state.getElement(slot, index);
+ *        state.setElement(slot, index, value);
+ * ---------------------------------------------------------
+ * The checkIndex methods return the position of an element in the
+ * array at slot given its one or two subscripts, raising an error if
+ * the array has not been dimensioned or a subscript is out of range.
+ * The getElement and setElement methods read and write an element by
+ * position without any check, so the position must be known to be in
+ * range.
+ */
+
+    int checkIndex(int slot, int index) const;
+    int checkIndex(int slot, int row, int column) const;
+    int getElement(int slot, int index) const;
+    void setElement(int slot, int index, int value);
+
+/*
+ * Method: subscriptError
+ * Usage: state.subscriptError(slot);
+ * ----------------------------------
+ * Raises the error for a bad subscript of the array at slot, which
+ * says whether the array has not been dimensioned or the subscript is
+ * out of range.
+ */
+
+    void subscriptError(int slot) const;
+
+/*
+ * Method: getArrayTable
+ * Usage: ArrayInfo *arrays = state.getArrayTable();
+ * -------------------------------------------------
+ * Returns the array descriptions, indexed by slot, for the native code
+ * generated by jit.h.  Like the value array, the pointer remains valid
+ * until getSlot assigns a new slot.
+ */
+
+    ArrayInfo *getArrayTable();
+
 /*
  * Method: setValue
  * Usage: state.setValue(var, value);
@@ -74,24 +280,71 @@ public:
     bool isDefined(std::string var);
 
 /*
- * Method: setCurrentLine()
- * Usage:
- * --------------------------------------
- *
+ * Methods: setNextStatement, getNextStatement
+ * Usage: state.setNextStatement(stmt);
+ *        Statement *next = state.getNextStatement();
+ * ---------------------------------------------------
+ * These methods record and return the statement that will execute
+ * after the current one.  Before each statement runs, the interpreter
+ * sets this to the statement's linked successor; GOTO, IF and END
+ * override it to transfer control.  A value of NULL stops the program.
  */
 
-    void setCurrentLine(int lineNumber);
+    void setNextStatement(Statement *stmt);
+    Statement *getNextStatement();
 
+/*
+ * Methods: setInputStream, hasInputStream
+ * Usage: state.setInputStream(&stream);
+ *        if (state.hasInputStream()) . . .
+ * ----------------------------------------
+ * Directs INPUT statements to read their values from the specified
+ * stream, one integer per line, instead of prompting at the console.
+ * Passing NULL restores console input.  The hasInputStream method
+ * returns true if a stream has been set.
+ */
 
+    void setInputStream(std::istream *stream);
+    bool hasInputStream() const;
 
- /*
- * Method: getCurrentLine()
- * Usage:
- * --------------------------------------
- *
+/*
+ * Method: readInput
+ * Usage: int value = state.readInput();
+ * -------------------------------------
+ * Returns the next value for an INPUT statement.  At the console this
+ * prompts until the user types an integer; from an input stream it
+ * reads the next line and raises an error if that line is not an
+ * integer or if the stream is exhausted.
+ */
+
+    int readInput();
+
+/*
+ * Methods: clearData, addData, readData
+ * Usage: state.clearData();
+ *        state.addData(value);
+ *        int value = state.readData();
+ * -------------------------------------
+ * These methods manage the values of the DATA statements, which a run
+ * collects in line order before it begins.  The readData method returns
+ * the next value that has not yet been read, and raises an error if
+ * none is left.
+ */
+
+    void clearData();
+    void addData(int value);
+    int readData();
+
+/*
+ * Method: getOutput
+ * Usage: OutputBuffer & out = state.getOutput();
+ * ----------------------------------------------
+ * Returns the buffer that collects the output of PRINT statements.
+ * The buffer is flushed before each INPUT statement reads a value;
+ * the interpreter is responsible for flushing it when a command ends.
  */
 
-    int getCurrentLine();
+    OutputBuffer & getOutput();
 
 /*
 * Method: clearVariableList()
@@ -102,14 +355,163 @@ public:
 
      void clearVariableList();
 
+/*
+ * Methods: pushReturn, popReturn, clearReturns
+ * Usage: state.pushReturn(address);
+ *        const void *address = state.popReturn();
+ *        state.clearReturns();
+ * --------------------------------------------
+ * These methods manage the stack of return addresses for GOSUB and
+ * RETURN.  An address is the point from which the engine running the
+ * program resumes, already linked: the tree walker pushes the statement
+ * after the GOSUB, the virtual machine a pointer into its code, and the
+ * native code a machine address, so RETURN needs no lookup.  The
+ * pushReturn method raises an error if the stack is full and popReturn
+ * if it is empty.  Every run begins by calling clearReturns.
+ */
+
+    void pushReturn(const void *address);
+    const void *popReturn();
+    void clearReturns();
+
+/*
+ * Methods: setReturnCapacity, getReturnCapacity
+ * Usage: state.setReturnCapacity(depth);
+ *        int depth = state.getReturnCapacity();
+ * -------------------------------------------
+ * These methods set and return the largest number of GOSUB statements
+ * that may be active at once.  Setting the capacity empties the stack.
+ */
+
+    void setReturnCapacity(int capacity);
+    int getReturnCapacity() const;
+
+/*
+ * Method: getReturnStack
+ * Usage: ReturnStack *stack = state.getReturnStack();
+ * ---------------------------------------------------
+ * Returns the return stack itself, for the native code generated by
+ * jit.h, which pushes and pops addresses without calling back.
+ */
+
+    ReturnStack *getReturnStack();
+
 
 private:
 
-    Map<std::string,int> symbolTable;
-    int currentLine;
+    HashMap<std::string,int> slotTable;
+    std::vector<std::string> names;
+    std::vector<int> values;
+    std::vector<long long> longValues;
+    std::vector<double> realValues;
+    std::vector<unsigned> defined;
+    std::vector<ArrayInfo> arrays;
+    std::vector<std::vector<int> > arrayStorage;
+    std::vector<int> data;
+    size_t dataPosition;
+    Statement *nextStatement;
+    std::istream *input;
+    OutputBuffer output;
+    std::vector<const void *> returnStorage;
+    ReturnStack returns;
+
+    void returnOverflow() const;
+    void returnUnderflow() const;
+
+/* Copying would leave the return stack pointing into the original */
+
+    EvalState(const EvalState &);
+    EvalState & operator=(const EvalState &);
 
 };
 
+/*
+ * Implementation notes: slot access
+ * ---------------------------------
+ * The slot-based accessors are defined inline because they sit on the
+ * hot path of every variable reference.  The defined bit for slot k
+ * lives in bit (k % 32) of word (k / 32) of the defined vector.
+ */
+
+inline void EvalState::setValue(int slot, int value) {
+    values[slot] = value;
+    defined[slot >> 5] |= 1u << (slot & 31);
+}
+
+inline int EvalState::getValue(int slot) const {
+    return values[slot];
+}
+
+inline bool EvalState::isDefined(int slot) const {
+    return (defined[slot >> 5] >> (slot & 31)) & 1;
+}
+
+inline void EvalState::setLong(int slot, long long value) {
+    longValues[slot] = value;
+    defined[slot >> 5] |= 1u << (slot & 31);
+}
+
+inline long long EvalState::getLong(int slot) const {
+    return longValues[slot];
+}
+
+inline void EvalState::setDouble(int slot, double value) {
+    realValues[slot] = value;
+    defined[slot >> 5] |= 1u << (slot & 31);
+}
+
+inline double EvalState::getDouble(int slot) const {
+    return realValues[slot];
+}
+
+/*
+ * Implementation notes: array access
+ * ----------------------------------
+ * The element accessors are inline for the same reason.  Casting the
+ * subscripts to unsigned folds the test for a negative subscript into
+ * the comparison with the bound.
+ */
+
+inline int EvalState::checkIndex(int slot, int index) const {
+    if ((unsigned) index >= (unsigned) arrays[slot].length) subscriptError(slot);
+    return index;
+}
+
+inline int EvalState::checkIndex(int slot, int row, int column) const {
+    const ArrayInfo & array = arrays[slot];
+    if ((unsigned) row >= (unsigned) array.rows
+            || (unsigned) column >= (unsigned) array.columns) {
+        subscriptError(slot);
+    }
+    return row * array.columns + column;
+}
+
+inline int EvalState::getElement(int slot, int index) const {
+    return arrays[slot].elements[index];
+}
+
+inline void EvalState::setElement(int slot, int index, int value) {
+    arrays[slot].elements[index] = value;
+}
+
+/*
+ * Implementation notes: return stack
+ * ----------------------------------
+ * The push and pop are inline for the same reason, since GOSUB and
+ * RETURN should cost no more than a GOTO.  The errors are raised out of
+ * line to keep the inline code small.
+ */
+
+inline void EvalState::pushReturn(const void *address) {
+    if (returns.depth == returns.capacity) returnOverflow();
+    returns.addresses[returns.depth++] = address;
+}
+
+inline const void *EvalState::popReturn() {
+    if (returns.depth == 0) returnUnderflow();
+    return returns.addresses[--returns.depth];
+}
+
 
 
 #endif
@@ -7,8 +7,10 @@
 #include <string>
 #include "error.h"
 #include "evalstate.h"
+#include "arena.h"
 #include "exp.h"
 #include "strlib.h"
+#include "value.h"
 using namespace std;
 
 /*
@@ -25,24 +27,109 @@ Expression::~Expression() {
    /* Empty */
 }
 
+long long Expression::evalLong(EvalState & state) {
+   return eval(state);
+}
+
+double Expression::evalDouble(EvalState & state) {
+   return eval(state);
+}
+
+ValueKind Expression::getKind() {
+   return INT_VALUE;
+}
+
+/*
+ * Implementation notes: stringToOperator, charToOperator, operatorToString
+ * ------------------------------------------------------------------------
+ * These functions translate between operator tokens and their
+ * decoded form.  They are called only while parsing or printing.
+ */
+
+OperatorType stringToOperator(const string & token) {
+   if (token.length() != 1) return ILLEGAL_OP;
+   return charToOperator(token[0]);
+}
+
+OperatorType charToOperator(char ch) {
+   switch (ch) {
+    case '=': return ASSIGN_OP;
+    case '+': return ADD_OP;
+    case '-': return SUB_OP;
+    case '*': return MUL_OP;
+    case '/': return DIV_OP;
+    case '<': return LESS_OP;
+    case '>': return GREATER_OP;
+    default: return ILLEGAL_OP;
+   }
+}
+
+string operatorToString(OperatorType op) {
+   switch (op) {
+    case ASSIGN_OP: case EQUAL_OP: return "=";
+    case ADD_OP: return "+";
+    case SUB_OP: return "-";
+    case MUL_OP: return "*";
+    case DIV_OP: return "/";
+    case LESS_OP: return "<";
+    case GREATER_OP: return ">";
+    default: return "?";
+   }
+}
+
 /*
  * Implementation notes: the ConstantExp subclass
  * ----------------------------------------------
- * The ConstantExp subclass declares a single instance variable that
- * stores the value of the constant.  The eval method doesn't use the
- * value of state but needs it to match the general prototype for eval.
+ * The ConstantExp subclass stores the kind of the constant and its
+ * value converted to each kind, which the constructor computes once so
+ * that every eval method simply returns a field.  The eval methods
+ * don't use the value of state but need it to match the general
+ * prototype for eval.
  */
 
 ConstantExp::ConstantExp(int value) {
+   this->kind = INT_VALUE;
    this->value = value;
+   this->longValue = value;
+   this->realValue = value;
+}
+
+ConstantExp::ConstantExp(long long value) {
+   this->kind = LONG_VALUE;
+   this->value = longToInt(value);
+   this->longValue = value;
+   this->realValue = (double) value;
+}
+
+ConstantExp::ConstantExp(double value) {
+   this->kind = DOUBLE_VALUE;
+   this->value = doubleToInt(value);
+   this->longValue = doubleToLong(value);
+   this->realValue = value;
 }
 
 int ConstantExp::eval(EvalState & state) {
    return value;
 }
 
+long long ConstantExp::evalLong(EvalState & state) {
+   return longValue;
+}
+
+double ConstantExp::evalDouble(EvalState & state) {
+   return realValue;
+}
+
+ValueKind ConstantExp::getKind() {
+   return kind;
+}
+
 string ConstantExp::toString() {
-   return integerToString(value);
+   switch (kind) {
+    case LONG_VALUE: return to_string(longValue);
+    case DOUBLE_VALUE: return realToString(realValue);
+    default: return integerToString(value);
+   }
 }
 
 ExpressionType ConstantExp::getType() {
@@ -53,21 +140,31 @@ int ConstantExp::getValue() {
    return value;
 }
 
+long long ConstantExp::getLongValue() {
+   return longValue;
+}
+
+double ConstantExp::getRealValue() {
+   return realValue;
+}
+
 /*
  * Implementation notes: the IdentifierExp subclass
  * ------------------------------------------------
- * The IdentifierExp subclass declares a single instance variable that
- * stores the name of the variable.  The implementation of eval must
- * look this variable up in the evaluation state.
+ * The IdentifierExp subclass declares instance variables that store
+ * the name of the variable and the slot assigned to it in the
+ * evaluation state.  The implementation of eval reads the slot
+ * directly; the name is needed only for error messages.
  */
 
 IdentifierExp::IdentifierExp(string name) {
    this->name = name;
+   this->slot = -1;
 }
 
 int IdentifierExp::eval(EvalState & state) {
-   if (!state.isDefined(name)) error(name + " is undefined");
-   return state.getValue(name);
+   if (!state.isDefined(slot)) error(name + " is undefined");
+   return state.getValue(slot);
 }
 
 string IdentifierExp::toString() {
@@ -82,6 +179,119 @@ string IdentifierExp::getName() {
    return name;
 }
 
+void IdentifierExp::setSlot(int slot) {
+   this->slot = slot;
+}
+
+int IdentifierExp::getSlot() {
+   return slot;
+}
+
+/*
+ * Implementation notes: conversions
+ * ---------------------------------
+ * The typed subclasses compute a value of type T and then convert it
+ * to the kind the caller asks for.  These overloads select the
+ * conversion from value.h, or none at all, by the type of the value,
+ * so that each instantiation compiles to straight-line code.
+ */
+
+static int toInt(long long value) {
+   return longToInt(value);
+}
+
+static int toInt(double value) {
+   return doubleToInt(value);
+}
+
+static long long toLong(long long value) {
+   return value;
+}
+
+static long long toLong(double value) {
+   return doubleToLong(value);
+}
+
+template <typename T>
+static T evalAs(Expression *exp, EvalState & state);
+
+template <>
+long long evalAs<long long>(Expression *exp, EvalState & state) {
+   return exp->evalLong(state);
+}
+
+template <>
+double evalAs<double>(Expression *exp, EvalState & state) {
+   return exp->evalDouble(state);
+}
+
+template <typename T>
+static ValueKind kindOf();
+
+template <>
+ValueKind kindOf<long long>() {
+   return LONG_VALUE;
+}
+
+template <>
+ValueKind kindOf<double>() {
+   return DOUBLE_VALUE;
+}
+
+/*
+ * Implementation notes: the TypedIdentifierExp subclass
+ * -----------------------------------------------------
+ * A typed variable keeps its value in the EvalState array for its
+ * kind, under the same slot and defined bit as any other variable.
+ */
+
+template <typename T>
+static T getSlotValue(EvalState & state, int slot);
+
+template <>
+long long getSlotValue<long long>(EvalState & state, int slot) {
+   return state.getLong(slot);
+}
+
+template <>
+double getSlotValue<double>(EvalState & state, int slot) {
+   return state.getDouble(slot);
+}
+
+template <typename T>
+TypedIdentifierExp<T>::TypedIdentifierExp(string name) : IdentifierExp(name) {
+   /* Empty */
+}
+
+template <typename T>
+T TypedIdentifierExp<T>::evalValue(EvalState & state) {
+   if (!state.isDefined(slot)) error(name + " is undefined");
+   return getSlotValue<T>(state, slot);
+}
+
+template <typename T>
+int TypedIdentifierExp<T>::eval(EvalState & state) {
+   return toInt(evalValue(state));
+}
+
+template <typename T>
+long long TypedIdentifierExp<T>::evalLong(EvalState & state) {
+   return toLong(evalValue(state));
+}
+
+template <typename T>
+double TypedIdentifierExp<T>::evalDouble(EvalState & state) {
+   return evalValue(state);
+}
+
+template <typename T>
+ValueKind TypedIdentifierExp<T>::getKind() {
+   return kindOf<T>();
+}
+
+template class TypedIdentifierExp<long long>;
+template class TypedIdentifierExp<double>;
+
 /*
  * Implementation notes: the CompoundExp subclass
  * ----------------------------------------------
@@ -90,15 +300,20 @@ string IdentifierExp::getName() {
  * evaluates the subexpressions recursively and then applies the operator.
  */
 
-CompoundExp::CompoundExp(string op, Expression *lhs, Expression *rhs) {
+CompoundExp::CompoundExp(OperatorType op, Expression *lhs, Expression *rhs) {
    this->op = op;
    this->lhs = lhs;
    this->rhs = rhs;
 }
 
+CompoundExp::CompoundExp(string op, Expression *lhs, Expression *rhs) {
+   this->op = stringToOperator(op);
+   this->lhs = lhs;
+   this->rhs = rhs;
+}
+
 CompoundExp::~CompoundExp() {
-   delete lhs;
-   delete rhs;
+   /* Empty */
 }
 
 /*
@@ -106,30 +321,39 @@ CompoundExp::~CompoundExp() {
  * --------------------------
  * The eval method for the compound expression case must check for the
  * assignment operator as a special case.  Unlike the arithmetic operators
- * the assignment operator does not evaluate its left operand.
+ * the assignment operator does not evaluate its left operand.  Because
+ * the operator was decoded by the parser, the dispatch is a single
+ * switch on an enumeration value.
  */
 
 int CompoundExp::eval(EvalState & state) {
-   if (op == "=") {
+   if (op == ASSIGN_OP) {
       if (lhs->getType() != IDENTIFIER) {
          error("Illegal variable in assignment");
       }
       int val = rhs->eval(state);
-      state.setValue(((IdentifierExp *) lhs)->getName(), val);
+      state.setValue(((IdentifierExp *) lhs)->getSlot(), val);
       return val;
    }
    int left = lhs->eval(state);
    int right = rhs->eval(state);
-   if (op == "+") return left + right;
-   if (op == "-") return left - right;
-   if (op == "*") return left * right;
-   if (op == "/") return left / right;
+   switch (op) {
+    case ADD_OP: return addInt(left, right);
+    case SUB_OP: return subtractInt(left, right);
+    case MUL_OP: return multiplyInt(left, right);
+    case DIV_OP:
+      if (right == 0) error("Division by zero");
+      return divideInt(left, right);
+    default:
+      break;
+   }
    error("Illegal operator in expression");
    return 0;
 }
 
 string CompoundExp::toString() {
-   return '(' + lhs->toString() + ' ' + op + ' ' + rhs->toString() + ')';
+   return '(' + lhs->toString() + ' ' + operatorToString(op) + ' '
+              + rhs->toString() + ')';
 }
 
 ExpressionType CompoundExp::getType() {
@@ -137,6 +361,10 @@ ExpressionType CompoundExp::getType() {
 }
 
 string CompoundExp::getOp() {
+   return operatorToString(op);
+}
+
+OperatorType CompoundExp::getOperator() {
    return op;
 }
 
@@ -147,3 +375,196 @@ Expression *CompoundExp::getLHS() {
 Expression *CompoundExp::getRHS() {
    return rhs;
 }
+
+void CompoundExp::setLHS(Expression *lhs) {
+   this->lhs = lhs;
+}
+
+void CompoundExp::setRHS(Expression *rhs) {
+   this->rhs = rhs;
+}
+
+/*
+ * Implementation notes: the TypedCompoundExp subclass
+ * ---------------------------------------------------
+ * The arithmetic itself is chosen by overloading on the type of the
+ * operands.  The 64-bit operations come from value.h, so that they
+ * wrap around on overflow; the operations on doubles follow the usual
+ * rules of floating-point arithmetic, except that dividing by zero is
+ * an error, as it is for integers.
+ */
+
+static long long applyOperator(OperatorType op, long long left, long long right) {
+   switch (op) {
+    case ADD_OP: return addLong(left, right);
+    case SUB_OP: return subtractLong(left, right);
+    case MUL_OP: return multiplyLong(left, right);
+    case DIV_OP:
+      if (right == 0) error("Division by zero");
+      return divideLong(left, right);
+    default:
+      break;
+   }
+   error("Illegal operator in expression");
+   return 0;
+}
+
+static double applyOperator(OperatorType op, double left, double right) {
+   switch (op) {
+    case ADD_OP: return left + right;
+    case SUB_OP: return left - right;
+    case MUL_OP: return left * right;
+    case DIV_OP:
+      if (right == 0) error("Division by zero");
+      return left / right;
+    default:
+      break;
+   }
+   error("Illegal operator in expression");
+   return 0;
+}
+
+template <typename T>
+TypedCompoundExp<T>::TypedCompoundExp(OperatorType op, Expression *lhs, Expression *rhs)
+      : CompoundExp(op, lhs, rhs) {
+   /* Empty */
+}
+
+template <typename T>
+T TypedCompoundExp<T>::evalValue(EvalState & state) {
+   T left = evalAs<T>(lhs, state);
+   T right = evalAs<T>(rhs, state);
+   return applyOperator(op, left, right);
+}
+
+template <typename T>
+int TypedCompoundExp<T>::eval(EvalState & state) {
+   return toInt(evalValue(state));
+}
+
+template <typename T>
+long long TypedCompoundExp<T>::evalLong(EvalState & state) {
+   return toLong(evalValue(state));
+}
+
+template <typename T>
+double TypedCompoundExp<T>::evalDouble(EvalState & state) {
+   return evalValue(state);
+}
+
+template <typename T>
+ValueKind TypedCompoundExp<T>::getKind() {
+   return kindOf<T>();
+}
+
+template class TypedCompoundExp<long long>;
+template class TypedCompoundExp<double>;
+
+/*
+ * Implementation notes: makeIdentifier, makeCompound
+ * --------------------------------------------------
+ * An operator on two ints remains an ordinary CompoundExp, so programs
+ * that use no suffixes build exactly the trees they always did.
+ */
+
+Expression *makeIdentifier(const string & name, Arena & arena) {
+   switch (getNameKind(name)) {
+    case LONG_VALUE: return arena.make<TypedIdentifierExp<long long> >(name);
+    case DOUBLE_VALUE: return arena.make<TypedIdentifierExp<double> >(name);
+    default: return arena.make<IdentifierExp>(name);
+   }
+}
+
+Expression *makeCompound(OperatorType op, Expression *lhs, Expression *rhs, Arena & arena) {
+   if (op == ASSIGN_OP) {
+      if (lhs->getKind() != INT_VALUE) error("Illegal variable in assignment");
+      return arena.make<CompoundExp>(op, lhs, rhs);
+   }
+   switch (widerKind(lhs->getKind(), rhs->getKind())) {
+    case LONG_VALUE: return arena.make<TypedCompoundExp<long long> >(op, lhs, rhs);
+    case DOUBLE_VALUE: return arena.make<TypedCompoundExp<double> >(op, lhs, rhs);
+    default: return arena.make<CompoundExp>(op, lhs, rhs);
+   }
+}
+
+/*
+ * Implementation notes: the ArrayExp subclass
+ * -------------------------------------------
+ * The ArrayExp subclass stores the name of the array, its subscripts,
+ * and its slot.  When the checks are off, the position of an element
+ * with two subscripts is computed from the number of columns that
+ * Program::link recorded, which saves reading it from the array.
+ */
+
+ArrayExp::ArrayExp(string name, Expression *row, Expression *column) {
+   this->name = name;
+   this->row = row;
+   this->column = column;
+   this->slot = -1;
+   this->checked = true;
+   this->columns = 0;
+}
+
+int ArrayExp::eval(EvalState & state) {
+   return state.getElement(slot, getIndex(state));
+}
+
+int ArrayExp::getIndex(EvalState & state) {
+   int index = row->eval(state);
+   if (column == NULL) {
+      return checked ? state.checkIndex(slot, index) : index;
+   }
+   int col = column->eval(state);
+   return checked ? state.checkIndex(slot, index, col) : index * columns + col;
+}
+
+string ArrayExp::toString() {
+   string str = name + '(' + row->toString();
+   if (column != NULL) str += ", " + column->toString();
+   return str + ')';
+}
+
+ExpressionType ArrayExp::getType() {
+   return ARRAY;
+}
+
+string ArrayExp::getName() {
+   return name;
+}
+
+Expression *ArrayExp::getRow() {
+   return row;
+}
+
+Expression *ArrayExp::getColumn() {
+   return column;
+}
+
+void ArrayExp::setRow(Expression *row) {
+   this->row = row;
+}
+
+void ArrayExp::setColumn(Expression *column) {
+   this->column = column;
+}
+
+void ArrayExp::setSlot(int slot) {
+   this->slot = slot;
+}
+
+int ArrayExp::getSlot() {
+   return slot;
+}
+
+void ArrayExp::setChecked(bool checked, int columns) {
+   this->checked = checked;
+   this->columns = columns;
+}
+
+bool ArrayExp::isChecked() {
+   return checked;
+}
+
+int ArrayExp::getColumns() {
+   return columns;
+}
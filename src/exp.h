@@ -9,16 +9,62 @@
 #ifndef _exp_h
 #define _exp_h
 
+#include "arena.h"
 #include "evalstate.h"
+#include "value.h"
 
 /*
  * Type: ExpressionType
  * --------------------
- * This enumerated type is used to differentiate the three different
- * expression types: CONSTANT, IDENTIFIER, and COMPOUND.
+ * This enumerated type is used to differentiate the four different
+ * expression types: CONSTANT, IDENTIFIER, COMPOUND, and ARRAY.
  */
 
-enum ExpressionType { CONSTANT, IDENTIFIER, COMPOUND };
+enum ExpressionType { CONSTANT, IDENTIFIER, COMPOUND, ARRAY };
+
+/*
+ * Type: OperatorType
+ * ------------------
+ * This enumerated type identifies the operators that can appear in a
+ * compound expression or in the condition of an IF statement.  The
+ * parser decodes each operator token into one of these values once,
+ * so that evaluation never needs to compare strings.
+ */
+
+enum OperatorType {
+   ASSIGN_OP, ADD_OP, SUB_OP, MUL_OP, DIV_OP, EQUAL_OP, LESS_OP, GREATER_OP,
+   ILLEGAL_OP
+};
+
+/*
+ * Function: stringToOperator
+ * Usage: OperatorType op = stringToOperator(token);
+ * -------------------------------------------------
+ * Returns the operator denoted by the token, or ILLEGAL_OP if the
+ * token is not an operator.  Note that "=" decodes as ASSIGN_OP; the
+ * IF statement reinterprets it as EQUAL_OP.
+ */
+
+OperatorType stringToOperator(const std::string & token);
+
+/*
+ * Function: charToOperator
+ * Usage: OperatorType op = charToOperator(ch);
+ * --------------------------------------------
+ * Returns the operator denoted by the single character ch, or
+ * ILLEGAL_OP if there is none.
+ */
+
+OperatorType charToOperator(char ch);
+
+/*
+ * Function: operatorToString
+ * Usage: string token = operatorToString(op);
+ * -------------------------------------------
+ * Returns the token that denotes the operator.
+ */
+
+std::string operatorToString(OperatorType op);
 
 /*
  * Class: Expression
@@ -26,12 +72,20 @@ enum ExpressionType { CONSTANT, IDENTIFIER, COMPOUND };
  * This class is used to represent a node in an expression tree.
  * Expression is an example of an abstract class, which defines
  * the structure and behavior of a set of classes but has no
- * objects of its own.  Any object must be one of the three
+ * objects of its own.  Any object must be one of the four
  * concrete subclasses of Expression:
  *
- *  1. ConstantExp   -- an integer constant
+ *  1. ConstantExp   -- a numeric constant
  *  2. IdentifierExp -- a string representing an identifier
  *  3. CompoundExp   -- two expressions combined by an operator
+ *  4. ArrayExp      -- an element of an array selected by subscripts
+ *
+ * Every expression also has a kind of value, which the parser settles
+ * when it builds the tree.  A variable has the kind given by the suffix
+ * of its name, and an operator has the wider of the kinds of its
+ * operands, so that an operator on 64-bit integers or doubles is a
+ * subclass of CompoundExp that does its arithmetic in that kind alone
+ * and never inspects a tag while it runs.
  *
  * The Expression class defines the interface common to all
  * Expression objects; each subclass provides its own specific
@@ -58,11 +112,11 @@ public:
 
 /*
  * Destructor: ~Expression
- * Usage: delete exp;
- * ------------------
- * The destructor deallocates the storage for this expression.
- * It must be declared virtual to ensure that the correct subclass
- * destructor is called when deleting an expression.
+ * Usage: usually implicit
+ * -----------------------
+ * Expressions are created in an Arena (see arena.h), which runs the
+ * destructor when it is cleared.  A compound expression does not free
+ * its subexpressions, which belong to the same arena.
  */
 
    virtual ~Expression();
@@ -77,6 +131,32 @@ public:
 
    virtual int eval(EvalState & state) = 0;
 
+/*
+ * Methods: evalLong, evalDouble
+ * Usage: long long value = exp->evalLong(state);
+ *        double value = exp->evalDouble(state);
+ * ----------------------------------------------
+ * Evaluate this expression and return its value as a 64-bit integer
+ * or as a double.  An expression whose kind is narrower widens its
+ * value, and one whose kind is wider converts it as described in
+ * value.h; eval likewise converts the value to an int.  The default
+ * implementations widen the result of eval, which is right for every
+ * expression of kind INT_VALUE.
+ */
+
+   virtual long long evalLong(EvalState & state);
+   virtual double evalDouble(EvalState & state);
+
+/*
+ * Method: getKind
+ * Usage: ValueKind kind = exp->getKind();
+ * ---------------------------------------
+ * Returns the kind of value that the expression computes, which is
+ * INT_VALUE unless a subclass says otherwise.
+ */
+
+   virtual ValueKind getKind();
+
 /*
  * Method: toString
  * Usage: string str = exp->toString();
@@ -91,7 +171,7 @@ public:
  * Usage: ExpressionType type = exp->getType();
  * --------------------------------------------
  * Returns the type of the expression, which must be one of the constants
- * CONSTANT, IDENTIFIER, or COMPOUND.
+ * CONSTANT, IDENTIFIER, COMPOUND, or ARRAY.
  */
 
    virtual ExpressionType getType() = 0;
@@ -101,7 +181,8 @@ public:
 /*
  * Class: ConstantExp
  * ------------------
- * This subclass represents a constant integer expression.
+ * This subclass represents a constant expression, whose kind is that
+ * of the value from which it was constructed.
  */
 
 class ConstantExp: public Expression {
@@ -110,13 +191,15 @@ public:
 
 /*
  * Constructor: ConstantExp
- * Usage: Expression *exp = new ConstantExp(value);
- * ------------------------------------------------
- * The constructor initializes a new integer constant expression
- * to the given value.
+ * Usage: Expression *exp = arena.make<ConstantExp>(value);
+ * --------------------------------------------------------
+ * The constructor initializes a new constant expression to the given
+ * value, which may be an int, a 64-bit integer or a double.
  */
 
    ConstantExp(int value);
+   ConstantExp(long long value);
+   ConstantExp(double value);
 
 /*
  * Prototypes for the virtual methods
@@ -126,22 +209,32 @@ public:
  */
 
    virtual int eval(EvalState & state);
+   virtual long long evalLong(EvalState & state);
+   virtual double evalDouble(EvalState & state);
+   virtual ValueKind getKind();
    virtual std::string toString();
    virtual ExpressionType getType();
 
 /*
- * Method: getValue
+ * Methods: getValue, getLongValue, getRealValue
  * Usage: int value = ((ConstantExp *) exp)->getValue();
- * -----------------------------------------------------
- * Returns the value field without calling eval and can be applied
- * only to an object known to be a ConstantExp.
+ *        long long value = ((ConstantExp *) exp)->getLongValue();
+ *        double value = ((ConstantExp *) exp)->getRealValue();
+ * -------------------------------------------------------------
+ * Return the value converted to each kind without calling eval and
+ * can be applied only to an object known to be a ConstantExp.
  */
 
    int getValue();
+   long long getLongValue();
+   double getRealValue();
 
 private:
 
+   ValueKind kind;
    int value;
+   long long longValue;
+   double realValue;
 
 };
 
@@ -157,8 +250,8 @@ public:
 
 /*
  * Constructor: IdentifierExp
- * Usage: Expression *exp = new IdentifierExp(name);
- * -------------------------------------------------
+ * Usage: Expression *exp = arena.make<IdentifierExp>(name);
+ * ---------------------------------------------------------
  * The constructor initializes a new identifier expression
  * for the variable named by name.
  */
@@ -186,9 +279,66 @@ public:
 
    std::string getName();
 
-private:
+/*
+ * Methods: setSlot, getSlot
+ * Usage: ((IdentifierExp *) exp)->setSlot(state.getSlot(name));
+ *        int slot = ((IdentifierExp *) exp)->getSlot();
+ * -------------------------------------------------------------
+ * These methods record and return the EvalState slot assigned to the
+ * variable.  The slot must be set by resolveSymbols before the
+ * expression is evaluated.
+ */
+
+   void setSlot(int slot);
+   int getSlot();
+
+protected:
 
    std::string name;
+   int slot;
+
+};
+
+/*
+ * Class: TypedIdentifierExp
+ * -------------------------
+ * This subclass of IdentifierExp represents a variable whose name ends
+ * in a type suffix.  The type parameter is long long for a variable
+ * whose name ends in % and double for one whose name ends in #; these
+ * are the only two instantiations.
+ */
+
+template <typename T>
+class TypedIdentifierExp : public IdentifierExp {
+
+public:
+
+/*
+ * Constructor: TypedIdentifierExp
+ * Usage: Expression *exp = makeIdentifier(name, arena);
+ * -----------------------------------------------------
+ * The constructor initializes a new identifier expression for the
+ * variable named by name.  Clients call makeIdentifier, which chooses
+ * the instantiation from the suffix of the name.
+ */
+
+   TypedIdentifierExp(std::string name);
+
+/*
+ * Prototypes for the virtual methods
+ * ----------------------------------
+ * These methods have the same prototypes as those in the Expression
+ * base class and don't require additional documentation.
+ */
+
+   virtual int eval(EvalState & state);
+   virtual long long evalLong(EvalState & state);
+   virtual double evalDouble(EvalState & state);
+   virtual ValueKind getKind();
+
+private:
+
+   T evalValue(EvalState & state);
 
 };
 
@@ -205,13 +355,15 @@ public:
 
 /*
  * Constructor: CompoundExp
- * Usage: Expression *exp = new CompoundExp(op, lhs, rhs);
- * -------------------------------------------------------
+ * Usage: Expression *exp = arena.make<CompoundExp>(op, lhs, rhs);
+ * ---------------------------------------------------------------
  * The constructor initializes a new compound expression
  * which is composed of the operator (op) and the left and
- * right subexpression (lhs and rhs).
+ * right subexpression (lhs and rhs).  The operator may be
+ * given either as an OperatorType or as its token.
  */
 
+   CompoundExp(OperatorType op, Expression *lhs, Expression *rhs);
    CompoundExp(std::string op, Expression *lhs, Expression *rhs);
 
 /*
@@ -227,24 +379,205 @@ public:
    virtual ExpressionType getType();
 
 /*
- * Methods: getOp, getLHS, getRHS
+ * Methods: getOp, getOperator, getLHS, getRHS
  * Usage: string op = ((CompoundExp *) exp)->getOp();
+ *        OperatorType op = ((CompoundExp *) exp)->getOperator();
  *        Expression *lhs = ((CompoundExp *) exp)->getLHS();
  *        Expression *rhs = ((CompoundExp *) exp)->getRHS();
  * ---------------------------------------------------------
  * These methods return the components of a compound node and can
- * be applied only to an object known to be a CompoundExp.
+ * be applied only to an object known to be a CompoundExp.  The
+ * getOp method returns the operator as a token, and getOperator
+ * returns its decoded form.
  */
 
    std::string getOp();
+   OperatorType getOperator();
    Expression *getLHS();
    Expression *getRHS();
 
-private:
+/*
+ * Methods: setLHS, setRHS
+ * Usage: ((CompoundExp *) exp)->setLHS(lhs);
+ *        ((CompoundExp *) exp)->setRHS(rhs);
+ * -----------------------------------------
+ * These methods replace a subexpression, which lets an optimization
+ * pass rearrange a tree.  The old subexpression is not freed; like the
+ * new one, it belongs to the arena in which it was created.
+ */
 
-   std::string op;
+   void setLHS(Expression *lhs);
+   void setRHS(Expression *rhs);
+
+protected:
+
+   OperatorType op;
    Expression *lhs, *rhs;
 
 };
 
+/*
+ * Class: TypedCompoundExp
+ * -----------------------
+ * This subclass of CompoundExp applies an arithmetic operator to
+ * 64-bit integers, when the type parameter is long long, or to
+ * doubles, when it is double.  Both operands are evaluated in that
+ * kind, whatever their own kinds, and the result is converted only
+ * when the caller asks for another kind.  As with the int operations
+ * in value.h, 64-bit integer arithmetic wraps around on overflow, and
+ * division by zero is an error in either kind.
+ */
+
+template <typename T>
+class TypedCompoundExp : public CompoundExp {
+
+public:
+
+/*
+ * Constructor: TypedCompoundExp
+ * Usage: Expression *exp = makeCompound(op, lhs, rhs, arena);
+ * -----------------------------------------------------------
+ * The constructor initializes a new compound expression.  Clients
+ * call makeCompound, which chooses the instantiation from the kinds of
+ * the operands.
+ */
+
+   TypedCompoundExp(OperatorType op, Expression *lhs, Expression *rhs);
+
+/*
+ * Prototypes for the virtual methods
+ * ----------------------------------
+ * These methods have the same prototypes as those in the Expression
+ * base class and don't require additional documentation.
+ */
+
+   virtual int eval(EvalState & state);
+   virtual long long evalLong(EvalState & state);
+   virtual double evalDouble(EvalState & state);
+   virtual ValueKind getKind();
+
+private:
+
+   T evalValue(EvalState & state);
+
+};
+
+/*
+ * Functions: makeIdentifier, makeCompound
+ * Usage: Expression *exp = makeIdentifier(name, arena);
+ *        Expression *exp = makeCompound(op, lhs, rhs, arena);
+ * -----------------------------------------------------------
+ * Create an identifier or compound expression of the right class for
+ * its kind in the arena.  An identifier has the kind given by the
+ * suffix of its name, and a compound expression has the wider of the
+ * kinds of its operands.  Only a variable without a suffix may appear
+ * on the left of the assignment operator.
+ */
+
+Expression *makeIdentifier(const std::string & name, Arena & arena);
+Expression *makeCompound(OperatorType op, Expression *lhs, Expression *rhs, Arena & arena);
+
+/*
+ * Class: ArrayExp
+ * ---------------
+ * This subclass represents an element of an array, selected by one or
+ * two subscripts.  The subscripts of A(I, J) are called the row and
+ * the column; an element with a single subscript has no column.
+ */
+
+class ArrayExp : public Expression {
+
+public:
+
+/*
+ * Constructor: ArrayExp
+ * Usage: Expression *exp = arena.make<ArrayExp>(name, row, column);
+ * -----------------------------------------------------------------
+ * The constructor initializes a new element of the array named name
+ * with the given subscripts.  The column is NULL if there is only one
+ * subscript.  The subscripts are checked until setChecked says
+ * otherwise.
+ */
+
+   ArrayExp(std::string name, Expression *row, Expression *column);
+
+/*
+ * Prototypes for the virtual methods
+ * ----------------------------------
+ * These methods have the same prototypes as those in the Expression
+ * base class and don't require additional documentation.
+ */
+
+   virtual int eval(EvalState & state);
+   virtual std::string toString();
+   virtual ExpressionType getType();
+
+/*
+ * Methods: getName, getRow, getColumn, setRow, setColumn
+ * Usage: string name = ((ArrayExp *) exp)->getName();
+ *        Expression *row = ((ArrayExp *) exp)->getRow();
+ *        Expression *column = ((ArrayExp *) exp)->getColumn();
+ *        ((ArrayExp *) exp)->setRow(row);
+ *        ((ArrayExp *) exp)->setColumn(column);
+ * ---------------------------------------------------------
+ * These methods return and replace the name of the array and its
+ * subscripts.  The column is NULL for an array with one subscript.
+ */
+
+   std::string getName();
+   Expression *getRow();
+   Expression *getColumn();
+   void setRow(Expression *row);
+   void setColumn(Expression *column);
+
+/*
+ * Methods: setSlot, getSlot
+ * Usage: ((ArrayExp *) exp)->setSlot(state.getArraySlot(name));
+ *        int slot = ((ArrayExp *) exp)->getSlot();
+ * -------------------------------------------------------------
+ * These methods record and return the EvalState slot of the array,
+ * which resolveSymbols sets before the expression is evaluated.
+ */
+
+   void setSlot(int slot);
+   int getSlot();
+
+/*
+ * Methods: setChecked, isChecked, getColumns
+ * Usage: ((ArrayExp *) exp)->setChecked(false, columns);
+ *        if (((ArrayExp *) exp)->isChecked()) . . .
+ *        int columns = ((ArrayExp *) exp)->getColumns();
+ * ------------------------------------------------------
+ * These methods record whether the subscripts must be checked when
+ * the element is used, and return what was recorded.  Program::link
+ * turns the checks off only for subscripts it has proved in range,
+ * and passes the number of columns that the array is known to have,
+ * which an element with two subscripts needs to find its position.
+ */
+
+   void setChecked(bool checked, int columns = 0);
+   bool isChecked();
+   int getColumns();
+
+/*
+ * Method: getIndex
+ * Usage: int index = ((ArrayExp *) exp)->getIndex(state);
+ * -------------------------------------------------------
+ * Evaluates the subscripts and returns the position of the element in
+ * the storage of the array, checking the subscripts unless the checks
+ * are turned off.
+ */
+
+   int getIndex(EvalState & state);
+
+private:
+
+   std::string name;
+   Expression *row, *column;
+   int slot;
+   bool checked;
+   int columns;
+
+};
+
 #endif
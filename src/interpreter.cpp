@@ -0,0 +1,70 @@
+/*
+ * File: interpreter.cpp
+ * ---------------------
+ * This file implements the Interpreter class.
+ */
+
+#include "bytecode.h"
+#include "error.h"
+#include "evalstate.h"
+#include "interpreter.h"
+#include "program.h"
+#include "vm.h"
+using namespace std;
+
+Interpreter::Interpreter(Program & program, EvalState & state) : state(state) {
+   code.compile(program);
+   state.clearReturns();
+   slice.pc = 0;
+   slice.budget = 0;
+   slice.hasInput = false;
+   slice.inputValue = 0;
+   status = STEP_YIELDED;
+   statementCount = 0;
+}
+
+/*
+ * Implementation notes: step
+ * --------------------------
+ * A program that raises an error is marked as finished before the
+ * error is passed on, so that a scheduler which catches the error
+ * never resumes it.
+ */
+
+StepStatus Interpreter::step(int budget) {
+   if (status != STEP_YIELDED || budget <= 0) return status;
+   slice.budget = budget;
+   VMStatus result;
+   try {
+      result = executeSlice(code, state, slice);
+   } catch (ErrorException &) {
+      status = STEP_FINISHED;
+      throw;
+   }
+   statementCount += budget - slice.budget;
+   switch (result) {
+    case VM_YIELDED: status = STEP_YIELDED; break;
+    case VM_BLOCKED: status = STEP_BLOCKED; break;
+    default: status = STEP_FINISHED; break;
+   }
+   return status;
+}
+
+void Interpreter::provideInput(int value) {
+   if (status != STEP_BLOCKED) error("provideInput: program is not waiting for input");
+   slice.hasInput = true;
+   slice.inputValue = value;
+   status = STEP_YIELDED;
+}
+
+StepStatus Interpreter::getStatus() const {
+   return status;
+}
+
+long long Interpreter::getStatementCount() const {
+   return statementCount;
+}
+
+EvalState & Interpreter::getState() {
+   return state;
+}
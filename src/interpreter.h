@@ -0,0 +1,121 @@
+/*
+ * File: interpreter.h
+ * -------------------
+ * This interface exports the Interpreter class, which runs a BASIC
+ * program a few statements at a time.
+ */
+
+#ifndef _interpreter_h
+#define _interpreter_h
+
+#include "bytecode.h"
+#include "evalstate.h"
+#include "program.h"
+#include "vm.h"
+
+/*
+ * Type: StepStatus
+ * ----------------
+ * This enumerated type describes the state of a program after a call
+ * to step: it has more statements to run, it is waiting for a value
+ * for an INPUT statement, or it has ended.
+ */
+
+enum StepStatus { STEP_YIELDED, STEP_BLOCKED, STEP_FINISHED };
+
+/*
+ * Class: Interpreter
+ * ------------------
+ * This class runs a compiled program on the virtual machine in slices
+ * of a bounded number of statements, so that a program that never ends
+ * cannot keep its caller from doing anything else.  Between slices the
+ * program is suspended at a statement boundary and may be resumed, or
+ * simply abandoned, at any time.  An INPUT statement that has no input
+ * stream to read from suspends the program until the caller supplies a
+ * value with provideInput, rather than prompting at the console.
+ */
+
+class Interpreter {
+
+public:
+
+/*
+ * Constructor: Interpreter
+ * Usage: Interpreter interp(program, state);
+ * ------------------------------------------
+ * Compiles the program and prepares to run it from its first line,
+ * using state for its variables, output, and input.  The program may
+ * be changed or freed after the constructor returns, but the state
+ * must outlive the interpreter.  A jump to a missing line raises an
+ * error here, as it does for RUN.
+ */
+
+   Interpreter(Program & program, EvalState & state);
+
+/*
+ * Method: step
+ * Usage: StepStatus status = interp.step(budget);
+ * -----------------------------------------------
+ * Runs the program until it has executed budget more statements, has
+ * ended, or needs a value for INPUT, and returns the resulting status.
+ * Calling step on a program that is blocked or finished returns the
+ * same status without running anything.  An error raised by the
+ * program ends it and is passed on to the caller.
+ */
+
+   StepStatus step(int budget);
+
+/*
+ * Method: provideInput
+ * Usage: interp.provideInput(value);
+ * ----------------------------------
+ * Supplies the value for the INPUT statement on which the program is
+ * blocked, after which step resumes it.
+ */
+
+   void provideInput(int value);
+
+/*
+ * Method: getStatus
+ * Usage: StepStatus status = interp.getStatus();
+ * ----------------------------------------------
+ * Returns the status of the program after the last call to step.  A
+ * program that has not yet started has the status STEP_YIELDED.
+ */
+
+   StepStatus getStatus() const;
+
+/*
+ * Method: getStatementCount
+ * Usage: long long n = interp.getStatementCount();
+ * ------------------------------------------------
+ * Returns the number of statements the program has executed so far.
+ */
+
+   long long getStatementCount() const;
+
+/*
+ * Method: getState
+ * Usage: EvalState & state = interp.getState();
+ * ---------------------------------------------
+ * Returns the state in which the program runs.
+ */
+
+   EvalState & getState();
+
+private:
+
+   Bytecode code;               /* The compiled program              */
+   EvalState & state;           /* Variables, output, and input      */
+   VMSlice slice;               /* Where the program is suspended    */
+   StepStatus status;           /* Status after the last step        */
+   long long statementCount;    /* Statements executed so far        */
+
+/* Copying an interpreter in mid-run is not supported */
+
+   Interpreter(const Interpreter &);
+   Interpreter & operator=(const Interpreter &);
+
+};
+
+#endif
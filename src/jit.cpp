@@ -0,0 +1,827 @@
+/*
+ * File: jit.cpp
+ * -------------
+ * This file implements the x86-64 code generator declared in jit.h.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include "bytecode.h"
+#include "error.h"
+#include "evalstate.h"
+#include "jit.h"
+#include "matrix.h"
+#include "output.h"
+#include "vm.h"
+using namespace std;
+
+#if defined(__x86_64__) && !defined(_WIN32)
+#  define JIT_AVAILABLE
+#  include <sys/mman.h>
+#endif
+
+/*
+ * Implementation notes: calling convention
+ * ----------------------------------------
+ * The generated code is a single function that follows the System V
+ * calling convention:
+ *
+ *    int native(int *values, unsigned *defined, OutputBuffer *out,
+ *               int *spill, const void *target, ReturnStack *returns,
+ *               ArrayInfo *arrays);
+ *
+ * The prologue saves the callee-saved registers, moves the first four
+ * arguments into r12 through r15 and the return stack into rbp, where
+ * they stay for the life of the call, and jumps to target, which is the
+ * native address of the statement at which execution resumes.  No
+ * register is left for the array table, which arrives on the stack; the
+ * prologue copies it to the word at the top of the frame, where an
+ * element instruction loads it into rdx.  The function returns the
+ * index of an entry in the exits table.
+ *
+ * Operand stack entry k is kept in the kth register of STACK_REGS;
+ * deeper entries go to the spill array.  Since the depth at every
+ * instruction is known when the code is generated, no stack pointer
+ * is needed at run time.  Every statement leaves the stack empty, so
+ * no stack values are live across the call that PRINT makes, and the
+ * caller-saved registers can hold stack values freely.  The registers
+ * rax and rdx are left free as scratch, since idiv needs them; rax also
+ * stands in for the nonexistent entries below the bottom of the stack.
+ *
+ * GOSUB pushes the native address of the instruction that follows it
+ * onto the return stack in the EvalState, and RETURN pops it and jumps
+ * there indirectly, so a call and a return each cost about as much as
+ * a GOTO.
+ *
+ * A subscript is checked with a single unsigned comparison against the
+ * bound in the ArrayInfo for the array, which also catches a negative
+ * subscript and an array that has not been dimensioned.  Subscripts
+ * that the compiler has proved to be in range arrive without OP_INDEX
+ * or OP_INDEX2, so the element is addressed directly.
+ */
+
+typedef int (*NativeFunction)(int *values, unsigned *defined, OutputBuffer *out,
+                              int *spill, const void *target, ReturnStack *returns,
+                              ArrayInfo *arrays);
+
+#ifdef JIT_AVAILABLE
+
+/* Register numbers as they appear in instruction encodings */
+
+enum Register {
+   RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+   R8, R9, R10, R11, R12, R13, R14, R15
+};
+
+static const Register STACK_REGS[] = { RCX, RSI, RDI, R8, R9, R10, R11, RBX };
+static const int N_STACK_REGS = sizeof STACK_REGS / sizeof STACK_REGS[0];
+
+static const Register VALUES = R12;
+static const Register DEFINED = R13;
+static const Register OUTPUT = R14;
+static const Register SPILL = R15;
+static const Register RETURNS = RBP;
+
+/* Condition codes for the jcc instructions */
+
+enum Condition { COND_AE = 0x3, COND_EQ = 0x4, COND_NE = 0x5, COND_LT = 0xC, COND_GE = 0xD, COND_LE = 0xE, COND_GT = 0xF };
+
+/*
+ * Type: Operand
+ * -------------
+ * This type describes an instruction operand that is either a register
+ * or a 32-bit word in memory at a fixed displacement from a base
+ * register.
+ */
+
+struct Operand {
+   bool memory;
+   Register reg;
+   int disp;
+};
+
+static Operand registerOperand(Register reg) {
+   Operand op = { false, reg, 0 };
+   return op;
+}
+
+static Operand memoryOperand(Register base, int disp) {
+   Operand op = { true, base, disp };
+   return op;
+}
+
+/*
+ * Class: Assembler
+ * ----------------
+ * This class encodes the small subset of the x86-64 instruction set
+ * used by the code generator.  All arithmetic is on 32-bit operands.
+ */
+
+class Assembler {
+
+public:
+
+   vector<unsigned char> bytes;
+
+   int offset() const {
+      return bytes.size();
+   }
+
+   void byte(int b) {
+      bytes.push_back(b);
+   }
+
+   void word(int w) {
+      for (int i = 0; i < 4; i++) {
+         bytes.push_back((unsigned) w >> (8 * i));
+      }
+   }
+
+   void patch(int pos, int w) {
+      for (int i = 0; i < 4; i++) {
+         bytes[pos + i] = (unsigned) w >> (8 * i);
+      }
+   }
+
+/*
+ * Emits an instruction whose ModRM byte names reg in its reg field
+ * and rm in its r/m field, preceded by a REX prefix if either uses one
+ * of the extended registers.  Memory operands always use a 32-bit
+ * displacement, and a base of rsp or r12 needs a SIB byte.
+ */
+
+   void modrm(int opcode, int reg, Operand rm, bool wide = false) {
+      int rex = 0x40 | (wide ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((rm.reg & 8) ? 1 : 0);
+      if (rex != 0x40) byte(rex);
+      if (opcode > 0xFF) byte(opcode >> 8);
+      byte(opcode & 0xFF);
+      if (rm.memory) {
+         byte(0x80 | ((reg & 7) << 3) | (rm.reg & 7));
+         if ((rm.reg & 7) == RSP) byte(0x24);
+         word(rm.disp);
+      } else {
+         byte(0xC0 | ((reg & 7) << 3) | (rm.reg & 7));
+      }
+   }
+
+   void load(Register dst, Operand src) {
+      modrm(0x8B, dst, src);
+   }
+
+   void store(Operand dst, Register src) {
+      modrm(0x89, src, dst);
+   }
+
+   void move(Operand dst, Operand src) {
+      if (!dst.memory) {
+         load(dst.reg, src);
+      } else if (!src.memory) {
+         store(dst, src.reg);
+      } else {
+         load(RAX, src);
+         store(dst, RAX);
+      }
+   }
+
+   void moveImmediate(Operand dst, int value) {
+      if (dst.memory) {
+         modrm(0xC7, 0, dst);
+      } else {
+         if (dst.reg & 8) byte(0x41);
+         byte(0xB8 + (dst.reg & 7));
+      }
+      word(value);
+   }
+
+   void move64(Register dst, Register src) {
+      modrm(0x8B, dst, registerOperand(src), true);
+   }
+
+   void load64(Register dst, Operand src) {
+      modrm(0x8B, dst, src, true);
+   }
+
+   void store64(Operand dst, Register src) {
+      modrm(0x89, src, dst, true);
+   }
+
+   void increment(Register reg) {
+      modrm(0xFF, 0, registerOperand(reg));
+   }
+
+   void decrement(Register reg) {
+      modrm(0xFF, 1, registerOperand(reg));
+   }
+
+   void arithmetic(int opcode, Register dst, Operand src, bool wide = false) {
+      modrm(opcode, dst, src, wide);
+   }
+
+   void loadSigned64(Register dst, Operand src) {
+      modrm(0x63, dst, src, true);              /* movsxd */
+   }
+
+   void testImmediate(Operand dst, int mask) {
+      modrm(0xF7, 0, dst);
+      word(mask);
+   }
+
+   void orImmediate(Operand dst, int mask) {
+      modrm(0x81, 1, dst);
+      word(mask);
+   }
+
+   void compareZero(Operand op) {
+      if (op.memory) {
+         modrm(0x83, 7, op);
+         byte(0);
+      } else {
+         modrm(0x85, op.reg, op);
+      }
+   }
+
+   void compareImmediate(Operand op, int value) {
+      modrm(0x83, 7, op);                       /* cmp with imm8 */
+      byte(value);
+   }
+
+   void negate(Register reg) {
+      modrm(0xF7, 3, registerOperand(reg));     /* neg */
+   }
+
+   void shiftRightImmediate64(Register reg, int count) {
+      modrm(0xC1, 7, registerOperand(reg), true);   /* sar */
+      byte(count);
+   }
+
+   void divide(Operand divisor) {
+      byte(0x99);                               /* cdq */
+      modrm(0xF7, 7, divisor);                  /* idiv */
+   }
+
+   void push(Register reg) {
+      if (reg & 8) byte(0x41);
+      byte(0x50 + (reg & 7));
+   }
+
+   void pop(Register reg) {
+      if (reg & 8) byte(0x41);
+      byte(0x58 + (reg & 7));
+   }
+
+   void call(const void *fn) {
+      byte(0x48);                               /* mov rax, imm64 */
+      byte(0xB8);
+      unsigned long long address = (unsigned long long) fn;
+      word(address);
+      word(address >> 32);
+      byte(0xFF);                               /* call rax */
+      byte(0xD0);
+   }
+
+/*
+ * Methods: jump, jumpIf
+ * ---------------------
+ * Emit a jump with a 32-bit relative displacement and return the
+ * position of the displacement so that it can be patched later.
+ */
+
+   int jump() {
+      byte(0xE9);
+      word(0);
+      return offset() - 4;
+   }
+
+   int jumpIf(Condition cond) {
+      byte(0x0F);
+      byte(0x80 + cond);
+      word(0);
+      return offset() - 4;
+   }
+
+   void patchJump(int pos, int target) {
+      patch(pos, target - (pos + 4));
+   }
+
+/*
+ * Method: loadAddress
+ * -------------------
+ * Emits a lea that loads a native code address relative to rip into
+ * reg.  The displacement is patched later with patchJump, since it is
+ * relative to the end of the instruction just as a jump's is.
+ */
+
+   int loadAddress(Register reg) {
+      byte(0x48 | ((reg & 8) ? 4 : 0));
+      byte(0x8D);
+      byte(0x05 | ((reg & 7) << 3));
+      word(0);
+      return offset() - 4;
+   }
+
+/*
+ * Methods: storeIndexed, jumpIndexed
+ * ----------------------------------
+ * Store the 64-bit register src at, or jump to the address held at,
+ * base + 8 * index.  Neither base nor index may be an extended
+ * register, and base may not be rbp.
+ */
+
+   void storeIndexed(Register base, Register index, Register src) {
+      byte(0x48 | ((src & 8) ? 4 : 0));
+      byte(0x89);
+      byte(0x04 | ((src & 7) << 3));
+      byte(0xC0 | (index << 3) | base);
+   }
+
+   void jumpIndexed(Register base, Register index) {
+      byte(0xFF);
+      byte(0x24);
+      byte(0xC0 | (index << 3) | base);
+   }
+
+/*
+ * Method: loadElementAddress
+ * --------------------------
+ * Emits a lea that sets base to base + 4 * index, the address of
+ * element index of an int array at base.  The same restrictions on
+ * the registers apply as above.
+ */
+
+   void loadElementAddress(Register base, Register index) {
+      byte(0x48);
+      byte(0x8D);
+      byte(0x04 | (base << 3));
+      byte(0x80 | (index << 3) | base);
+   }
+
+};
+
+static Operand stackOperand(int k) {
+   if (k < 0) return registerOperand(RAX);
+   if (k < N_STACK_REGS) return registerOperand(STACK_REGS[k]);
+   return memoryOperand(SPILL, 4 * (k - N_STACK_REGS));
+}
+
+static Operand valueOperand(int slot) {
+   return memoryOperand(VALUES, 4 * slot);
+}
+
+static Operand definedOperand(int slot) {
+   return memoryOperand(DEFINED, 4 * (slot >> 5));
+}
+
+static int definedMask(int slot) {
+   return 1u << (slot & 31);
+}
+
+/*
+ * Function: arrayOperand
+ * Usage: Operand length = arrayOperand(slot, offsetof(ArrayInfo, length));
+ * ------------------------------------------------------------------------
+ * Returns the field at the given offset in the ArrayInfo for slot,
+ * assuming that rdx holds the address of the array table.
+ */
+
+static Operand arrayOperand(int slot, int field) {
+   return memoryOperand(RDX, slot * (int) sizeof(ArrayInfo) + field);
+}
+
+/*
+ * Function: emitElementAddress
+ * Usage: emitElementAddress(as, slot, index);
+ * -------------------------------------------
+ * Emits code that leaves in rdx the address of the element of the
+ * array at slot whose position is the stack entry index.  The code
+ * uses rax as scratch.
+ */
+
+static void emitElementAddress(Assembler & as, int slot, Operand index) {
+   as.load64(RDX, memoryOperand(RSP, 0));
+   as.load64(RDX, arrayOperand(slot, offsetof(ArrayInfo, elements)));
+   as.loadSigned64(RAX, index);
+   as.loadElementAddress(RDX, RAX);
+}
+
+/*
+ * Function: emitLoopTest
+ * Usage: emitLoopTest(as, limit, step);
+ * -------------------------------------
+ * Emits the comparison that decides whether the loop whose counter
+ * value is in rax, sign-extended to 64 bits, runs again, leaving the
+ * flags set so that jle is taken if it does.  Flipping every bit of a
+ * number reverses the order of the integers, so with the mask d equal
+ * to step >> 63, which is all ones for a negative step and zero
+ * otherwise, the test (value ^ d) <= (limit ^ d) covers both
+ * directions without a branch on the sign of the step.  The code uses
+ * rdx and rcx as scratch; rcx is the bottom of the operand stack,
+ * which is empty once a loop instruction has stored its operands.
+ */
+
+static void emitLoopTest(Assembler & as, int limit, int step) {
+   as.loadSigned64(RDX, valueOperand(step));
+   as.shiftRightImmediate64(RDX, 63);
+   as.loadSigned64(RCX, valueOperand(limit));
+   as.arithmetic(0x33, RAX, registerOperand(RDX), true);    /* xor rax, rdx */
+   as.arithmetic(0x33, RCX, registerOperand(RDX), true);    /* xor rcx, rdx */
+   as.arithmetic(0x3B, RAX, registerOperand(RCX), true);    /* cmp rax, rcx */
+}
+
+static void printValue(OutputBuffer *out, int value) {
+   out->printInteger(value);
+}
+
+#endif
+
+JitCode::JitCode() {
+   bytecode = NULL;
+   memory = NULL;
+   memorySize = 0;
+   codeSize = 0;
+   spillSize = 0;
+}
+
+JitCode::~JitCode() {
+   release();
+}
+
+bool JitCode::isAvailable() {
+#ifdef JIT_AVAILABLE
+   return true;
+#else
+   return false;
+#endif
+}
+
+int JitCode::size() const {
+   return codeSize;
+}
+
+void JitCode::release() {
+#ifdef JIT_AVAILABLE
+   if (memory != NULL) munmap(memory, memorySize);
+#endif
+   memory = NULL;
+   memorySize = 0;
+   codeSize = 0;
+   entries.clear();
+   exits.clear();
+}
+
+/*
+ * Implementation notes: compile
+ * -----------------------------
+ * The translation is a single pass over the bytecode that records the
+ * native offset of every instruction.  Jumps to bytecode addresses and
+ * branches to the out-of-line exit stubs are patched once the whole
+ * program has been emitted.  The code is assembled in an ordinary
+ * vector and copied into a fresh mapping, which is made executable
+ * only after it is no longer writable.  The native code keeps every
+ * value in a 32-bit register, so a program that uses the 64-bit
+ * integers or doubles of typed variables is not translated at all and
+ * executeJit hands it to the virtual machine, which runs it as fast as
+ * it runs any other program.
+ */
+
+void JitCode::compile(const Bytecode & code) {
+   release();
+   bytecode = &code;
+#ifdef JIT_AVAILABLE
+   const int *words = code.getCode();
+   int n = code.size();
+   if (words == NULL) return;
+   for (int pc = 0; pc < n; pc += 1 + getOperandCount(Opcode(words[pc]))) {
+      if (words[pc] >= OP_PUSH2) return;
+   }
+   spillSize = max(0, code.getMaxStack() - N_STACK_REGS);
+   Assembler as;
+   vector<int> jumpFixups;
+   vector<int> exitFixups;
+
+   static const Register SAVED[] = { RBX, RBP, R12, R13, R14, R15 };
+   for (int i = 0; i < 6; i++) {
+      as.push(SAVED[i]);
+   }
+   as.byte(0x48); as.byte(0x83); as.byte(0xEC); as.byte(0x08);     /* sub rsp, 8 */
+   as.move64(VALUES, RDI);
+   as.move64(DEFINED, RSI);
+   as.move64(OUTPUT, RDX);
+   as.move64(SPILL, RCX);
+   as.move64(RETURNS, R9);
+   as.load64(RAX, memoryOperand(RSP, 64));
+   as.store64(memoryOperand(RSP, 0), RAX);
+   as.byte(0x41); as.byte(0xFF); as.byte(0xE0);                    /* jmp r8 */
+   int epilogue = as.offset();
+   as.byte(0x48); as.byte(0x83); as.byte(0xC4); as.byte(0x08);     /* add rsp, 8 */
+   for (int i = 5; i >= 0; i--) {
+      as.pop(SAVED[i]);
+   }
+   as.byte(0xC3);                                                  /* ret */
+
+   entries.assign(n, -1);
+   int depth = 0;
+   int pc = 0;
+   while (pc < n) {
+      Opcode op = Opcode(words[pc]);
+      int operand = (getOperandCount(op) > 0) ? words[pc + 1] : 0;
+      entries[pc] = as.offset();
+      Operand top = stackOperand(depth - 1);
+      Operand next = stackOperand(depth - 2);
+      switch (op) {
+       case OP_PUSH:
+         as.moveImmediate(stackOperand(depth), operand);
+         break;
+       case OP_LOAD:
+         as.testImmediate(definedOperand(operand), definedMask(operand));
+         exitFixups.push_back(as.jumpIf(COND_EQ));
+         exitFixups.push_back(exits.size());
+         exits.push_back(Exit());
+         exits.back().reason = EXIT_UNDEFINED;
+         exits.back().pc = pc;
+         as.move(stackOperand(depth), valueOperand(operand));
+         break;
+       case OP_STORE:
+         as.move(valueOperand(operand), top);
+         as.orImmediate(definedOperand(operand), definedMask(operand));
+         break;
+       case OP_ADD: case OP_SUB: case OP_MUL: {
+         int opcode = (op == OP_ADD) ? 0x03 : (op == OP_SUB) ? 0x2B : 0x0FAF;
+         if (next.memory) {
+            as.load(RAX, next);
+            as.arithmetic(opcode, RAX, top);
+            as.store(next, RAX);
+         } else {
+            as.arithmetic(opcode, next.reg, top);
+         }
+         break;
+       }
+       case OP_DIV: {
+         as.compareZero(top);
+         exitFixups.push_back(as.jumpIf(COND_EQ));
+         exitFixups.push_back(exits.size());
+         exits.push_back(Exit());
+         exits.back().reason = EXIT_DIVIDE;
+         exits.back().pc = pc;
+         as.load(RAX, next);
+         as.compareImmediate(top, -1);
+         int divideFixup = as.jumpIf(COND_NE);
+         as.negate(RAX);                        /* idiv traps on INT_MIN / -1 */
+         int doneFixup = as.jump();
+         as.patchJump(divideFixup, as.offset());
+         as.divide(top);
+         as.patchJump(doneFixup, as.offset());
+         as.store(next, RAX);
+         break;
+       }
+       case OP_DUP:
+         as.move(stackOperand(depth), top);
+         break;
+       case OP_POP:
+         break;
+       case OP_PRINT:
+         if (depth != 1) error("JIT: values live across PRINT");
+         as.load(RSI, top);
+         as.move64(RDI, OUTPUT);
+         as.call((const void *) printValue);
+         break;
+       case OP_JUMP:
+         jumpFixups.push_back(as.jump());
+         jumpFixups.push_back(operand);
+         break;
+       case OP_JUMP_EQ: case OP_JUMP_GT: case OP_JUMP_LT: {
+         Condition cond = (op == OP_JUMP_EQ) ? COND_EQ
+                        : (op == OP_JUMP_LT) ? COND_LT : COND_GT;
+         if (next.memory) {
+            as.load(RAX, next);
+            as.arithmetic(0x3B, RAX, top);
+         } else {
+            as.arithmetic(0x3B, next.reg, top);
+         }
+         jumpFixups.push_back(as.jumpIf(cond));
+         jumpFixups.push_back(operand);
+         break;
+       }
+       case OP_FOR: {
+         for (int k = 0; k < 3; k++) {
+            int slot = words[pc + 1 + k];
+            as.move(valueOperand(slot), stackOperand(depth - 3 + k));
+            as.orImmediate(definedOperand(slot), definedMask(slot));
+         }
+         as.loadSigned64(RAX, valueOperand(words[pc + 1]));
+         emitLoopTest(as, words[pc + 2], words[pc + 3]);
+         jumpFixups.push_back(as.jumpIf(COND_GT));
+         jumpFixups.push_back(words[pc + 4]);
+         break;
+       }
+       case OP_NEXT: {
+         int counter = words[pc + 1];
+         int step = words[pc + 3];
+         as.testImmediate(definedOperand(step), definedMask(step));
+         exitFixups.push_back(as.jumpIf(COND_EQ));
+         exitFixups.push_back(exits.size());
+         exits.push_back(Exit());
+         exits.back().reason = EXIT_NO_LOOP;
+         exits.back().pc = pc;
+         as.loadSigned64(RAX, valueOperand(counter));
+         as.loadSigned64(RDX, valueOperand(step));
+         as.arithmetic(0x03, RAX, registerOperand(RDX), true);    /* add rax, rdx */
+         as.store(valueOperand(counter), RAX);
+         emitLoopTest(as, words[pc + 2], step);
+         jumpFixups.push_back(as.jumpIf(COND_LE));
+         jumpFixups.push_back(words[pc + 4]);
+         break;
+       }
+       case OP_GOSUB: {
+         Operand depthWord = memoryOperand(RETURNS, offsetof(ReturnStack, depth));
+         as.load(RAX, depthWord);
+         as.arithmetic(0x3B, RAX, memoryOperand(RETURNS, offsetof(ReturnStack, capacity)));
+         exitFixups.push_back(as.jumpIf(COND_GE));
+         exitFixups.push_back(exits.size());
+         exits.push_back(Exit());
+         exits.back().reason = EXIT_OVERFLOW;
+         exits.back().pc = pc;
+         as.load64(RDX, memoryOperand(RETURNS, offsetof(ReturnStack, addresses)));
+         jumpFixups.push_back(as.loadAddress(RCX));
+         jumpFixups.push_back(pc + 2);
+         as.storeIndexed(RDX, RAX, RCX);
+         as.increment(RAX);
+         as.store(depthWord, RAX);
+         jumpFixups.push_back(as.jump());
+         jumpFixups.push_back(operand);
+         break;
+       }
+       case OP_RETURN: {
+         Operand depthWord = memoryOperand(RETURNS, offsetof(ReturnStack, depth));
+         as.load(RAX, depthWord);
+         as.compareZero(registerOperand(RAX));
+         exitFixups.push_back(as.jumpIf(COND_EQ));
+         exitFixups.push_back(exits.size());
+         exits.push_back(Exit());
+         exits.back().reason = EXIT_NO_GOSUB;
+         exits.back().pc = pc;
+         as.decrement(RAX);
+         as.store(depthWord, RAX);
+         as.load64(RDX, memoryOperand(RETURNS, offsetof(ReturnStack, addresses)));
+         as.jumpIndexed(RDX, RAX);
+         break;
+       }
+       case OP_INDEX: case OP_INDEX2: {
+         as.load64(RDX, memoryOperand(RSP, 0));
+         int bound = (op == OP_INDEX) ? offsetof(ArrayInfo, length) : offsetof(ArrayInfo, columns);
+         for (int k = 0; k < 1 + (op == OP_INDEX2); k++) {
+            Operand subscript = (k == 0) ? top : next;
+            if (subscript.memory) {
+               as.load(RAX, subscript);
+               subscript = registerOperand(RAX);
+            }
+            as.arithmetic(0x3B, subscript.reg, arrayOperand(operand, bound));
+            exitFixups.push_back(as.jumpIf(COND_AE));
+            exitFixups.push_back(exits.size());
+            exits.push_back(Exit());
+            exits.back().reason = EXIT_SUBSCRIPT;
+            exits.back().pc = pc;
+            bound = offsetof(ArrayInfo, rows);
+         }
+         if (op == OP_INDEX2) {
+            as.load(RAX, next);
+            as.arithmetic(0x0FAF, RAX, arrayOperand(operand, offsetof(ArrayInfo, columns)));
+            as.arithmetic(0x03, RAX, top);
+            as.store(next, RAX);
+         }
+         break;
+       }
+       case OP_LOAD_ELEMENT:
+         emitElementAddress(as, operand, top);
+         as.move(top, memoryOperand(RDX, 0));
+         break;
+       case OP_STORE_ELEMENT:
+         emitElementAddress(as, operand, next);
+         as.move(memoryOperand(RDX, 0), top);
+         break;
+       case OP_MAT_SCALE:
+         as.move(memoryOperand(SPILL, 0), top);
+         /* Fall through */
+       case OP_INPUT: case OP_END: case OP_DIM: case OP_MAT: case OP_RESTORE:
+         exits.push_back(Exit());
+         exits.back().reason = (op == OP_INPUT) ? EXIT_INPUT
+                             : (op == OP_DIM) ? EXIT_DIM
+                             : (op == OP_MAT) ? EXIT_MAT
+                             : (op == OP_MAT_SCALE) ? EXIT_MAT_SCALE
+                             : (op == OP_RESTORE) ? EXIT_RESTORE : EXIT_END;
+         exits.back().pc = pc;
+         as.moveImmediate(registerOperand(RAX), exits.size() - 1);
+         as.patchJump(as.jump(), epilogue);
+         break;
+       case OP_DATA:
+         break;
+       default:
+         error("JIT: illegal instruction in compiled program");
+      }
+      depth += getStackEffect(op);
+      pc += 1 + getOperandCount(op);
+   }
+   for (size_t i = 0; i < jumpFixups.size(); i += 2) {
+      as.patchJump(jumpFixups[i], entries[jumpFixups[i + 1]]);
+   }
+   for (size_t i = 0; i < exitFixups.size(); i += 2) {
+      as.patchJump(exitFixups[i], as.offset());
+      as.moveImmediate(registerOperand(RAX), exitFixups[i + 1]);
+      as.patchJump(as.jump(), epilogue);
+   }
+
+   codeSize = as.offset();
+   memorySize = codeSize;
+   void *block = mmap(NULL, memorySize, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (block == MAP_FAILED) error("JIT: unable to allocate executable memory");
+   memcpy(block, &as.bytes[0], codeSize);
+   if (mprotect(block, memorySize, PROT_READ | PROT_EXEC) != 0) {
+      munmap(block, memorySize);
+      error("JIT: unable to make code executable");
+   }
+   memory = (unsigned char *) block;
+#endif
+}
+
+/*
+ * Implementation notes: executeJit
+ * --------------------------------
+ * The native code runs until it reaches a point that it cannot handle
+ * itself.  Because an exception cannot unwind through frames that have
+ * no unwind information, errors are raised here, after the native code
+ * has returned.  A GOSUB or RETURN that finds the return stack full
+ * or empty exits with the stack unchanged, so repeating the push or
+ * pop here raises the same error the other engines do.  After an
+ * INPUT, DIM or MAT, execution resumes at the instruction that follows,
+ * which always begins a statement.  The whole-array operations run in
+ * the kernels of matrix.h, which are compiled ahead of time, so a MAT
+ * statement costs one exit however large its arrays are.  The factor of
+ * a scalar multiple is passed back in the first spill word, which holds
+ * no value at that point since the factor is the only value on the
+ * stack.  The array table is passed afresh on each entry, although its
+ * address does not change during a run, since resolveSymbols assigns
+ * every slot before the code runs.
+ */
+
+void executeJit(const JitCode & jit, EvalState & state) {
+   if (jit.memory == NULL) {
+      if (jit.bytecode != NULL) executeBytecode(*jit.bytecode, state);
+      return;
+   }
+   NativeFunction native = reinterpret_cast<NativeFunction>(jit.memory);
+   const int *code = jit.bytecode->getCode();
+   vector<int> spill(jit.spillSize + 1);
+   state.clearReturns();
+   int pc = 0;
+   while (true) {
+      int index = native(state.getValueArray(), state.getDefinedArray(),
+                         &state.getOutput(), &spill[0], jit.memory + jit.entries[pc],
+                         state.getReturnStack(), state.getArrayTable());
+      const JitCode::Exit & exit = jit.exits[index];
+      switch (exit.reason) {
+       case JitCode::EXIT_END:
+         return;
+       case JitCode::EXIT_INPUT:
+         state.setValue(code[exit.pc + 1], state.readInput());
+         pc = exit.pc + 2;
+         break;
+       case JitCode::EXIT_UNDEFINED:
+         error(state.getName(code[exit.pc + 1]) + " is undefined");
+         break;
+       case JitCode::EXIT_DIVIDE:
+         error("Division by zero");
+         break;
+       case JitCode::EXIT_NO_LOOP:
+         error("NEXT without FOR");
+         break;
+       case JitCode::EXIT_OVERFLOW:
+         state.pushReturn(NULL);
+         break;
+       case JitCode::EXIT_NO_GOSUB:
+         state.popReturn();
+         break;
+       case JitCode::EXIT_DIM:
+         state.dimension(code[exit.pc + 1], code[exit.pc + 2], code[exit.pc + 3]);
+         pc = exit.pc + 4;
+         break;
+       case JitCode::EXIT_SUBSCRIPT:
+         state.subscriptError(code[exit.pc + 1]);
+         break;
+       case JitCode::EXIT_MAT:
+         executeMat(MatOperation(code[exit.pc + 1]), code[exit.pc + 2], code[exit.pc + 3],
+                    code[exit.pc + 4], 0, state);
+         pc = exit.pc + 5;
+         break;
+       case JitCode::EXIT_MAT_SCALE:
+         executeMat(MAT_SCALE, code[exit.pc + 1], code[exit.pc + 2], code[exit.pc + 2],
+                    spill[0], state);
+         pc = exit.pc + 3;
+         break;
+       case JitCode::EXIT_RESTORE:
+         pc = restoreData(code, exit.pc, state);
+         break;
+      }
+   }
+}
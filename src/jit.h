@@ -0,0 +1,150 @@
+/*
+ * File: jit.h
+ * -----------
+ * This interface exports the JitCode class, which translates the
+ * bytecode for a BASIC program into x86-64 machine code, and the
+ * function that runs the result.
+ */
+
+#ifndef _jit_h
+#define _jit_h
+
+#include <vector>
+#include "bytecode.h"
+#include "evalstate.h"
+
+/*
+ * Class: JitCode
+ * --------------
+ * This class holds a BASIC program compiled to native code.  The
+ * translation starts from the Bytecode form of the program, which has
+ * already resolved every variable to an EvalState slot and every jump
+ * to an address, and maps each instruction to a short sequence of
+ * machine instructions.  Values on the operand stack live in machine
+ * registers; variables are read and written in place in the value
+ * array of the EvalState.
+ *
+ * The native code never raises an error and never reads input.  When
+ * it reaches an INPUT statement, a reference to an undefined variable,
+ * a division by zero, a NEXT whose FOR has not run, a GOSUB or RETURN
+ * that finds the return stack full or empty, a DIM statement, or a bad
+ * subscript, it returns to executeJit, which performs the INPUT or DIM
+ * itself and reenters the code at the following statement, or raises
+ * the same error that the virtual machine would.  PRINT calls
+ * back into the OutputBuffer directly.
+ *
+ * Native code generation is available only on x86-64 systems that
+ * provide mmap.  Elsewhere isAvailable returns false and executeJit
+ * runs the bytecode on the virtual machine instead, as it does for a
+ * program that uses typed variables, which compile leaves untranslated.
+ */
+
+class JitCode {
+
+public:
+
+/*
+ * Constructor: JitCode
+ * Usage: JitCode jit;
+ * -------------------
+ * Creates an empty object that holds no native code.
+ */
+
+   JitCode();
+
+/*
+ * Destructor: ~JitCode
+ * Usage: usually implicit
+ * -----------------------
+ * Releases the memory that holds the native code.
+ */
+
+   ~JitCode();
+
+/*
+ * Method: isAvailable
+ * Usage: if (JitCode::isAvailable()) . . .
+ * ----------------------------------------
+ * Returns true if native code can be generated on this system.
+ */
+
+   static bool isAvailable();
+
+/*
+ * Method: compile
+ * Usage: jit.compile(code);
+ * -------------------------
+ * Replaces the contents of this object with the native translation of
+ * the bytecode.  The bytecode must remain unchanged for as long as the
+ * translation is used.  If native code is not available, compile does
+ * nothing.
+ */
+
+   void compile(const Bytecode & code);
+
+/*
+ * Method: size
+ * Usage: int bytes = jit.size();
+ * ------------------------------
+ * Returns the number of bytes of machine code generated.
+ */
+
+   int size() const;
+
+private:
+
+/*
+ * Type: ExitReason
+ * ----------------
+ * This type identifies why the native code returned.  Each return
+ * passes back an index into the exits vector, which records the reason
+ * along with the bytecode address that caused it.
+ */
+
+   enum ExitReason {
+      EXIT_END, EXIT_INPUT, EXIT_UNDEFINED, EXIT_DIVIDE, EXIT_NO_LOOP,
+      EXIT_OVERFLOW, EXIT_NO_GOSUB, EXIT_DIM, EXIT_SUBSCRIPT, EXIT_MAT,
+      EXIT_MAT_SCALE, EXIT_RESTORE
+   };
+
+   struct Exit {
+      ExitReason reason;
+      int pc;
+   };
+
+/* Instance variables */
+
+   const Bytecode *bytecode;       /* The code that was translated          */
+   unsigned char *memory;          /* Executable memory from mmap           */
+   int memorySize;                 /* Size of the mapping in bytes          */
+   int codeSize;                   /* Bytes of machine code in the mapping  */
+   int spillSize;                  /* Stack values that do not fit in regs  */
+   std::vector<int> entries;       /* Native offset of each bytecode word   */
+   std::vector<Exit> exits;        /* Reasons for returning to executeJit   */
+
+/* Private methods */
+
+   void release();
+
+/* Forbid copying, since the object owns the mapping */
+
+   JitCode(const JitCode &);
+   JitCode & operator=(const JitCode &);
+
+   friend void executeJit(const JitCode & jit, EvalState & state);
+
+};
+
+/*
+ * Function: executeJit
+ * Usage: executeJit(jit, state);
+ * ------------------------------
+ * Runs the native translation of a program, with the same effect as
+ * executeBytecode on the bytecode from which it was compiled.  If the
+ * object holds no native code, executeJit runs that bytecode on the
+ * virtual machine instead.
+ */
+
+void executeJit(const JitCode & jit, EvalState & state);
+
+#endif
@@ -0,0 +1,46 @@
+/*
+ * File: keywords.cpp
+ * ------------------
+ * This file implements the keywords.h interface.
+ */
+
+#include <cctype>
+#include "keywords.h"
+
+/*
+ * Implementation notes: lookupKeyword
+ * -----------------------------------
+ * The bucket of the word selects at most one keyword through a switch
+ * whose case labels are the keywords' buckets, computed by the
+ * compiler.  Since KEYWORD_SEED leaves no two keywords in the same
+ * bucket, the labels are distinct, and the compiler can turn the
+ * switch into a jump table.  A word that lands in a keyword's bucket
+ * is then compared with that one keyword, ignoring case, since any
+ * other word may land there too.
+ */
+
+static Keyword matchKeyword(const char *text, int length, Keyword keyword);
+
+Keyword lookupKeyword(const char *text, int length) {
+   switch (hashKeyword(text, length, KEYWORD_SEED)) {
+#define KEYWORD_CASE(name) \
+    case keywordBucket(KEYWORD_##name, KEYWORD_SEED): \
+      return matchKeyword(text, length, KEYWORD_##name);
+      KEYWORD_LIST(KEYWORD_CASE)
+#undef KEYWORD_CASE
+    default:
+      return KEYWORD_NONE;
+   }
+}
+
+const char *getKeywordName(Keyword keyword) {
+   return KEYWORD_NAMES[keyword];
+}
+
+static Keyword matchKeyword(const char *text, int length, Keyword keyword) {
+   const char *name = KEYWORD_NAMES[keyword];
+   for (int i = 0; i < length; i++) {
+      if (name[i] == '\0' || toupper((unsigned char) text[i]) != name[i]) return KEYWORD_NONE;
+   }
+   return (name[length] == '\0') ? keyword : KEYWORD_NONE;
+}
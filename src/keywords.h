@@ -0,0 +1,142 @@
+/*
+ * File: keywords.h
+ * ----------------
+ * This interface exports the Keyword type, which identifies the words
+ * that BASIC reserves for statements and commands, and the function
+ * that recognizes them.
+ */
+
+#ifndef _keywords_h
+#define _keywords_h
+
+/*
+ * Macro: KEYWORD_LIST
+ * -------------------
+ * Lists every keyword, in upper case.  Adding a keyword takes one more
+ * entry here; the enumeration, the table of names, and the hash used
+ * by lookupKeyword are all generated from this list.
+ */
+
+#define KEYWORD_LIST(X) \
+   X(REM)               \
+   X(LET)               \
+   X(PRINT)             \
+   X(INPUT)             \
+   X(GOTO)              \
+   X(IF)                \
+   X(THEN)              \
+   X(END)               \
+   X(FOR)               \
+   X(TO)                \
+   X(STEP)              \
+   X(NEXT)              \
+   X(GOSUB)             \
+   X(RETURN)            \
+   X(DIM)               \
+   X(MAT)               \
+   X(READ)              \
+   X(DATA)              \
+   X(TRN)               \
+   X(LIST)              \
+   X(CLEAR)             \
+   X(RUN)               \
+   X(HELP)              \
+   X(QUIT)              \
+   X(TREE)              \
+   X(JIT)               \
+   X(PROFILE)
+
+/*
+ * Type: Keyword
+ * -------------
+ * This enumerated type has one constant for each keyword, named by
+ * prefixing the keyword with KEYWORD_, together with KEYWORD_NONE for
+ * words that are not keywords.
+ */
+
+#define KEYWORD_ENUM(name) KEYWORD_##name,
+
+enum Keyword {
+   KEYWORD_NONE = -1,
+   KEYWORD_LIST(KEYWORD_ENUM)
+   KEYWORD_COUNT
+};
+
+#undef KEYWORD_ENUM
+
+/*
+ * Function: lookupKeyword
+ * Usage: Keyword keyword = lookupKeyword(text, length);
+ * -----------------------------------------------------
+ * Returns the keyword spelled by the length characters at text,
+ * ignoring case, or KEYWORD_NONE if they do not spell one.  The text
+ * need not end with a null character, and nothing is allocated.
+ */
+
+Keyword lookupKeyword(const char *text, int length);
+
+/*
+ * Function: getKeywordName
+ * Usage: const char *name = getKeywordName(keyword);
+ * --------------------------------------------------
+ * Returns the upper-case spelling of the keyword.
+ */
+
+const char *getKeywordName(Keyword keyword);
+
+/*
+ * Implementation notes: perfect hash
+ * ----------------------------------
+ * A word is hashed by running FNV-1a over its characters with the
+ * case bit forced on, so that upper and lower case hash alike, and
+ * keeping the top bits as a bucket number below KEYWORD_BUCKETS.  The
+ * hash starts from a seed, and KEYWORD_SEED is the first seed for
+ * which no two keywords share a bucket; the compiler finds it while
+ * compiling this header, so a new keyword can never collide with an
+ * old one.  Every function here is written as a single return
+ * statement so that it can be evaluated by a C++11 compiler.
+ */
+
+const int KEYWORD_BITS = 8;
+const unsigned KEYWORD_BUCKETS = 1u << KEYWORD_BITS;
+
+#define KEYWORD_STRING(name) #name,
+
+constexpr const char *KEYWORD_NAMES[] = {
+   KEYWORD_LIST(KEYWORD_STRING)
+};
+
+#undef KEYWORD_STRING
+
+constexpr unsigned hashKeyword(const char *text, int length, unsigned hash) {
+   return (length == 0) ? hash >> (32 - KEYWORD_BITS)
+        : hashKeyword(text + 1, length - 1,
+                      ((hash ^ ((unsigned char) *text | 0x20)) * 16777619u) & 0xFFFFFFFFu);
+}
+
+constexpr int keywordLength(const char *name) {
+   return (*name == '\0') ? 0 : 1 + keywordLength(name + 1);
+}
+
+constexpr unsigned keywordBucket(int k, unsigned seed) {
+   return hashKeyword(KEYWORD_NAMES[k], keywordLength(KEYWORD_NAMES[k]), seed);
+}
+
+constexpr bool collidesAfter(int k, int other, unsigned seed) {
+   return other < KEYWORD_COUNT
+       && (keywordBucket(k, seed) == keywordBucket(other, seed)
+           || collidesAfter(k, other + 1, seed));
+}
+
+constexpr bool isPerfectSeed(unsigned seed, int k) {
+   return k >= KEYWORD_COUNT
+       || (!collidesAfter(k, k + 1, seed) && isPerfectSeed(seed, k + 1));
+}
+
+constexpr unsigned findKeywordSeed(unsigned seed) {
+   return isPerfectSeed(seed, 0) ? seed : findKeywordSeed(seed + 1);
+}
+
+constexpr unsigned KEYWORD_SEED = findKeywordSeed(2166136261u);
+
+#endif
@@ -0,0 +1,169 @@
+/*
+ * File: lexer.cpp
+ * ---------------
+ * This file implements the Lexer class.
+ */
+
+#include <cctype>
+#include <climits>
+#include <string>
+#include <vector>
+#include "error.h"
+#include "lexer.h"
+#include "strlib.h"
+using namespace std;
+
+Lexer::Lexer() {
+   setInput("", 0);
+}
+
+void Lexer::setInput(const string & line) {
+   setInput(line.data(), line.length());
+}
+
+/*
+ * Implementation notes: setInput
+ * ------------------------------
+ * The tokens are stored with clear and push_back, which keep the
+ * capacity of the vector, so the array is reallocated only when a line
+ * has more tokens than any line before it.
+ */
+
+void Lexer::setInput(const char *text, int length) {
+   this->text = text;
+   tokens.clear();
+   int cp = 0;
+   while (true) {
+      while (cp < length && isspace((unsigned char) text[cp])) {
+         cp++;
+      }
+      Token token;
+      token.offset = cp;
+      token.value = 0;
+      token.isInteger = false;
+      token.isLong = false;
+      if (cp == length) {
+         token.kind = TOKEN_END;
+         token.length = 0;
+         tokens.push_back(token);
+         break;
+      }
+      unsigned char ch = text[cp];
+      if (isdigit(ch)) {
+         scanNumber(token, cp, length);
+      } else if (isalpha(ch)) {
+         token.kind = TOKEN_WORD;
+         while (cp < length && isalnum((unsigned char) text[cp])) {
+            cp++;
+         }
+         if (cp < length && (text[cp] == '%' || text[cp] == '#')) cp++;
+      } else {
+         token.kind = TOKEN_OPERATOR;
+         token.value = ch;
+         cp++;
+      }
+      token.length = cp - token.offset;
+      tokens.push_back(token);
+   }
+   count = tokens.size() - 1;
+   position = 0;
+}
+
+bool Lexer::hasMoreTokens() const {
+   return position < count;
+}
+
+Token Lexer::nextToken() {
+   int index = (position < count) ? position : count;
+   position++;
+   return tokens[index];
+}
+
+void Lexer::unreadToken() {
+   if (position > 0) position--;
+}
+
+string Lexer::getText(const Token & token) const {
+   return string(text + token.offset, token.length);
+}
+
+Keyword Lexer::getKeyword(const Token & token) const {
+   if (token.kind != TOKEN_WORD) return KEYWORD_NONE;
+   return lookupKeyword(text + token.offset, token.length);
+}
+
+int Lexer::getInteger(const Token & token) const {
+   if (token.kind != TOKEN_NUMBER || !token.isInteger) {
+      error("stringToInteger: Illegal integer format (" + getText(token) + ")");
+   }
+   return token.value;
+}
+
+long long Lexer::getLong(const Token & token) const {
+   if (token.kind != TOKEN_NUMBER || !token.isLong) {
+      error("stringToInteger: Illegal integer format (" + getText(token) + ")");
+   }
+   long long value = 0;
+   for (int i = 0; i < token.length; i++) {
+      value = 10 * value + (text[token.offset + i] - '0');
+   }
+   return value;
+}
+
+double Lexer::getReal(const Token & token) const {
+   if (token.kind != TOKEN_NUMBER) {
+      error("stringToReal: Illegal floating-point format (" + getText(token) + ")");
+   }
+   return stringToReal(getText(token));
+}
+
+/*
+ * Implementation notes: scanNumber
+ * --------------------------------
+ * A number has the same form as in TokenScanner: digits, optionally
+ * followed by a decimal point and more digits, optionally followed by
+ * an exponent.  An E that is not followed by digits, with or without
+ * a sign, is not part of the number.  The value is accumulated while
+ * the digits are scanned, so the parser never converts text that fits
+ * in an int.  The accumulation stops once the value passes the largest
+ * 64-bit integer, which is checked before each step so that it never
+ * overflows.
+ */
+
+void Lexer::scanNumber(Token & token, int & cp, int length) {
+   token.kind = TOKEN_NUMBER;
+   token.isInteger = true;
+   token.isLong = true;
+   unsigned long long value = 0;
+   while (cp < length && isdigit((unsigned char) text[cp])) {
+      int digit = text[cp] - '0';
+      if (value > (LLONG_MAX - digit) / 10) {
+         token.isLong = false;
+      } else if (token.isLong) {
+         value = 10 * value + digit;
+      }
+      cp++;
+   }
+   if (!token.isLong || value > INT_MAX) token.isInteger = false;
+   if (cp < length && text[cp] == '.') {
+      token.isInteger = false;
+      token.isLong = false;
+      cp++;
+      while (cp < length && isdigit((unsigned char) text[cp])) {
+         cp++;
+      }
+   }
+   if (cp < length && (text[cp] == 'E' || text[cp] == 'e')) {
+      int ep = cp + 1;
+      if (ep < length && (text[ep] == '+' || text[ep] == '-')) ep++;
+      if (ep < length && isdigit((unsigned char) text[ep])) {
+         token.isInteger = false;
+         token.isLong = false;
+         cp = ep;
+         while (cp < length && isdigit((unsigned char) text[cp])) {
+            cp++;
+         }
+      }
+   }
+   token.value = token.isInteger ? (int) value : 0;
+}
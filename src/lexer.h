@@ -0,0 +1,168 @@
+/*
+ * File: lexer.h
+ * -------------
+ * This interface exports the Lexer class, which divides a line of BASIC
+ * into tokens for the parser.
+ */
+
+#ifndef _lexer_h
+#define _lexer_h
+
+#include <string>
+#include <vector>
+#include "keywords.h"
+
+/*
+ * Type: TokenKind
+ * ---------------
+ * This enumerated type identifies the kind of a token.  A word begins
+ * with a letter and continues with letters and digits, and may end with
+ * one of the type suffixes % or #.  A number begins with a digit, and
+ * every other character that is not whitespace is an operator token on
+ * its own.  The kind TOKEN_END marks the end of the line.
+ */
+
+enum TokenKind { TOKEN_END, TOKEN_WORD, TOKEN_NUMBER, TOKEN_OPERATOR };
+
+/*
+ * Type: Token
+ * -----------
+ * This structure describes one token by its position in the line
+ * rather than by a copy of its text.  For a number, value holds its
+ * integer value, and isInteger is false if the number has a fraction
+ * or an exponent or does not fit in an int.  Similarly, isLong is false
+ * if it has a fraction or an exponent or does not fit in 64 bits.  For
+ * an operator, value is the operator character.
+ */
+
+struct Token {
+   TokenKind kind;
+   int offset;
+   int length;
+   int value;
+   bool isInteger;
+   bool isLong;
+};
+
+/*
+ * Class: Lexer
+ * ------------
+ * This class scans a whole line into an array of tokens when the input
+ * is set, and then hands the tokens to the parser one at a time.  The
+ * array is kept from one line to the next, so once it has grown to the
+ * length of the longest line, scanning allocates no memory at all; the
+ * tokens refer to the line by offset, and their text is copied only
+ * when the parser needs it as a string.  The lexer recognizes the same
+ * tokens as a TokenScanner set to ignore whitespace and scan numbers.
+ */
+
+class Lexer {
+
+public:
+
+/*
+ * Constructor: Lexer
+ * Usage: Lexer lexer;
+ * -------------------
+ * Creates a lexer with an empty line.
+ */
+
+   Lexer();
+
+/*
+ * Method: setInput
+ * Usage: lexer.setInput(line);
+ *        lexer.setInput(text, length);
+ * ------------------------------------
+ * Scans the specified line, which the lexer does not copy.  The line
+ * must therefore remain unchanged for as long as its tokens are in use.
+ */
+
+   void setInput(const std::string & line);
+   void setInput(const char *text, int length);
+
+/*
+ * Method: hasMoreTokens
+ * Usage: if (lexer.hasMoreTokens()) . . .
+ * ---------------------------------------
+ * Returns true if there are tokens left to read on the line.
+ */
+
+   bool hasMoreTokens() const;
+
+/*
+ * Method: nextToken
+ * Usage: Token token = lexer.nextToken();
+ * ---------------------------------------
+ * Returns the next token on the line.  At the end of the line, it
+ * returns a token of kind TOKEN_END, as often as it is called.
+ */
+
+   Token nextToken();
+
+/*
+ * Method: unreadToken
+ * Usage: lexer.unreadToken();
+ * ---------------------------
+ * Backs up by one token, so that the next call to nextToken returns
+ * the token just read again.
+ */
+
+   void unreadToken();
+
+/*
+ * Method: getText
+ * Usage: string text = lexer.getText(token);
+ * ------------------------------------------
+ * Returns the text of the token, which is empty for TOKEN_END.
+ */
+
+   std::string getText(const Token & token) const;
+
+/*
+ * Method: getKeyword
+ * Usage: if (lexer.getKeyword(token) == KEYWORD_THEN) . . .
+ * ---------------------------------------------------------
+ * Returns the keyword that the token spells, ignoring case, or
+ * KEYWORD_NONE if the token is not a word or not a keyword.
+ */
+
+   Keyword getKeyword(const Token & token) const;
+
+/*
+ * Method: getInteger
+ * Usage: int n = lexer.getInteger(token);
+ * ---------------------------------------
+ * Returns the value of the token, which must be a number that fits in
+ * an int.  Any other token is reported with the same error that
+ * stringToInteger raises for its text.
+ */
+
+   int getInteger(const Token & token) const;
+
+/*
+ * Methods: getLong, getReal
+ * Usage: long long n = lexer.getLong(token);
+ *        double x = lexer.getReal(token);
+ * ------------------------------------------
+ * Return the value of a number token as a 64-bit integer, which
+ * requires that isLong be true, or as a double, which any number
+ * allows.  Any other token is reported with the same error that
+ * stringToInteger or stringToReal raises for its text.
+ */
+
+   long long getLong(const Token & token) const;
+   double getReal(const Token & token) const;
+
+private:
+
+   const char *text;            /* The line, which is not owned      */
+   std::vector<Token> tokens;   /* The tokens, ending with TOKEN_END */
+   int count;                   /* The number of tokens before END   */
+   int position;                /* The index of the next token       */
+
+   void scanNumber(Token & token, int & cp, int length);
+
+};
+
+#endif
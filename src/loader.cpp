@@ -0,0 +1,55 @@
+/*
+ * File: loader.cpp
+ * ----------------
+ * This file implements the loader.h interface.
+ */
+
+#include <iostream>
+#include <string>
+#include "arena.h"
+#include "error.h"
+#include "lexer.h"
+#include "loader.h"
+#include "optimizer.h"
+#include "parser.h"
+#include "resolver.h"
+#include "statement.h"
+#include "strlib.h"
+using namespace std;
+
+void addProgramLine(int lineNumber, Lexer & lexer, string line,
+                    Program & program, EvalState & state) {
+    Arena arena;
+    Statement *stmt = parseStatement(lexer, arena);
+    int eliminated = optimizeStatement(stmt, arena);
+    resolveSymbols(stmt, state);
+    program.addSourceLine(lineNumber, line);
+    program.setParsedStatement(lineNumber, stmt, arena);
+    program.setEliminatedNodes(lineNumber, eliminated);
+}
+
+void loadProgram(istream & infile, Program & program, EvalState & state) {
+    Lexer lexer;
+    string line;
+    int position = 0;
+    while (getline(infile, line)) {
+        position++;
+        lexer.setInput(line);
+        if (!lexer.hasMoreTokens()) continue;
+        Token token = lexer.nextToken();
+        try {
+            if (token.kind != TOKEN_NUMBER) {
+                error("Expected a line number");
+            }
+            int lineNumber = lexer.getInteger(token);
+            if (lexer.hasMoreTokens()) {
+                addProgramLine(lineNumber, lexer, line, program, state);
+            } else {
+                program.removeSourceLine(lineNumber);
+            }
+        } catch (ErrorException & ex) {
+            error("Line " + integerToString(position) + " of program file: "
+                  + ex.getMessage());
+        }
+    }
+}
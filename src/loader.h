@@ -0,0 +1,43 @@
+/*
+ * File: loader.h
+ * --------------
+ * This interface exports the functions that parse the lines of a BASIC
+ * program and store them in a Program.  They are shared by the
+ * interactive interpreter and by the batch interface in batch.h.
+ */
+
+#ifndef _loader_h
+#define _loader_h
+
+#include <iostream>
+#include <string>
+#include "evalstate.h"
+#include "lexer.h"
+#include "program.h"
+
+/*
+ * Function: addProgramLine
+ * Usage: addProgramLine(lineNumber, lexer, line, program, state);
+ * ---------------------------------------------------------------
+ * Parses the statement that follows the line number in the lexer,
+ * simplifies its expressions, and stores it, along with the source
+ * line, in the program.  If the statement cannot be parsed, the
+ * program is left unchanged.
+ */
+
+void addProgramLine(int lineNumber, Lexer & lexer, std::string line,
+                    Program & program, EvalState & state);
+
+/*
+ * Function: loadProgram
+ * Usage: loadProgram(infile, program, state);
+ * -------------------------------------------
+ * Reads every line of the stream into the program.  Each nonblank
+ * line must begin with a line number; as at the console, a line that
+ * holds only a number deletes that line.  Errors are reported with
+ * the position of the offending line in the file.
+ */
+
+void loadProgram(std::istream & infile, Program & program, EvalState & state);
+
+#endif
@@ -0,0 +1,320 @@
+/*
+ * File: matrix.cpp
+ * ----------------
+ * This file implements the MAT operations and their kernels.
+ */
+
+#include <string>
+#include <vector>
+#include "error.h"
+#include "evalstate.h"
+#include "matrix.h"
+#include "output.h"
+using namespace std;
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#  define MATRIX_AVX2
+#  include <immintrin.h>
+#endif
+
+/* Private function prototypes */
+
+static const ArrayInfo & getArray(EvalState & state, int slot);
+static string getArrayName(EvalState & state, int slot);
+static int getSize(const ArrayInfo & array);
+static bool isSameShape(const ArrayInfo & a, const ArrayInfo & b);
+
+/*
+ * Implementation notes: executeMat
+ * --------------------------------
+ * The dimensions are checked before anything is written, so an
+ * operation that fails leaves its result unchanged; MAT READ reads all
+ * of its values before storing any of them for the same reason.  A
+ * product or transpose whose result is one of its operands is computed
+ * into a temporary array and copied, since each element of the result
+ * depends on several elements of the operands.  The elementwise
+ * operations can work in place.
+ */
+
+void executeMat(MatOperation op, int dest, int lhs, int rhs, int scalar,
+                EvalState & state) {
+   const MatrixKernels & kernels = getMatrixKernels();
+   const ArrayInfo & c = getArray(state, dest);
+   switch (op) {
+    case MAT_READ: {
+      vector<int> values(getSize(c));
+      for (size_t i = 0; i < values.size(); i++) {
+         values[i] = state.readData();
+      }
+      copy(values.begin(), values.end(), c.elements);
+      return;
+    }
+    case MAT_PRINT:
+      if (c.columns == 0) {
+         state.getOutput().printIntegers(c.elements, c.length);
+      } else {
+         for (int i = 0; i < c.rows; i++) {
+            state.getOutput().printIntegers(c.elements + i * c.columns, c.columns);
+         }
+      }
+      return;
+    default:
+      break;
+   }
+   const ArrayInfo & a = getArray(state, lhs);
+   const ArrayInfo & b = getArray(state, rhs);
+   if (op == MAT_ADD || op == MAT_SUB) {
+      if (!isSameShape(a, b)) {
+         error("Arrays " + getArrayName(state, lhs) + " and " + getArrayName(state, rhs)
+               + " do not have the same dimensions");
+      }
+   } else if (op == MAT_MUL) {
+      if (a.columns == 0 || b.columns == 0 || a.columns != b.rows) {
+         error("Arrays " + getArrayName(state, lhs) + " and " + getArrayName(state, rhs)
+               + " cannot be multiplied");
+      }
+   } else if (op == MAT_TRN && a.columns == 0) {
+      error("Array " + getArrayName(state, lhs) + " is not a matrix");
+   }
+   bool fits;
+   switch (op) {
+    case MAT_MUL: fits = c.rows == a.rows && c.columns == b.columns; break;
+    case MAT_TRN: fits = c.rows == a.columns && c.columns == a.rows; break;
+    default: fits = isSameShape(c, a); break;
+   }
+   if (!fits) {
+      error("Array " + getArrayName(state, dest) + " does not have the dimensions of the result");
+   }
+   int n = getSize(c);
+   switch (op) {
+    case MAT_COPY:
+      if (dest != lhs) copy(a.elements, a.elements + n, c.elements);
+      break;
+    case MAT_ADD:
+      kernels.add(a.elements, b.elements, c.elements, n);
+      break;
+    case MAT_SUB:
+      kernels.subtract(a.elements, b.elements, c.elements, n);
+      break;
+    case MAT_SCALE:
+      kernels.scale(scalar, a.elements, c.elements, n);
+      break;
+    case MAT_MUL: case MAT_TRN: {
+      vector<int> temporary;
+      int *result = c.elements;
+      if (dest == lhs || dest == rhs) {
+         temporary.resize(n);
+         result = &temporary[0];
+      }
+      if (op == MAT_MUL) {
+         kernels.multiply(a.elements, b.elements, result, a.rows, a.columns, b.columns);
+      } else {
+         for (int i = 0; i < a.rows; i++) {
+            for (int j = 0; j < a.columns; j++) {
+               result[j * a.rows + i] = a.elements[i * a.columns + j];
+            }
+         }
+      }
+      if (result != c.elements) copy(temporary.begin(), temporary.end(), c.elements);
+      break;
+    }
+    default:
+      error("Illegal MAT operation");
+   }
+}
+
+/*
+ * Implementation notes: scalar kernels
+ * ------------------------------------
+ * The arithmetic is done on unsigned values, whose overflow is defined
+ * to wrap around, and the results are converted back.  The product
+ * runs over each row of the first matrix, adding multiples of the rows
+ * of the second into the row of the result, so that the innermost loop
+ * walks all three arrays in order.
+ */
+
+static void addScalar(const int *a, const int *b, int *c, int n) {
+   for (int i = 0; i < n; i++) {
+      c[i] = (unsigned) a[i] + (unsigned) b[i];
+   }
+}
+
+static void subtractScalar(const int *a, const int *b, int *c, int n) {
+   for (int i = 0; i < n; i++) {
+      c[i] = (unsigned) a[i] - (unsigned) b[i];
+   }
+}
+
+static void scaleScalar(int k, const int *a, int *c, int n) {
+   for (int i = 0; i < n; i++) {
+      c[i] = (unsigned) k * (unsigned) a[i];
+   }
+}
+
+static void multiplyScalar(const int *a, const int *b, int *c,
+                           int rows, int inner, int columns) {
+   for (int i = 0; i < rows; i++) {
+      int *row = c + i * columns;
+      for (int j = 0; j < columns; j++) {
+         row[j] = 0;
+      }
+      for (int p = 0; p < inner; p++) {
+         unsigned x = a[i * inner + p];
+         const int *brow = b + p * columns;
+         for (int j = 0; j < columns; j++) {
+            row[j] = (unsigned) row[j] + x * (unsigned) brow[j];
+         }
+      }
+   }
+}
+
+static const MatrixKernels SCALAR_KERNELS = {
+   addScalar, subtractScalar, scaleScalar, multiplyScalar, "scalar"
+};
+
+#ifdef MATRIX_AVX2
+
+/*
+ * Implementation notes: AVX2 kernels
+ * ----------------------------------
+ * These functions are compiled for AVX2 through the target attribute,
+ * so the rest of the program still runs on processors without it, and
+ * getMatrixKernels calls them only after checking that the processor
+ * has it.  Each handles eight elements per instruction and leaves the
+ * last few elements to a scalar loop.  The vector additions and the
+ * low half of the vector products wrap around just as the scalar
+ * arithmetic does.
+ *
+ * The product computes each row of the result in strips of up to 32
+ * columns, keeping a strip in four registers while it accumulates the
+ * multiples of the corresponding strips of the rows of the second
+ * matrix, so that the result is stored once rather than once for each
+ * term of the inner sum.
+ */
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static void addAvx2(const int *a, const int *b, int *c, int n) {
+   int i = 0;
+   for (; i + 8 <= n; i += 8) {
+      __m256i x = _mm256_loadu_si256((const __m256i *) (a + i));
+      __m256i y = _mm256_loadu_si256((const __m256i *) (b + i));
+      _mm256_storeu_si256((__m256i *) (c + i), _mm256_add_epi32(x, y));
+   }
+   addScalar(a + i, b + i, c + i, n - i);
+}
+
+AVX2 static void subtractAvx2(const int *a, const int *b, int *c, int n) {
+   int i = 0;
+   for (; i + 8 <= n; i += 8) {
+      __m256i x = _mm256_loadu_si256((const __m256i *) (a + i));
+      __m256i y = _mm256_loadu_si256((const __m256i *) (b + i));
+      _mm256_storeu_si256((__m256i *) (c + i), _mm256_sub_epi32(x, y));
+   }
+   subtractScalar(a + i, b + i, c + i, n - i);
+}
+
+AVX2 static void scaleAvx2(int k, const int *a, int *c, int n) {
+   __m256i factor = _mm256_set1_epi32(k);
+   int i = 0;
+   for (; i + 8 <= n; i += 8) {
+      __m256i x = _mm256_loadu_si256((const __m256i *) (a + i));
+      _mm256_storeu_si256((__m256i *) (c + i), _mm256_mullo_epi32(factor, x));
+   }
+   scaleScalar(k, a + i, c + i, n - i);
+}
+
+AVX2 static void multiplyAvx2(const int *a, const int *b, int *c,
+                              int rows, int inner, int columns) {
+   for (int i = 0; i < rows; i++) {
+      const int *arow = a + i * inner;
+      int *row = c + i * columns;
+      int j = 0;
+      for (; j + 32 <= columns; j += 32) {
+         __m256i sum0 = _mm256_setzero_si256();
+         __m256i sum1 = _mm256_setzero_si256();
+         __m256i sum2 = _mm256_setzero_si256();
+         __m256i sum3 = _mm256_setzero_si256();
+         for (int p = 0; p < inner; p++) {
+            __m256i x = _mm256_set1_epi32(arow[p]);
+            const int *brow = b + p * columns + j;
+            sum0 = _mm256_add_epi32(sum0, _mm256_mullo_epi32(x, _mm256_loadu_si256((const __m256i *) brow)));
+            sum1 = _mm256_add_epi32(sum1, _mm256_mullo_epi32(x, _mm256_loadu_si256((const __m256i *) (brow + 8))));
+            sum2 = _mm256_add_epi32(sum2, _mm256_mullo_epi32(x, _mm256_loadu_si256((const __m256i *) (brow + 16))));
+            sum3 = _mm256_add_epi32(sum3, _mm256_mullo_epi32(x, _mm256_loadu_si256((const __m256i *) (brow + 24))));
+         }
+         _mm256_storeu_si256((__m256i *) (row + j), sum0);
+         _mm256_storeu_si256((__m256i *) (row + j + 8), sum1);
+         _mm256_storeu_si256((__m256i *) (row + j + 16), sum2);
+         _mm256_storeu_si256((__m256i *) (row + j + 24), sum3);
+      }
+      for (; j + 8 <= columns; j += 8) {
+         __m256i sum = _mm256_setzero_si256();
+         for (int p = 0; p < inner; p++) {
+            __m256i x = _mm256_set1_epi32(arow[p]);
+            __m256i y = _mm256_loadu_si256((const __m256i *) (b + p * columns + j));
+            sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(x, y));
+         }
+         _mm256_storeu_si256((__m256i *) (row + j), sum);
+      }
+      for (; j < columns; j++) {
+         unsigned sum = 0;
+         for (int p = 0; p < inner; p++) {
+            sum += (unsigned) arow[p] * (unsigned) b[p * columns + j];
+         }
+         row[j] = sum;
+      }
+   }
+}
+
+#undef AVX2
+
+static const MatrixKernels AVX2_KERNELS = {
+   addAvx2, subtractAvx2, scaleAvx2, multiplyAvx2, "avx2"
+};
+
+#endif
+
+/*
+ * Implementation notes: getMatrixKernels
+ * --------------------------------------
+ * The processor is examined once, when the static variable is first
+ * initialized, which the language guarantees to happen exactly once
+ * even if several threads call the function at the same time.
+ */
+
+static const MatrixKernels *chooseKernels() {
+#ifdef MATRIX_AVX2
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx2")) return &AVX2_KERNELS;
+#endif
+   return &SCALAR_KERNELS;
+}
+
+const MatrixKernels & getMatrixKernels() {
+   static const MatrixKernels *kernels = chooseKernels();
+   return *kernels;
+}
+
+const MatrixKernels & getScalarKernels() {
+   return SCALAR_KERNELS;
+}
+
+static const ArrayInfo & getArray(EvalState & state, int slot) {
+   const ArrayInfo & array = state.getArrayTable()[slot];
+   if (array.elements == NULL) state.subscriptError(slot);
+   return array;
+}
+
+static string getArrayName(EvalState & state, int slot) {
+   const string & name = state.getName(slot);
+   return name.substr(0, name.length() - 2);
+}
+
+static int getSize(const ArrayInfo & array) {
+   return (array.columns == 0) ? array.length : array.rows * array.columns;
+}
+
+static bool isSameShape(const ArrayInfo & a, const ArrayInfo & b) {
+   return a.length == b.length && a.rows == b.rows && a.columns == b.columns;
+}
@@ -0,0 +1,92 @@
+/*
+ * File: matrix.h
+ * --------------
+ * This interface exports the whole-array operations performed by the
+ * MAT statement, which every engine shares, together with the kernels
+ * that do their arithmetic.
+ */
+
+#ifndef _matrix_h
+#define _matrix_h
+
+#include "evalstate.h"
+
+/*
+ * Type: MatOperation
+ * ------------------
+ * This enumerated type identifies the forms of the MAT statement:
+ *
+ *    MAT C = A           MAT_COPY
+ *    MAT C = A + B       MAT_ADD
+ *    MAT C = A - B       MAT_SUB
+ *    MAT C = A * B       MAT_MUL
+ *    MAT C = (k) * A     MAT_SCALE
+ *    MAT C = TRN(A)      MAT_TRN
+ *    MAT READ A          MAT_READ
+ *    MAT PRINT A         MAT_PRINT
+ */
+
+enum MatOperation {
+   MAT_COPY, MAT_ADD, MAT_SUB, MAT_MUL, MAT_SCALE, MAT_TRN, MAT_READ,
+   MAT_PRINT, MAT_COUNT
+};
+
+/*
+ * Function: executeMat
+ * Usage: executeMat(op, dest, lhs, rhs, scalar, state);
+ * -----------------------------------------------------
+ * Performs the MAT operation op on the arrays at the slots dest, lhs
+ * and rhs, which are the C, A and B of the forms above, using scalar
+ * as the k of MAT_SCALE.  MAT READ and MAT PRINT use the array at
+ * dest.  Every array must have been dimensioned, and the dimensions
+ * must agree: the arrays of a sum or difference have the same shape as
+ * the result, a product multiplies an r by n matrix by an n by c one
+ * to give an r by c result, and a transpose turns an r by c matrix
+ * into a c by r one.  Every element counts, including those with a
+ * subscript of zero.  The result may be one of the operands.
+ */
+
+void executeMat(MatOperation op, int dest, int lhs, int rhs, int scalar,
+                EvalState & state);
+
+/*
+ * Type: MatrixKernels
+ * -------------------
+ * This structure holds the functions that do the arithmetic of the
+ * MAT operations on blocks of n elements, or on row-major matrices of
+ * the given sizes.  The arithmetic wraps around on overflow, just as
+ * it does in expressions.  The result of multiply may not overlap
+ * either operand.
+ */
+
+struct MatrixKernels {
+   void (*add)(const int *a, const int *b, int *c, int n);
+   void (*subtract)(const int *a, const int *b, int *c, int n);
+   void (*scale)(int k, const int *a, int *c, int n);
+   void (*multiply)(const int *a, const int *b, int *c,
+                    int rows, int inner, int columns);
+   const char *name;
+};
+
+/*
+ * Function: getMatrixKernels
+ * Usage: const MatrixKernels & kernels = getMatrixKernels();
+ * ----------------------------------------------------------
+ * Returns the fastest kernels that the processor supports, which use
+ * AVX2 if it is available and plain loops otherwise.  The choice is
+ * made the first time the function is called.
+ */
+
+const MatrixKernels & getMatrixKernels();
+
+/*
+ * Function: getScalarKernels
+ * Usage: const MatrixKernels & kernels = getScalarKernels();
+ * ----------------------------------------------------------
+ * Returns the plain-loop kernels, which run on any processor and give
+ * the same results as the others.
+ */
+
+const MatrixKernels & getScalarKernels();
+
+#endif
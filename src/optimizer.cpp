@@ -0,0 +1,195 @@
+/*
+ * File: optimizer.cpp
+ * -------------------
+ * This file implements the expression simplification pass.
+ */
+
+#include <climits>
+#include "arena.h"
+#include "exp.h"
+#include "optimizer.h"
+#include "statement.h"
+using namespace std;
+
+/* Private function prototypes */
+
+static bool isConstant(Expression *exp, int value);
+static bool foldConstants(OperatorType op, int lhs, int rhs, int & result);
+static Expression *replaceNode(Expression *result, int removed, int & eliminated);
+static Expression *combineConstants(CompoundExp *cexp, Arena & arena, int & eliminated);
+
+int optimizeStatement(Statement *stmt, Arena & arena) {
+   int eliminated = 0;
+   switch (stmt->getType()) {
+    case LET_STMT: {
+      LetStmt *let = (LetStmt *) stmt;
+      if (let->getElement() != NULL) simplifyExpression(let->getElement(), arena, eliminated);
+      let->setExp(simplifyExpression(let->getExp(), arena, eliminated));
+      break;
+    }
+    case PRINT_STMT: {
+      PrintStmt *print = (PrintStmt *) stmt;
+      print->setExp(simplifyExpression(print->getExp(), arena, eliminated));
+      break;
+    }
+    case IF_STMT: {
+      IfStmt *ifStmt = (IfStmt *) stmt;
+      ifStmt->setLHS(simplifyExpression(ifStmt->getLHS(), arena, eliminated));
+      ifStmt->setRHS(simplifyExpression(ifStmt->getRHS(), arena, eliminated));
+      break;
+    }
+    case FOR_STMT: {
+      ForStmt *forStmt = (ForStmt *) stmt;
+      forStmt->setStart(simplifyExpression(forStmt->getStart(), arena, eliminated));
+      forStmt->setLimit(simplifyExpression(forStmt->getLimit(), arena, eliminated));
+      forStmt->setStep(simplifyExpression(forStmt->getStep(), arena, eliminated));
+      break;
+    }
+    case MAT_STMT: {
+      MatStmt *mat = (MatStmt *) stmt;
+      if (mat->getScalar() != NULL) {
+         mat->setScalar(simplifyExpression(mat->getScalar(), arena, eliminated));
+      }
+      break;
+    }
+    default:
+      break;
+   }
+   return eliminated;
+}
+
+/*
+ * Implementation notes: simplifyExpression
+ * ----------------------------------------
+ * The tree is simplified from the bottom up, so that by the time an
+ * operator is examined its operands are already in simplest form.  No
+ * rule ever discards an operand that is not a constant, because doing
+ * so could hide an undefined variable or a division by zero that the
+ * original expression would report.  For the same reason x * 0 is left
+ * alone unless x is itself a constant.  The rules apply only to int
+ * arithmetic; an operator on 64-bit integers or doubles keeps its
+ * place, although its operands are still simplified.
+ */
+
+Expression *simplifyExpression(Expression *exp, Arena & arena, int & eliminated) {
+   if (exp->getType() == ARRAY) {
+      ArrayExp *element = (ArrayExp *) exp;
+      element->setRow(simplifyExpression(element->getRow(), arena, eliminated));
+      if (element->getColumn() != NULL) {
+         element->setColumn(simplifyExpression(element->getColumn(), arena, eliminated));
+      }
+      return element;
+   }
+   if (exp->getType() != COMPOUND) return exp;
+   CompoundExp *cexp = (CompoundExp *) exp;
+   OperatorType op = cexp->getOperator();
+   if (op == ASSIGN_OP) {
+      cexp->setRHS(simplifyExpression(cexp->getRHS(), arena, eliminated));
+      return cexp;
+   }
+   cexp->setLHS(simplifyExpression(cexp->getLHS(), arena, eliminated));
+   cexp->setRHS(simplifyExpression(cexp->getRHS(), arena, eliminated));
+   if (cexp->getKind() != INT_VALUE) return cexp;
+   Expression *lhs = cexp->getLHS();
+   Expression *rhs = cexp->getRHS();
+   if (lhs->getType() == CONSTANT && rhs->getType() == CONSTANT) {
+      int result;
+      if (foldConstants(op, ((ConstantExp *) lhs)->getValue(),
+                        ((ConstantExp *) rhs)->getValue(), result)) {
+         return replaceNode(arena.make<ConstantExp>(result), 2, eliminated);
+      }
+      return cexp;
+   }
+   if ((op == ADD_OP || op == SUB_OP) && isConstant(rhs, 0)) {
+      return replaceNode(lhs, 2, eliminated);
+   }
+   if ((op == MUL_OP || op == DIV_OP) && isConstant(rhs, 1)) {
+      return replaceNode(lhs, 2, eliminated);
+   }
+   if ((op == ADD_OP && isConstant(lhs, 0)) || (op == MUL_OP && isConstant(lhs, 1))) {
+      return replaceNode(rhs, 2, eliminated);
+   }
+   return combineConstants(cexp, arena, eliminated);
+}
+
+/*
+ * Implementation notes: combineConstants
+ * --------------------------------------
+ * This function handles a node of the form (x op1 c1) op2 c2.  When
+ * both operators are additive, the node becomes x + k, where k is the
+ * net offset; when both are multiplications, it becomes x * (c1 * c2).
+ * The arithmetic on the constants wraps around on overflow, just as
+ * addInt and multiplyInt do at run time, so the combined constant
+ * gives the same result.  A net offset of zero is removed altogether.
+ */
+
+static Expression *combineConstants(CompoundExp *cexp, Arena & arena, int & eliminated) {
+   OperatorType op = cexp->getOperator();
+   Expression *lhs = cexp->getLHS();
+   Expression *rhs = cexp->getRHS();
+   if (rhs->getType() != CONSTANT || lhs->getType() != COMPOUND) return cexp;
+   CompoundExp *inner = (CompoundExp *) lhs;
+   OperatorType innerOp = inner->getOperator();
+   if (inner->getRHS()->getType() != CONSTANT) return cexp;
+   unsigned c1 = ((ConstantExp *) inner->getRHS())->getValue();
+   unsigned c2 = ((ConstantExp *) rhs)->getValue();
+   Expression *x = inner->getLHS();
+   Expression *result;
+   if ((op == ADD_OP || op == SUB_OP) && (innerOp == ADD_OP || innerOp == SUB_OP)) {
+      unsigned offset = ((innerOp == ADD_OP) ? c1 : 0u - c1) + ((op == ADD_OP) ? c2 : 0u - c2);
+      if (offset == 0) {
+         result = x;
+      } else if ((int) offset < 0 && (int) offset != INT_MIN) {
+         result = arena.make<CompoundExp>(SUB_OP, x, arena.make<ConstantExp>(-(int) offset));
+      } else {
+         result = arena.make<CompoundExp>(ADD_OP, x, arena.make<ConstantExp>((int) offset));
+      }
+   } else if (op == MUL_OP && innerOp == MUL_OP) {
+      result = arena.make<CompoundExp>(MUL_OP, x, arena.make<ConstantExp>((int) (c1 * c2)));
+   } else {
+      return cexp;
+   }
+   return replaceNode(result, (result == x) ? 4 : 2, eliminated);
+}
+
+/*
+ * Function: replaceNode
+ * Usage: return replaceNode(result, removed, eliminated);
+ * -------------------------------------------------------
+ * Adds removed to the count of eliminated nodes and returns result,
+ * which takes the place of the node being simplified.  The nodes that
+ * drop out are left in the arena, which frees them with the statement.
+ */
+
+static Expression *replaceNode(Expression *result, int removed, int & eliminated) {
+   eliminated += removed;
+   return result;
+}
+
+static bool isConstant(Expression *exp, int value) {
+   return exp->getType() == CONSTANT && ((ConstantExp *) exp)->getValue() == value;
+}
+
+/*
+ * Function: foldConstants
+ * Usage: if (foldConstants(op, lhs, rhs, result)) . . .
+ * -----------------------------------------------------
+ * Computes lhs op rhs with the same functions that the engines use at
+ * run time and stores it in result, returning false instead if the
+ * operation must be left for run time.  That is the case only for a
+ * division by zero, which must still be reported.
+ */
+
+static bool foldConstants(OperatorType op, int lhs, int rhs, int & result) {
+   switch (op) {
+    case ADD_OP: result = addInt(lhs, rhs); return true;
+    case SUB_OP: result = subtractInt(lhs, rhs); return true;
+    case MUL_OP: result = multiplyInt(lhs, rhs); return true;
+    case DIV_OP:
+      if (rhs == 0) return false;
+      result = divideInt(lhs, rhs);
+      return true;
+    default:
+      return false;
+   }
+}
@@ -0,0 +1,51 @@
+/*
+ * File: optimizer.h
+ * -----------------
+ * This interface exports the optimization pass that simplifies the
+ * expressions in a parsed statement.
+ */
+
+#ifndef _optimizer_h
+#define _optimizer_h
+
+#include "arena.h"
+#include "exp.h"
+#include "statement.h"
+
+/*
+ * Function: optimizeStatement
+ * Usage: int eliminated = optimizeStatement(stmt, arena);
+ * -------------------------------------------------------
+ * Simplifies every expression in the statement and returns the number
+ * of expression nodes that the simplification removed.  Any new nodes
+ * are created in the arena, which must be the one that owns stmt.
+ * The rewritten statement computes exactly the same values and raises
+ * exactly the same errors as the original; in particular, a division
+ * by zero is never folded away, so it is still reported at run time.
+ */
+
+int optimizeStatement(Statement *stmt, Arena & arena);
+
+/*
+ * Function: simplifyExpression
+ * Usage: exp = simplifyExpression(exp, arena, eliminated);
+ * --------------------------------------------------------
+ * Returns a simplified version of exp, adding the number of nodes
+ * removed to eliminated.  The result may share nodes with exp, and the
+ * caller must use it in place of exp.  Nodes that drop out of the tree
+ * are not freed individually but stay in the arena, along with any new
+ * nodes, until the arena is cleared.  The simplifications are
+ *
+ *  - folding an operator whose operands are both constants,
+ *  - removing the identities x + 0, 0 + x, x - 0, x * 1, 1 * x and
+ *    x / 1, and
+ *  - combining the constants in (x + c1) + c2 and (x * c1) * c2, and
+ *    in the forms of the first that use subtraction.
+ *
+ * Integer arithmetic wraps on overflow, as it does when the program
+ * runs, so the combined constants give the same results.
+ */
+
+Expression *simplifyExpression(Expression *exp, Arena & arena, int & eliminated);
+
+#endif
@@ -0,0 +1,147 @@
+/*
+ * File: output.cpp
+ * ----------------
+ * This file implements the OutputBuffer class.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include "output.h"
+using namespace std;
+
+OutputBuffer::OutputBuffer(ostream & stream, int capacity) {
+   this->stream = &stream;
+   buffer.resize(capacity < MAX_REAL_LENGTH ? MAX_REAL_LENGTH : capacity);
+   count = 0;
+   flushInterval = 0;
+   bytesWritten = 0;
+   flushCount = 0;
+   lastFlush = chrono::steady_clock::now();
+}
+
+OutputBuffer::~OutputBuffer() {
+   flush();
+}
+
+/*
+ * Implementation notes: printInteger, appendInteger
+ * -------------------------------------------------
+ * The digits are generated from right to left into a small local
+ * array and then copied into the buffer, which avoids the locale and
+ * formatting machinery of the stream library.  The magnitude is taken
+ * as an unsigned value so that the most negative integer is printed
+ * correctly.  Every integer goes through the 64-bit version, whose
+ * division by ten compiles to a multiplication just as the 32-bit one
+ * does.
+ */
+
+void OutputBuffer::printInteger(int value) {
+   appendInteger(value, '\n');
+   if (flushInterval > 0) checkInterval();
+}
+
+void OutputBuffer::printLong(long long value) {
+   appendInteger(value, '\n');
+   if (flushInterval > 0) checkInterval();
+}
+
+/*
+ * Implementation notes: printDouble
+ * ---------------------------------
+ * The %g format of snprintf already drops trailing zeros and switches
+ * to an exponent for very large and very small magnitudes, and writing
+ * straight into the buffer avoids building a string.
+ */
+
+void OutputBuffer::printDouble(double value) {
+   if (count + MAX_REAL_LENGTH > (int) buffer.size()) flush();
+   int length = snprintf(&buffer[count], MAX_REAL_LENGTH, "%.15g\n", value);
+   count += length;
+   if (flushInterval > 0) checkInterval();
+}
+
+void OutputBuffer::printIntegers(const int *values, int n) {
+   for (int i = 0; i < n; i++) {
+      appendInteger(values[i], (i == n - 1) ? '\n' : ' ');
+   }
+   if (flushInterval > 0) checkInterval();
+}
+
+void OutputBuffer::appendInteger(long long value, char terminator) {
+   if (count + MAX_INTEGER_LENGTH > (int) buffer.size()) flush();
+   char digits[MAX_INTEGER_LENGTH];
+   char *cp = digits + MAX_INTEGER_LENGTH;
+   *--cp = terminator;
+   unsigned long long magnitude = (value < 0) ? 0ull - (unsigned long long) value
+                                              : (unsigned long long) value;
+   do {
+      *--cp = '0' + magnitude % 10;
+      magnitude /= 10;
+   } while (magnitude != 0);
+   if (value < 0) *--cp = '-';
+   int length = digits + MAX_INTEGER_LENGTH - cp;
+   memcpy(&buffer[count], cp, length);
+   count += length;
+}
+
+void OutputBuffer::write(const string & str) {
+   if (count + (int) str.length() > (int) buffer.size()) {
+      flush();
+      if (str.length() > buffer.size()) {
+         stream->write(str.data(), str.length());
+         bytesWritten += str.length();
+         stream->flush();
+         flushCount++;
+         lastFlush = chrono::steady_clock::now();
+         return;
+      }
+   }
+   memcpy(&buffer[count], str.data(), str.length());
+   count += str.length();
+   if (flushInterval > 0) checkInterval();
+}
+
+void OutputBuffer::flush() {
+   if (count == 0) return;
+   stream->write(&buffer[0], count);
+   stream->flush();
+   bytesWritten += count;
+   flushCount++;
+   count = 0;
+   if (flushInterval > 0) lastFlush = chrono::steady_clock::now();
+}
+
+void OutputBuffer::setStream(ostream & stream) {
+   flush();
+   this->stream = &stream;
+}
+
+void OutputBuffer::setFlushInterval(int milliseconds) {
+   flushInterval = (milliseconds < 0) ? 0 : milliseconds;
+   lastFlush = chrono::steady_clock::now();
+}
+
+int OutputBuffer::getFlushInterval() const {
+   return flushInterval;
+}
+
+long OutputBuffer::getBytesWritten() const {
+   return bytesWritten;
+}
+
+long OutputBuffer::getFlushCount() const {
+   return flushCount;
+}
+
+void OutputBuffer::resetStatistics() {
+   bytesWritten = 0;
+   flushCount = 0;
+}
+
+void OutputBuffer::checkInterval() {
+   chrono::steady_clock::time_point now = chrono::steady_clock::now();
+   if (now - lastFlush >= chrono::milliseconds(flushInterval)) flush();
+}
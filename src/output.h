@@ -0,0 +1,193 @@
+/*
+ * File: output.h
+ * --------------
+ * This interface exports the OutputBuffer class, which collects the
+ * output of PRINT statements and passes it to the underlying stream
+ * in large blocks.
+ */
+
+#ifndef _output_h
+#define _output_h
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+ * Class: OutputBuffer
+ * -------------------
+ * This class batches the text written by a running program.  Writing
+ * each value with endl flushes the stream every time, and through the
+ * graphical console every flush is a separate message to the Java back
+ * end, so programs that print heavily spend most of their time in the
+ * output system.  An OutputBuffer instead holds the text until one of
+ * the following happens:
+ *
+ *  - the buffer fills,
+ *  - flush is called, which the interpreter does before each INPUT
+ *    and at the end of each command, or
+ *  - a value is written after the flush interval has elapsed.
+ *
+ * The buffer also counts the bytes written and the number of flushes,
+ * so that the effect of buffering can be measured.
+ */
+
+class OutputBuffer {
+
+public:
+
+/* Constants */
+
+   static const int DEFAULT_CAPACITY = 64 * 1024;
+
+/*
+ * Constructor: OutputBuffer
+ * Usage: OutputBuffer out;
+ *        OutputBuffer out(stream, capacity);
+ * ------------------------------------------
+ * Creates a buffer that writes to the specified stream, which is cout
+ * if none is given.
+ */
+
+   OutputBuffer(std::ostream & stream = std::cout, int capacity = DEFAULT_CAPACITY);
+
+/*
+ * Destructor: ~OutputBuffer
+ * Usage: usually implicit
+ * -----------------------
+ * Flushes any text that remains in the buffer.
+ */
+
+   ~OutputBuffer();
+
+/*
+ * Method: printInteger
+ * Usage: out.printInteger(value);
+ * -------------------------------
+ * Adds the decimal form of value to the buffer, followed by a newline.
+ * This is the output of a single PRINT statement.
+ */
+
+   void printInteger(int value);
+
+/*
+ * Methods: printLong, printDouble
+ * Usage: out.printLong(value);
+ *        out.printDouble(value);
+ * ------------------------------
+ * These methods are the counterparts of printInteger for 64-bit
+ * integers and doubles.  A double is written with up to 15 significant
+ * digits, which is as many as every double holds exactly, and without
+ * trailing zeros, so that a whole number prints as an integer does.
+ */
+
+   void printLong(long long value);
+   void printDouble(double value);
+
+/*
+ * Method: printIntegers
+ * Usage: out.printIntegers(values, n);
+ * ------------------------------------
+ * Adds the decimal forms of the n values to the buffer on one line,
+ * separated by spaces.  This is the output of one row of a MAT PRINT
+ * statement.
+ */
+
+   void printIntegers(const int *values, int n);
+
+/*
+ * Method: write
+ * Usage: out.write(str);
+ * ----------------------
+ * Adds the string to the buffer without a trailing newline.
+ */
+
+   void write(const std::string & str);
+
+/*
+ * Method: flush
+ * Usage: out.flush();
+ * -------------------
+ * Writes any buffered text to the stream and flushes the stream.  If
+ * the buffer is empty, flush does nothing and is not counted.
+ */
+
+   void flush();
+
+/*
+ * Method: setStream
+ * Usage: out.setStream(stream);
+ * -----------------------------
+ * Flushes the buffer and directs later output to the specified stream.
+ */
+
+   void setStream(std::ostream & stream);
+
+/*
+ * Methods: setFlushInterval, getFlushInterval
+ * Usage: out.setFlushInterval(milliseconds);
+ *        int milliseconds = out.getFlushInterval();
+ * -------------------------------------------------
+ * Sets or returns the longest time, in milliseconds, that text may sit
+ * in the buffer.  The clock is consulted only when text is written, so
+ * output that precedes a long silent computation still waits for the
+ * next write or flush.  An interval of 0, which is the default, turns
+ * the check off.
+ */
+
+   void setFlushInterval(int milliseconds);
+   int getFlushInterval() const;
+
+/*
+ * Methods: getBytesWritten, getFlushCount
+ * Usage: long bytes = out.getBytesWritten();
+ *        long flushes = out.getFlushCount();
+ * -----------------------------------------
+ * Return the number of bytes passed to the stream and the number of
+ * times the stream has been flushed since the buffer was created or
+ * the statistics were last reset.
+ */
+
+   long getBytesWritten() const;
+   long getFlushCount() const;
+
+/*
+ * Method: resetStatistics
+ * Usage: out.resetStatistics();
+ * -----------------------------
+ * Sets the byte and flush counts back to zero.
+ */
+
+   void resetStatistics();
+
+private:
+
+/* Constants */
+
+   static const int MAX_INTEGER_LENGTH = 21;
+   static const int MAX_REAL_LENGTH = 32;
+
+/* Instance variables */
+
+   std::ostream *stream;
+   std::vector<char> buffer;
+   int count;
+   int flushInterval;
+   long bytesWritten;
+   long flushCount;
+   std::chrono::steady_clock::time_point lastFlush;
+
+/* Private methods */
+
+   void checkInterval();
+   void appendInteger(long long value, char terminator);
+
+/* Forbid copying, since the buffer refers to a shared stream */
+
+   OutputBuffer(const OutputBuffer &);
+   OutputBuffer & operator=(const OutputBuffer &);
+
+};
+
+#endif
@@ -6,11 +6,12 @@
 
 #include <iostream>
 #include <string>
+#include "arena.h"
 #include "error.h"
 #include "exp.h"
+#include "lexer.h"
 #include "parser.h"
 #include "strlib.h"
-#include "tokenscanner.h"
 using namespace std;
 
 /*
@@ -19,10 +20,10 @@ using namespace std;
  * This code just reads an expression and then checks for extra tokens.
  */
 
-Expression *parseExp(TokenScanner & scanner) {
-   Expression *exp = readE(scanner);
-   if (scanner.hasMoreTokens()) {
-      error("parseExp: Found extra token: " + scanner.nextToken());
+Expression *parseExp(Lexer & lexer, Arena & arena) {
+   Expression *exp = readE(lexer, arena);
+   if (lexer.hasMoreTokens()) {
+      error("parseExp: Found extra token: " + lexer.getText(lexer.nextToken()));
    }
    return exp;
 }
@@ -32,79 +33,132 @@ Expression *parseExp(TokenScanner & scanner) {
  * Implementation notes: parseStatement
  * ------------------------------
  * This code reads a statement and checks if the first tokens is one of the
- * seven legal statement forms. When a case match is made the constructor
- * for that sublass is called which reads the rest of the tokens in the line
- * and assemble them into a object of the appropriate subclass
+ * fourteen legal statement forms, which takes a single keyword lookup. When a
+ * case match is made the constructor for that sublass is called which reads
+ * the rest of the tokens in the line and assemble them into a object of the
+ * appropriate subclass
  */
 
-Statement *parseStatement(TokenScanner & scanner) {
+Statement *parseStatement(Lexer & lexer, Arena & arena) {
     Statement *stmt = NULL;
-    string nextToken = toUpperCase(scanner.nextToken());
-    if (nextToken  == "REM") {
-        stmt = new RemStmt(scanner);
-    } else if (nextToken  == "LET") {
-        stmt = new LetStmt(scanner);
-    } else if (nextToken  == "PRINT") {
-        stmt = new PrintStmt(scanner);
-    } else if (nextToken  == "INPUT") {
-        stmt = new InputStmt(scanner);
-    } else if (nextToken  == "GOTO") {
-        stmt = new GotoStmt(scanner);
-    } else if (nextToken  == "IF") {
-        stmt = new IfStmt(scanner);
-    } else if (nextToken  == "END") {
-        stmt = new EndStmt(scanner);
-    } else {
-        error(nextToken + " is not a valid command type");
+    Token token = lexer.nextToken();
+    switch (lexer.getKeyword(token)) {
+     case KEYWORD_REM: stmt = arena.make<RemStmt>(lexer, arena); break;
+     case KEYWORD_LET: stmt = arena.make<LetStmt>(lexer, arena); break;
+     case KEYWORD_PRINT: stmt = arena.make<PrintStmt>(lexer, arena); break;
+     case KEYWORD_INPUT: stmt = arena.make<InputStmt>(lexer, arena); break;
+     case KEYWORD_GOTO: stmt = arena.make<GotoStmt>(lexer, arena); break;
+     case KEYWORD_IF: stmt = arena.make<IfStmt>(lexer, arena); break;
+     case KEYWORD_END: stmt = arena.make<EndStmt>(lexer, arena); break;
+     case KEYWORD_FOR: stmt = arena.make<ForStmt>(lexer, arena); break;
+     case KEYWORD_NEXT: stmt = arena.make<NextStmt>(lexer, arena); break;
+     case KEYWORD_GOSUB: stmt = arena.make<GosubStmt>(lexer, arena); break;
+     case KEYWORD_RETURN: stmt = arena.make<ReturnStmt>(lexer, arena); break;
+     case KEYWORD_DIM: stmt = arena.make<DimStmt>(lexer, arena); break;
+     case KEYWORD_MAT: stmt = arena.make<MatStmt>(lexer, arena); break;
+     case KEYWORD_DATA: stmt = arena.make<DataStmt>(lexer, arena); break;
+     default:
+        error(toUpperCase(lexer.getText(token)) + " is not a valid command type");
     }
     return stmt;
 }
 
 /*
  * Implementation notes: readE
- * Usage: exp = readE(scanner, prec);
- * ----------------------------------
+ * Usage: exp = readE(lexer, arena, prec);
+ * ---------------------------------------
  * This version of readE uses precedence to resolve the ambiguity in
  * the grammar.  At each recursive level, the parser reads operators and
  * subexpressions until it finds an operator whose precedence is greater
  * than the prevailing one.  When a higher-precedence operator is found,
  * readE calls itself recursively to read in that subexpression as a unit.
+ * Each operator node is built by makeCompound, which gives it the kind
+ * of its operands.
  */
 
-Expression *readE(TokenScanner & scanner, int prec) {
-   Expression *exp = readT(scanner);
-   string token;
+Expression *readE(Lexer & lexer, Arena & arena, int prec) {
+   Expression *exp = readT(lexer, arena);
    while (true) {
-      token = scanner.nextToken();
+      Token token = lexer.nextToken();
       int newPrec = precedence(token);
       if (newPrec <= prec) break;
-      Expression *rhs = readE(scanner, newPrec);
-      exp = new CompoundExp(token, exp, rhs);
+      Expression *rhs = readE(lexer, arena, newPrec);
+      exp = makeCompound(charToOperator(token.value), exp, rhs, arena);
    }
-   scanner.saveToken(token);
+   lexer.unreadToken();
    return exp;
 }
 
 /*
  * Implementation notes: readT
  * ---------------------------
- * This function scans a term, which is either an integer, an identifier,
- * or a parenthesized subexpression.
+ * This function scans a term, which is either a number, an identifier,
+ * an array element, or a parenthesized subexpression.  A word followed
+ * by an opening parenthesis names an array.  A number is an int if it
+ * fits, a 64-bit integer if it is whole and fits in that, and a double
+ * otherwise.
  */
 
-Expression *readT(TokenScanner & scanner) {
-   string token = scanner.nextToken();
-   TokenType type = scanner.getTokenType(token);
-   if (type == WORD) return new IdentifierExp(token);
-   if (type == NUMBER) return new ConstantExp(stringToInteger(token));
-   if (token != "(") error("Illegal term in expression");
-   Expression *exp = readE(scanner);
-   if (scanner.nextToken() != ")") {
+Expression *readT(Lexer & lexer, Arena & arena) {
+   Token token = lexer.nextToken();
+   if (token.kind == TOKEN_WORD) {
+      string name = lexer.getText(token);
+      Token next = lexer.nextToken();
+      lexer.unreadToken();
+      if (next.kind == TOKEN_OPERATOR && next.value == '(') {
+         return readArray(name, lexer, arena);
+      }
+      return makeIdentifier(name, arena);
+   }
+   if (token.kind == TOKEN_NUMBER) {
+      if (token.isInteger) return arena.make<ConstantExp>(token.value);
+      if (token.isLong) return arena.make<ConstantExp>(lexer.getLong(token));
+      return arena.make<ConstantExp>(lexer.getReal(token));
+   }
+   if (token.kind != TOKEN_OPERATOR || token.value != '(') {
+      error("Illegal term in expression");
+   }
+   Expression *exp = readE(lexer, arena);
+   token = lexer.nextToken();
+   if (token.kind != TOKEN_OPERATOR || token.value != ')') {
       error("Unbalanced parentheses in expression");
    }
    return exp;
 }
 
+/*
+ * Implementation notes: readArray
+ * -------------------------------
+ * The subscripts are read with readE, which stops at the comma between
+ * them because a comma is not an operator.
+ */
+
+ArrayExp *readArray(const string & name, Lexer & lexer, Arena & arena) {
+   checkArrayName(name);
+   lexer.nextToken();
+   Expression *row = readE(lexer, arena);
+   Expression *column = NULL;
+   Token token = lexer.nextToken();
+   if (token.kind == TOKEN_OPERATOR && token.value == ',') {
+      column = readE(lexer, arena);
+      token = lexer.nextToken();
+   }
+   if (token.kind != TOKEN_OPERATOR || token.value != ')') {
+      error("Unbalanced parentheses in subscript of " + name);
+   }
+   return arena.make<ArrayExp>(name, row, column);
+}
+
+void checkArrayName(const string & name) {
+   if (getNameKind(name) != INT_VALUE) error("Illegal array name " + name);
+}
+
+void checkConstant(Expression *exp, ValueKind kind, const string & target) {
+   if (exp->getType() == CONSTANT && exp->getKind() > kind) {
+      error("Constant " + exp->toString() + " does not fit in " + target);
+   }
+}
+
 /*
  * Implementation notes: precedence
  * --------------------------------
@@ -112,9 +166,9 @@ Expression *readT(TokenScanner & scanner) {
  * and returns the appropriate precedence value.
  */
 
-int precedence(string token) {
-   //if (token == "=") return 1; // I'm still not clear about this!!!!
-   if (token == "+" || token == "-") return 1;
-   if (token == "*" || token == "/") return 2;
+int precedence(const Token & token) {
+   if (token.kind != TOKEN_OPERATOR) return 0;
+   if (token.value == '+' || token.value == '-') return 1;
+   if (token.value == '*' || token.value == '/') return 2;
    return 0;
 }
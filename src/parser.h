@@ -8,52 +8,88 @@
 #define _parser_h
 
 #include <string>
+#include "arena.h"
 #include "exp.h"
-#include "tokenscanner.h"
+#include "lexer.h"
 #include "statement.h"
 
 /*
  * Function: parseExp
- * Usage: Expression *exp = parseExp(scanner);
- * -------------------------------------------
- * Parses an expression by reading tokens from the scanner, which must
- * be provided by the client.  The scanner should be set to ignore
- * whitespace and to scan numbers.
+ * Usage: Expression *exp = parseExp(lexer, arena);
+ * ------------------------------------------------
+ * Parses an expression by reading tokens from the lexer, which must be
+ * provided by the client.  The nodes of the expression are created in
+ * the arena, which owns them.
  */
 
-Expression *parseExp(TokenScanner & scanner);
+Expression *parseExp(Lexer & lexer, Arena & arena);
 
 /*
  * Function: parseStatement
- * Usage: Statement *stmt = parseStatement(scanner);
- * ----------------------------------------------
- * Parses a statement by reading tokens from the scanner, which must be
- * provided by the client. The scanner should be set to ignore whitespaces
- * and to scan numbers.
+ * Usage: Statement *stmt = parseStatement(lexer, arena);
+ * ------------------------------------------------------
+ * Parses a statement by reading tokens from the lexer, which must be
+ * provided by the client.  The statement and its expressions are
+ * created in the arena, which owns them.  If the statement cannot be
+ * parsed, the nodes created so far stay in the arena until it is
+ * cleared.
  */
 
-Statement *parseStatement(TokenScanner & scanner);
+Statement *parseStatement(Lexer & lexer, Arena & arena);
 
 /*
  * Function: readE
- * Usage: Expression *exp = readE(scanner, prec);
- * ----------------------------------------------
- * Returns the next expression from the scanner involving only operators
+ * Usage: Expression *exp = readE(lexer, arena, prec);
+ * ---------------------------------------------------
+ * Returns the next expression from the lexer involving only operators
  * whose precedence is at least prec.  The prec argument is optional and
  * defaults to 0, which means that the function reads the entire expression.
  */
 
-Expression *readE(TokenScanner & scanner, int prec = 0);
+Expression *readE(Lexer & lexer, Arena & arena, int prec = 0);
 
 /*
  * Function: readT
- * Usage: Expression *exp = readT(scanner);
- * ----------------------------------------
+ * Usage: Expression *exp = readT(lexer, arena);
+ * ---------------------------------------------
  * Returns the next individual term, which is either a constant, an
- * identifier, or a parenthesized subexpression.
+ * identifier, an array element, or a parenthesized subexpression.
+ */
+
+Expression *readT(Lexer & lexer, Arena & arena);
+
+/*
+ * Function: readArray
+ * Usage: ArrayExp *exp = readArray(name, lexer, arena);
+ * -----------------------------------------------------
+ * Reads the parenthesized list of one or two subscripts that follows
+ * the name of an array and returns the element they select.
+ */
+
+ArrayExp *readArray(const std::string & name, Lexer & lexer, Arena & arena);
+
+/*
+ * Function: checkArrayName
+ * Usage: checkArrayName(name);
+ * ----------------------------
+ * Raises an error if name cannot name an array.  Arrays hold ints, so
+ * their names may not end in a type suffix.
+ */
+
+void checkArrayName(const std::string & name);
+
+/*
+ * Function: checkConstant
+ * Usage: checkConstant(exp, kind, target);
+ * ----------------------------------------
+ * Raises an error if exp is a constant that a variable of the given
+ * kind cannot hold, such as a fraction or a number too large for 32
+ * bits assigned to an int variable.  Any other expression is narrowed
+ * to the kind of its target when it is stored, but narrowing a
+ * constant would silently change the number the program spells out.
  */
 
-Expression *readT(TokenScanner & scanner);
+void checkConstant(Expression *exp, ValueKind kind, const std::string & target);
 
 /*
  * Function: precedence
@@ -67,7 +103,7 @@ Expression *readT(TokenScanner & scanner);
 
 
 
-int precedence(std::string token);
+int precedence(const Token & token);
 
 
 
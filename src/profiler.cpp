@@ -0,0 +1,108 @@
+/*
+ * File: profiler.cpp
+ * ------------------
+ * This file implements the Profiler class.
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "bytecode.h"
+#include "profiler.h"
+#include "program.h"
+using namespace std;
+
+Profiler::Profiler() {
+   current = -1;
+   last = 0;
+}
+
+/*
+ * Implementation notes: start
+ * ---------------------------
+ * The first instruction of each line is the one whose line number
+ * differs from that of the instruction before it.  A jump to a line
+ * always lands on that instruction, so testing the address alone is
+ * enough to recognize the start of every execution of a line, even
+ * when a line jumps back to itself.
+ */
+
+void Profiler::start(const Bytecode & code) {
+   int n = code.size();
+   lineIndex.assign(n, -1);
+   lineNumbers.clear();
+   int previous = -1;
+   for (int pc = 0; pc < n; pc++) {
+      int lineNumber = code.getLineNumber(pc);
+      if (lineNumber != previous && lineNumber != -1) {
+         lineIndex[pc] = lineNumbers.size();
+         lineNumbers.push_back(lineNumber);
+      }
+      previous = lineNumber;
+   }
+   counts.assign(lineNumbers.size(), 0);
+   times.assign(lineNumbers.size(), 0);
+   current = -1;
+   last = readClock();
+}
+
+void Profiler::stop() {
+   if (current >= 0) times[current] += readClock() - last;
+   current = -1;
+}
+
+long long Profiler::getTotalCount() const {
+   long long total = 0;
+   for (size_t i = 0; i < counts.size(); i++) {
+      total += counts[i];
+   }
+   return total;
+}
+
+const char *Profiler::getTimeUnit() {
+#ifdef PROFILER_RDTSC
+   return "cycles";
+#else
+   return "ns";
+#endif
+}
+
+/*
+ * Implementation notes: report
+ * ----------------------------
+ * The rows are sorted by time, with ties broken by line number so that
+ * the report is stable from one run to the next.  The formatting state
+ * of the stream is restored afterwards.
+ */
+
+void Profiler::report(Program & program, ostream & os) {
+   vector<int> order;
+   unsigned long long total = 0;
+   for (size_t i = 0; i < lineNumbers.size(); i++) {
+      if (counts[i] > 0) order.push_back(i);
+      total += times[i];
+   }
+   sort(order.begin(), order.end(), [this](int a, int b) {
+      if (times[a] != times[b]) return times[a] > times[b];
+      return lineNumbers[a] < lineNumbers[b];
+   });
+   string unit = getTimeUnit();
+   ios::fmtflags flags = os.flags();
+   streamsize precision = os.precision();
+   os << setw(8) << "LINE" << setw(14) << "COUNT" << setw(16) << unit
+      << setw(8) << "%" << "  SOURCE" << endl;
+   for (size_t i = 0; i < order.size(); i++) {
+      int index = order[i];
+      double percent = (total == 0) ? 0 : 100.0 * times[index] / total;
+      os << setw(8) << lineNumbers[index]
+         << setw(14) << counts[index]
+         << setw(16) << times[index]
+         << setw(8) << fixed << setprecision(1) << percent
+         << "  " << program.getSourceLine(lineNumbers[index]) << endl;
+   }
+   os << "Total: " << total << " " << unit << endl;
+   os.flags(flags);
+   os.precision(precision);
+}
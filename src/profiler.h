@@ -0,0 +1,146 @@
+/*
+ * File: profiler.h
+ * ----------------
+ * This interface exports the Profiler class, which measures how often
+ * each line of a BASIC program runs and how much time it takes.
+ */
+
+#ifndef _profiler_h
+#define _profiler_h
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define PROFILER_RDTSC
+#  include <x86intrin.h>
+#endif
+
+class Bytecode;
+class Program;
+
+/*
+ * Class: Profiler
+ * ---------------
+ * This class collects a per-line profile of a program running on the
+ * virtual machine.  The machine reports the address of every
+ * instruction it executes; when the address is the first instruction
+ * of a line, the profiler counts one execution of that line and charges
+ * the time since the previous line began to the previous line.  Time is
+ * measured in processor cycles with rdtsc where it is available and in
+ * nanoseconds from the steady clock elsewhere.
+ *
+ * Lines that compile to no instructions, such as REM, never appear in
+ * the profile.
+ */
+
+class Profiler {
+
+public:
+
+/*
+ * Constructor: Profiler
+ * Usage: Profiler profiler;
+ * -------------------------
+ * Creates a profiler with no recorded data.
+ */
+
+   Profiler();
+
+/*
+ * Methods: start, stop
+ * Usage: profiler.start(code);
+ *        profiler.stop();
+ * ---------------------------
+ * Prepare the profiler for a run of the specified code, discarding
+ * any earlier data, and finish the run by charging the time spent in
+ * the last line.
+ */
+
+   void start(const Bytecode & code);
+   void stop();
+
+/*
+ * Method: enter
+ * Usage: profiler.enter(pc);
+ * --------------------------
+ * Records that the instruction at address pc is about to execute.
+ */
+
+   void enter(int pc);
+
+/*
+ * Method: report
+ * Usage: profiler.report(program, os);
+ * ------------------------------------
+ * Writes the profile to the output stream, one line of the program per
+ * row, with the lines that took the most time first.  Each row shows
+ * the line number, the execution count, the total time, its share of
+ * the run, and the source text from the program.
+ */
+
+   void report(Program & program, std::ostream & os);
+
+/*
+ * Method: getTotalCount
+ * Usage: long long n = profiler.getTotalCount();
+ * ----------------------------------------------
+ * Returns the number of line executions recorded in the last run,
+ * which is the number of statements the program executed.
+ */
+
+   long long getTotalCount() const;
+
+/*
+ * Method: getTimeUnit
+ * Usage: string unit = Profiler::getTimeUnit();
+ * ---------------------------------------------
+ * Returns the unit of the times in the report, either "cycles" or
+ * "ns".
+ */
+
+   static const char *getTimeUnit();
+
+private:
+
+   std::vector<int> lineIndex;          /* Index of the line begun at each pc */
+   std::vector<int> lineNumbers;        /* Line number for each index         */
+   std::vector<long long> counts;       /* Executions of each line            */
+   std::vector<unsigned long long> times;  /* Time charged to each line       */
+   int current;                         /* Index of the line now running      */
+   unsigned long long last;             /* Clock when that line began         */
+
+   static unsigned long long readClock();
+
+};
+
+/*
+ * Implementation notes: enter, readClock
+ * --------------------------------------
+ * These methods are defined inline because the virtual machine calls
+ * enter before every instruction of a profiled run.  For the
+ * instructions that do not begin a line, enter costs a single load
+ * and test.
+ */
+
+inline void Profiler::enter(int pc) {
+   int index = lineIndex[pc];
+   if (index < 0) return;
+   unsigned long long now = readClock();
+   if (current >= 0) times[current] += now - last;
+   current = index;
+   counts[index]++;
+   last = now;
+}
+
+inline unsigned long long Profiler::readClock() {
+#ifdef PROFILER_RDTSC
+   return __rdtsc();
+#else
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+#endif
@@ -1,20 +1,51 @@
-
 /*
  * File: program.cpp
  * -----------------
- * This file is a stub implementation of the program.h interface
+ * This file implements the program.h interface using the blocked
+ * sorted array described in the private section of program.h.
  *
  */
 
+#include <algorithm>
+#include <climits>
+#include <iterator>
 #include <string>
+#include <unordered_map>
+#include <vector>
+#include "exp.h"
 #include "program.h"
 #include "statement.h"
-#include "hashmap.h"
 #include "error.h"
+#include "strlib.h"
 using namespace std;
 
-Program::Program() {
+/* Private types and function prototypes */
+
+struct Range {
+    long long low;
+    long long high;
+};
+
+struct LoopRange {
+    string var;
+    Range range;
+    bool known;
+};
+
+static void collectExpressions(Statement *stmt, vector<Expression *> & exps);
+static void collectElements(Expression *exp, vector<ArrayExp *> & elements);
+static void collectAssignments(Expression *exp, vector<string> & written);
+static bool findRange(Expression *exp, const vector<LoopRange> & loops, Range & range);
+static bool findLoopRange(ForStmt *forStmt, const vector<LoopRange> & loops, Range & range);
+static bool isInRange(const Range & range, int count);
 
+Program::Program() {
+    lastBlock = 0;
+    lastIndex = 0;
+    loopsChanged = false;
+    arraysChanged = false;
+    arrayLines = 0;
+    dataLines = 0;
 }
 
 Program::~Program() {
@@ -22,64 +53,805 @@ Program::~Program() {
 }
 
 void Program::clear() {
-    basicMap.clear();
-    head = NULL;
-    tail = NULL;
+    blocks.clear();
+    blockLast.clear();
+    relinkLines.clear();
+    jumpSources.clear();
+    loopsChanged = false;
+    arraysChanged = false;
+    arrayLines = 0;
+    dataLines = 0;
 }
 
-void Program::addSourceLine(int lineNumber, string line) {
-    Cell *cp = new Cell;
-    cp->data.lineNumber = lineNumber;
-    cp->data.line = line;
-    insertCellToList(cp);
-    basicMap.put(lineNumber, cp);
+/*
+ * Implementation notes: addSourceLine
+ * -----------------------------------
+ * A new line goes into the block that should contain it, or into the
+ * last block if its number is larger than any in the program.  When a
+ * block grows past MAX_BLOCK_SIZE, its upper half moves into a new
+ * block inserted just after it.  Because programs are usually typed or
+ * loaded in ascending order, most insertions append to the last block.
+ */
 
+void Program::addSourceLine(int lineNumber, string line) {
+    lineChanged(lineNumber);
+    Line *lp = findLine(lineNumber);
+    if (lp != NULL) {
+        removeJumpSource(lineNumber, lp->parsedLine);
+        checkLoopChange(lp->parsedLine);
+        countArrayLine(lp->parsedLine, -1);
+        countDataLine(lp->parsedLine, -1);
+        lp->source = line;
+        lp->parsedLine = NULL;
+        lp->eliminated = 0;
+        lp->arena.clear();
+        lp->code.valid = false;
+        return;
+    }
+    Line entry;
+    entry.lineNumber = lineNumber;
+    entry.parsedLine = NULL;
+    entry.source = line;
+    entry.eliminated = 0;
+    entry.code.maxStack = 0;
+    entry.code.valid = false;
+    if (blocks.empty()) {
+        blocks.push_back(Block());
+        blockLast.push_back(lineNumber);
+    }
+    int b = findBlock(lineNumber);
+    if (b == (int) blocks.size()) b--;
+    Block & block = blocks[b];
+    block.insert(block.begin() + findIndex(block, lineNumber), std::move(entry));
+    blockLast[b] = block.back().lineNumber;
+    if ((int) block.size() > MAX_BLOCK_SIZE) {
+        Block upper(make_move_iterator(block.begin() + MAX_BLOCK_SIZE / 2),
+                    make_move_iterator(block.end()));
+        block.erase(block.begin() + MAX_BLOCK_SIZE / 2, block.end());
+        blockLast[b] = block.back().lineNumber;
+        blocks.insert(blocks.begin() + b + 1, Block());
+        blocks[b + 1].swap(upper);
+        blockLast.insert(blockLast.begin() + b + 1, blocks[b + 1].back().lineNumber);
+    }
 }
 
 void Program::removeSourceLine(int lineNumber) {
-    if(basicMap.containsKey(lineNumber)) {
-        removeCellFromList(lineNumber);
-        basicMap.remove(lineNumber);
+    int b = findBlock(lineNumber);
+    if (b == (int) blocks.size()) return;
+    Block & block = blocks[b];
+    int i = findIndex(block, lineNumber);
+    if (block[i].lineNumber != lineNumber) return;
+    removeJumpSource(lineNumber, block[i].parsedLine);
+    checkLoopChange(block[i].parsedLine);
+    countArrayLine(block[i].parsedLine, -1);
+    countDataLine(block[i].parsedLine, -1);
+    block.erase(block.begin() + i);
+    if (block.empty()) {
+        blocks.erase(blocks.begin() + b);
+        blockLast.erase(blockLast.begin() + b);
+    } else {
+        blockLast[b] = block.back().lineNumber;
     }
+    lineChanged(lineNumber);
 }
 
 string Program::getSourceLine(int lineNumber) {
-    if (basicMap.containsKey(lineNumber)) {
-        return basicMap.get(lineNumber)->data.line;
-    } else {
-        return "";
-    }
+    Line *lp = findLine(lineNumber);
+    return (lp == NULL) ? "" : lp->source;
 }
 
-void Program::setParsedStatement(int lineNumber, Statement *stmt) {
-    if(!basicMap.containsKey(lineNumber)) {
+void Program::setParsedStatement(int lineNumber, Statement *stmt, Arena & arena) {
+    Line *lp = findLine(lineNumber);
+    if (lp == NULL) {
         error("This line number does not exist");
     } else {
-        basicMap[lineNumber]->data.parsedLine = stmt;
+        removeJumpSource(lineNumber, lp->parsedLine);
+        checkLoopChange(lp->parsedLine);
+        countArrayLine(lp->parsedLine, -1);
+        countDataLine(lp->parsedLine, -1);
+        lp->arena = std::move(arena);
+        lp->parsedLine = stmt;
+        lp->code.valid = false;
+        addJumpSource(lineNumber, stmt);
+        checkLoopChange(stmt);
+        countArrayLine(stmt, 1);
+        countDataLine(stmt, 1);
+        lineChanged(lineNumber);
     }
 }
 
 Statement *Program::getParsedStatement(int lineNumber) {
-    if(!basicMap.containsKey(lineNumber)) {
-        return NULL;
-    } else {
-        return basicMap.get(lineNumber)->data.parsedLine;
+    Line *lp = findLine(lineNumber);
+    return (lp == NULL) ? NULL : lp->parsedLine;
+}
+
+void Program::setEliminatedNodes(int lineNumber, int count) {
+    Line *lp = findLine(lineNumber);
+    if (lp != NULL) lp->eliminated = count;
+}
+
+int Program::getEliminatedNodes() {
+    int total = 0;
+    for (size_t b = 0; b < blocks.size(); b++) {
+        for (size_t i = 0; i < blocks[b].size(); i++) {
+            total += blocks[b][i].eliminated;
+        }
     }
+    return total;
 }
 
 int Program::getFirstLineNumber() {
-   if (!basicMap.isEmpty()) {
-       return head->data.lineNumber;
-   } else {
-       return -1;
-   }
+    return blocks.empty() ? -1 : blocks[0][0].lineNumber;
 }
 
+/*
+ * Implementation notes: getNextLineNumber
+ * ---------------------------------------
+ * The position of the next line is remembered, so that a walk through
+ * the program that looks at each line before asking for the next one
+ * finds every line without searching.
+ */
+
 int Program::getNextLineNumber(int lineNumber) {
-    if(!basicMap.containsKey(lineNumber)) return -1;
-    if(basicMap.get(lineNumber)->nextlink == NULL) {
+    if (!findPosition(lineNumber)) return -1;
+    if (lastIndex + 1 < (int) blocks[lastBlock].size()) {
+        lastIndex++;
+    } else if (lastBlock + 1 < (int) blocks.size()) {
+        lastBlock++;
+        lastIndex = 0;
+    } else {
         return -1;
+    }
+    return blocks[lastBlock][lastIndex].lineNumber;
+}
+
+/*
+ * Implementation notes: link
+ * --------------------------
+ * Each line in relinkLines is linked again on its own, which costs a
+ * few binary searches, or about as much as walking one block.  When
+ * more lines have changed than there are blocks, as after loading a
+ * file, a single walk through the whole program is cheaper.  The list
+ * is emptied only once every link has been made, so a failed link
+ * leaves it in place and the next call tries again.  The same is true
+ * of loopsChanged and arraysChanged.
+ */
+
+void Program::link() {
+    if (!relinkLines.empty()) {
+        if (relinkLines.size() > blocks.size()) {
+            linkAll();
+        } else {
+            sort(relinkLines.begin(), relinkLines.end());
+            relinkLines.erase(unique(relinkLines.begin(), relinkLines.end()), relinkLines.end());
+            for (size_t i = 0; i < relinkLines.size(); i++) {
+                relinkLine(relinkLines[i]);
+            }
+        }
+        relinkLines.clear();
+    }
+    if (loopsChanged) {
+        linkLoops();
+        loopsChanged = false;
+    }
+    if (arraysChanged) {
+        if (arrayLines > 0) linkArrays();
+        arraysChanged = false;
+    }
+}
+
+void Program::linkAll() {
+    Statement *previous = NULL;
+    for (size_t b = 0; b < blocks.size(); b++) {
+        Block & block = blocks[b];
+        for (size_t i = 0; i < block.size(); i++) {
+            Statement *stmt = block[i].parsedLine;
+            if (stmt == NULL) continue;
+            if (previous != NULL) previous->setNext(stmt);
+            previous = stmt;
+            linkJump(block[i]);
+        }
+    }
+    if (previous != NULL) previous->setNext(NULL);
+}
+
+void Program::relinkLine(int lineNumber) {
+    Statement *successor = findStatementAfter(lineNumber);
+    Line *lp = findLine(lineNumber);
+    if (lp != NULL && lp->parsedLine != NULL) {
+        lp->parsedLine->setNext(successor);
+        linkJump(*lp);
+        successor = lp->parsedLine;
+    }
+    Line *previous = findStatementBefore(lineNumber);
+    if (previous != NULL) previous->parsedLine->setNext(successor);
+}
+
+void Program::linkJump(Line & line) {
+    Statement *stmt = line.parsedLine;
+    if (stmt->getType() == GOTO_STMT) {
+        GotoStmt *gotoStmt = (GotoStmt *) stmt;
+        gotoStmt->setTarget(getJumpTarget(gotoStmt->getLineNumber(), line.lineNumber));
+    } else if (stmt->getType() == IF_STMT) {
+        IfStmt *ifStmt = (IfStmt *) stmt;
+        ifStmt->setTarget(getJumpTarget(ifStmt->getLineNumber(), line.lineNumber));
+    } else if (stmt->getType() == GOSUB_STMT) {
+        GosubStmt *gosub = (GosubStmt *) stmt;
+        gosub->setTarget(getJumpTarget(gosub->getLineNumber(), line.lineNumber));
+    }
+}
+
+/*
+ * Implementation notes: linkLoops
+ * -------------------------------
+ * The loops are paired with a stack of open FOR lines, in the way that
+ * brackets are matched.  The code compiled for a FOR or NEXT names the
+ * line of its partner, so the code of every loop line is marked out of
+ * date; there are few such lines, and they are cheap to compile again.
+ */
+
+void Program::linkLoops() {
+    vector<Line *> open;
+    for (size_t b = 0; b < blocks.size(); b++) {
+        Block & block = blocks[b];
+        for (size_t i = 0; i < block.size(); i++) {
+            Statement *stmt = block[i].parsedLine;
+            if (stmt == NULL) continue;
+            if (stmt->getType() == FOR_STMT) {
+                string var = ((ForStmt *) stmt)->getVar();
+                for (size_t k = 0; k < open.size(); k++) {
+                    if (((ForStmt *) open[k]->parsedLine)->getVar() == var) {
+                        error("FOR " + var + " on line " + integerToString(block[i].lineNumber)
+                              + " is inside a loop on the same variable (line "
+                              + integerToString(open[k]->lineNumber) + ")");
+                    }
+                }
+                block[i].code.valid = false;
+                open.push_back(&block[i]);
+            } else if (stmt->getType() == NEXT_STMT) {
+                NextStmt *next = (NextStmt *) stmt;
+                if (open.empty()) {
+                    error("NEXT without FOR on line " + integerToString(block[i].lineNumber));
+                }
+                Line *start = open.back();
+                ForStmt *forStmt = (ForStmt *) start->parsedLine;
+                if (next->getVar() != forStmt->getVar()) {
+                    error("NEXT " + next->getVar() + " on line " + integerToString(block[i].lineNumber)
+                          + " does not match FOR " + forStmt->getVar() + " on line "
+                          + integerToString(start->lineNumber));
+                }
+                forStmt->setLoopEnd(next, block[i].lineNumber);
+                next->setLoopStart(forStmt, start->lineNumber);
+                block[i].code.valid = false;
+                open.pop_back();
+            }
+        }
+    }
+    if (!open.empty()) {
+        error("FOR without NEXT on line " + integerToString(open.back()->lineNumber));
+    }
+}
+
+void Program::checkLoopChange(Statement *stmt) {
+    if (stmt == NULL) return;
+    if (stmt->getType() == FOR_STMT || stmt->getType() == NEXT_STMT) loopsChanged = true;
+}
+
+/*
+ * Implementation notes: linkArrays
+ * --------------------------------
+ * A subscript needs no check if the array has certainly been
+ * dimensioned when the element is used and the value of the subscript
+ * is certainly in range.  The first condition holds for an array whose
+ * only DIM lies in the straight-line prefix of the program, the lines
+ * before the first statement other than REM, LET, PRINT, INPUT, DIM,
+ * MAT and DATA, provided the element is on a later line: control cannot
+ * leave the prefix except by running all of it, and running the DIM
+ * again does not change the size of the array.
+ *
+ * For the second condition the range of each subscript is computed
+ * from the ranges of the constants and loop counters in it.  While the
+ * body of a FOR loop runs, its counter lies between the start and the
+ * limit, in the order given by the sign of the step, provided that
+ * the body is entered only through the FOR and nothing in the body
+ * changes the counter.  Statements outside the body may assign the
+ * counter freely, since control that leaves the body can come back
+ * only through the FOR.  The first walk checks those conditions: a
+ * loop is rejected if a line in its body is the target of a jump from
+ * outside the loop, is a GOSUB, whose RETURN could come back after the
+ * counter has changed, or assigns the counter, whether by LET, INPUT,
+ * an inner FOR or the = operator inside an expression.  The second
+ * walk computes the ranges and marks each element, invalidating the
+ * code of a line only if the marking of one of its elements changes.
+ */
+
+void Program::linkArrays() {
+    unordered_map<string, Line *> dims;
+    unordered_map<string, bool> dimsInPrefix;
+    unordered_map<Statement *, bool> safeLoops;
+    vector<pair<Line *, bool> > open;
+    vector<Expression *> exps;
+    vector<string> written;
+    bool inPrefix = true;
+    for (size_t b = 0; b < blocks.size(); b++) {
+        Block & block = blocks[b];
+        for (size_t i = 0; i < block.size(); i++) {
+            Statement *stmt = block[i].parsedLine;
+            if (stmt == NULL) continue;
+            int lineNumber = block[i].lineNumber;
+            StatementType type = stmt->getType();
+            if (type != REM_STMT && type != LET_STMT && type != PRINT_STMT
+                    && type != INPUT_STMT && type != DIM_STMT && type != MAT_STMT
+                    && type != DATA_STMT) {
+                inPrefix = false;
+            }
+            if (type == DIM_STMT) {
+                string var = ((DimStmt *) stmt)->getVar();
+                if (dims.count(var) != 0) {
+                    error("Array " + var + " is dimensioned on line "
+                          + integerToString(dims[var]->lineNumber) + " and again on line "
+                          + integerToString(lineNumber));
+                }
+                dims[var] = &block[i];
+                dimsInPrefix[var] = inPrefix;
+            }
+            written.clear();
+            if (type == LET_STMT && ((LetStmt *) stmt)->getElement() == NULL) {
+                written.push_back(((LetStmt *) stmt)->getVar());
+            } else if (type == INPUT_STMT) {
+                written.push_back(((InputStmt *) stmt)->getVar());
+            } else if (type == FOR_STMT) {
+                written.push_back(((ForStmt *) stmt)->getVar());
+            }
+            exps.clear();
+            collectExpressions(stmt, exps);
+            for (size_t k = 0; k < exps.size(); k++) {
+                collectAssignments(exps[k], written);
+            }
+            unordered_map<int, vector<int> >::const_iterator it = jumpSources.find(lineNumber);
+            for (size_t k = 0; k < open.size(); k++) {
+                ForStmt *forStmt = (ForStmt *) open[k].first->parsedLine;
+                int first = open[k].first->lineNumber;
+                int last = forStmt->getLoopEndLine();
+                if (type == GOSUB_STMT) open[k].second = false;
+                if (find(written.begin(), written.end(), forStmt->getVar()) != written.end()) {
+                    open[k].second = false;
+                }
+                if (it == jumpSources.end()) continue;
+                for (size_t s = 0; s < it->second.size(); s++) {
+                    if (it->second[s] < first || it->second[s] > last) open[k].second = false;
+                }
+            }
+            if (type == FOR_STMT) {
+                open.push_back(make_pair(&block[i], true));
+            } else if (type == NEXT_STMT) {
+                safeLoops[open.back().first->parsedLine] = open.back().second;
+                open.pop_back();
+            }
+        }
+    }
+    vector<LoopRange> loops;
+    vector<ArrayExp *> elements;
+    for (size_t b = 0; b < blocks.size(); b++) {
+        Block & block = blocks[b];
+        for (size_t i = 0; i < block.size(); i++) {
+            Statement *stmt = block[i].parsedLine;
+            if (stmt == NULL) continue;
+            int lineNumber = block[i].lineNumber;
+            exps.clear();
+            collectExpressions(stmt, exps);
+            elements.clear();
+            for (size_t k = 0; k < exps.size(); k++) {
+                collectElements(exps[k], elements);
+            }
+            for (size_t k = 0; k < elements.size(); k++) {
+                ArrayExp *element = elements[k];
+                string var = element->getName();
+                bool checked = true;
+                int columns = 0;
+                unordered_map<string, Line *>::const_iterator dp = dims.find(var);
+                if (dp != dims.end()) {
+                    DimStmt *dim = (DimStmt *) dp->second->parsedLine;
+                    if ((element->getColumn() != NULL) != (dim->getColumns() != 0)) {
+                        error("Wrong number of subscripts for " + var + " on line "
+                              + integerToString(lineNumber));
+                    }
+                    Range row, column;
+                    if (dimsInPrefix[var] && dp->second->lineNumber < lineNumber
+                            && findRange(element->getRow(), loops, row)
+                            && isInRange(row, dim->getRows())) {
+                        if (element->getColumn() == NULL) {
+                            checked = false;
+                        } else if (findRange(element->getColumn(), loops, column)
+                                   && isInRange(column, dim->getColumns())) {
+                            checked = false;
+                            columns = dim->getColumns();
+                        }
+                    }
+                }
+                if (element->isChecked() != checked || element->getColumns() != columns) {
+                    element->setChecked(checked, columns);
+                    block[i].code.valid = false;
+                }
+            }
+            if (stmt->getType() == FOR_STMT) {
+                ForStmt *forStmt = (ForStmt *) stmt;
+                LoopRange loop;
+                loop.var = forStmt->getVar();
+                loop.known = safeLoops[forStmt] && findLoopRange(forStmt, loops, loop.range);
+                loops.push_back(loop);
+            } else if (stmt->getType() == NEXT_STMT) {
+                loops.pop_back();
+            }
+        }
+    }
+}
+
+/*
+ * Implementation notes: countArrayLine
+ * ------------------------------------
+ * The walk over the expressions of a statement is cheap, and happens
+ * only when a line is added, replaced or removed.
+ */
+
+void Program::countArrayLine(Statement *stmt, int delta) {
+    if (stmt == NULL) return;
+    vector<Expression *> exps;
+    vector<ArrayExp *> elements;
+    collectExpressions(stmt, exps);
+    for (size_t k = 0; k < exps.size(); k++) {
+        collectElements(exps[k], elements);
+    }
+    if (stmt->getType() == DIM_STMT || !elements.empty()) arrayLines += delta;
+}
+
+void Program::countDataLine(Statement *stmt, int delta) {
+    if (stmt == NULL) return;
+    if (stmt->getType() == DATA_STMT
+            || (stmt->getType() == MAT_STMT && ((MatStmt *) stmt)->getOperation() == MAT_READ)) {
+        dataLines += delta;
+    }
+}
+
+/*
+ * Function: collectExpressions
+ * Usage: collectExpressions(stmt, exps);
+ * --------------------------------------
+ * Appends the expressions of the statement to exps, counting the
+ * element assigned by a LET as one of them.
+ */
+
+static void collectExpressions(Statement *stmt, vector<Expression *> & exps) {
+    switch (stmt->getType()) {
+     case LET_STMT: {
+        LetStmt *let = (LetStmt *) stmt;
+        if (let->getElement() != NULL) exps.push_back(let->getElement());
+        exps.push_back(let->getExp());
+        break;
+     }
+     case PRINT_STMT:
+        exps.push_back(((PrintStmt *) stmt)->getExp());
+        break;
+     case IF_STMT:
+        exps.push_back(((IfStmt *) stmt)->getLHS());
+        exps.push_back(((IfStmt *) stmt)->getRHS());
+        break;
+     case FOR_STMT:
+        exps.push_back(((ForStmt *) stmt)->getStart());
+        exps.push_back(((ForStmt *) stmt)->getLimit());
+        exps.push_back(((ForStmt *) stmt)->getStep());
+        break;
+     case MAT_STMT:
+        if (((MatStmt *) stmt)->getScalar() != NULL) exps.push_back(((MatStmt *) stmt)->getScalar());
+        break;
+     default:
+        break;
+    }
+}
+
+/*
+ * Functions: collectElements, collectAssignments
+ * Usage: collectElements(exp, elements);
+ *        collectAssignments(exp, written);
+ * ----------------------------------------
+ * These functions walk an expression, including the subscripts of its
+ * elements.  The first appends every array element to elements, and
+ * the second appends every variable assigned by the = operator to
+ * written.
+ */
+
+static void collectElements(Expression *exp, vector<ArrayExp *> & elements) {
+    if (exp->getType() == COMPOUND) {
+        collectElements(((CompoundExp *) exp)->getLHS(), elements);
+        collectElements(((CompoundExp *) exp)->getRHS(), elements);
+    } else if (exp->getType() == ARRAY) {
+        ArrayExp *element = (ArrayExp *) exp;
+        elements.push_back(element);
+        collectElements(element->getRow(), elements);
+        if (element->getColumn() != NULL) collectElements(element->getColumn(), elements);
+    }
+}
+
+static void collectAssignments(Expression *exp, vector<string> & written) {
+    if (exp->getType() == COMPOUND) {
+        CompoundExp *cexp = (CompoundExp *) exp;
+        if (cexp->getOperator() == ASSIGN_OP && cexp->getLHS()->getType() == IDENTIFIER) {
+            written.push_back(((IdentifierExp *) cexp->getLHS())->getName());
+        }
+        collectAssignments(cexp->getLHS(), written);
+        collectAssignments(cexp->getRHS(), written);
+    } else if (exp->getType() == ARRAY) {
+        ArrayExp *element = (ArrayExp *) exp;
+        collectAssignments(element->getRow(), written);
+        if (element->getColumn() != NULL) collectAssignments(element->getColumn(), written);
+    }
+}
+
+/*
+ * Function: findRange
+ * Usage: if (findRange(exp, loops, range)) . . .
+ * ----------------------------------------------
+ * Stores in range the smallest and largest values that exp can take
+ * inside the loops, innermost last, and returns true, or returns false
+ * if the range is unknown.  A variable has a known range only if it is
+ * the counter of one of the loops.  The arithmetic is done in 64 bits,
+ * and a range that leaves the integers is unknown, since the values
+ * would wrap when the program runs.  So is the range of anything that
+ * is not computed in ints.
+ */
+
+static bool findRange(Expression *exp, const vector<LoopRange> & loops, Range & range) {
+    if (exp->getKind() != INT_VALUE) return false;
+    switch (exp->getType()) {
+     case CONSTANT:
+        range.low = range.high = ((ConstantExp *) exp)->getValue();
+        return true;
+     case IDENTIFIER: {
+        string var = ((IdentifierExp *) exp)->getName();
+        for (int k = (int) loops.size() - 1; k >= 0; k--) {
+            if (loops[k].var == var) {
+                range = loops[k].range;
+                return loops[k].known;
+            }
+        }
+        return false;
+     }
+     case COMPOUND: {
+        CompoundExp *cexp = (CompoundExp *) exp;
+        Range lhs, rhs;
+        if (!findRange(cexp->getLHS(), loops, lhs) || !findRange(cexp->getRHS(), loops, rhs)) {
+            return false;
+        }
+        switch (cexp->getOperator()) {
+         case ADD_OP:
+            range.low = lhs.low + rhs.low;
+            range.high = lhs.high + rhs.high;
+            break;
+         case SUB_OP:
+            range.low = lhs.low - rhs.high;
+            range.high = lhs.high - rhs.low;
+            break;
+         case MUL_OP: {
+            long long products[] = { lhs.low * rhs.low, lhs.low * rhs.high,
+                                     lhs.high * rhs.low, lhs.high * rhs.high };
+            range.low = *min_element(products, products + 4);
+            range.high = *max_element(products, products + 4);
+            break;
+         }
+         case DIV_OP:
+            if (rhs.low != rhs.high || rhs.low <= 0) return false;
+            range.low = lhs.low / rhs.low;
+            range.high = lhs.high / rhs.low;
+            break;
+         default:
+            return false;
+        }
+        return range.low >= INT_MIN && range.high <= INT_MAX;
+     }
+     default:
+        return false;
+    }
+}
+
+/*
+ * Function: findLoopRange
+ * Usage: if (findLoopRange(forStmt, loops, range)) . . .
+ * ------------------------------------------------------
+ * Stores in range the values that the counter of the loop can take
+ * while its body runs, given the loops that enclose it.  A step that
+ * is never negative counts up from the start to at most the limit, and
+ * one that is always negative counts down; if the sign of the step is
+ * unknown, either may happen.
+ */
+
+static bool findLoopRange(ForStmt *forStmt, const vector<LoopRange> & loops, Range & range) {
+    Range start, limit, step;
+    if (!findRange(forStmt->getStart(), loops, start)
+            || !findRange(forStmt->getLimit(), loops, limit)) {
+        return false;
+    }
+    bool knownStep = findRange(forStmt->getStep(), loops, step);
+    if (knownStep && step.low >= 0) {
+        range.low = start.low;
+        range.high = limit.high;
+    } else if (knownStep && step.high < 0) {
+        range.low = limit.low;
+        range.high = start.high;
     } else {
-        return basicMap.get(lineNumber)->nextlink->data.lineNumber;
+        range.low = min(start.low, limit.low);
+        range.high = max(start.high, limit.high);
+    }
+    return true;
+}
+
+static bool isInRange(const Range & range, int count) {
+    return range.low >= 0 && range.high < count;
+}
+
+Statement *Program::getFirstStatement() {
+    link();
+    for (size_t b = 0; b < blocks.size(); b++) {
+        for (size_t i = 0; i < blocks[b].size(); i++) {
+            if (blocks[b][i].parsedLine != NULL) return blocks[b][i].parsedLine;
+        }
+    }
+    return NULL;
+}
+
+LineCode *Program::getLineCode(int lineNumber) {
+    Line *lp = findLine(lineNumber);
+    return (lp == NULL) ? NULL : &lp->code;
+}
+
+bool Program::getData(vector<int> & values) {
+    values.clear();
+    if (dataLines == 0) return false;
+    for (size_t b = 0; b < blocks.size(); b++) {
+        Block & block = blocks[b];
+        for (size_t i = 0; i < block.size(); i++) {
+            Statement *stmt = block[i].parsedLine;
+            if (stmt != NULL && stmt->getType() == DATA_STMT) {
+                const vector<int> & data = ((DataStmt *) stmt)->getValues();
+                values.insert(values.end(), data.begin(), data.end());
+            }
+        }
+    }
+    return true;
+}
+
+void Program::restoreData(EvalState & state) {
+    vector<int> values;
+    if (!getData(values)) return;
+    state.clearData();
+    for (size_t i = 0; i < values.size(); i++) {
+        state.addData(values[i]);
+    }
+}
+
+Statement *Program::getJumpTarget(int target, int source) {
+    Statement *stmt = getParsedStatement(target);
+    if (stmt == NULL) {
+        error("Line " + integerToString(target) + " does not exist (referenced on line "
+              + integerToString(source) + ")");
+    }
+    return stmt;
+}
+
+Statement *Program::findStatementAfter(int lineNumber) {
+    size_t b = findBlock(lineNumber);
+    size_t i = (b < blocks.size()) ? findIndex(blocks[b], lineNumber) : 0;
+    if (b < blocks.size() && blocks[b][i].lineNumber == lineNumber) i++;
+    for (; b < blocks.size(); b++, i = 0) {
+        for (; i < blocks[b].size(); i++) {
+            if (blocks[b][i].parsedLine != NULL) return blocks[b][i].parsedLine;
+        }
+    }
+    return NULL;
+}
+
+Program::Line *Program::findStatementBefore(int lineNumber) {
+    int b = findBlock(lineNumber);
+    int i = (b < (int) blocks.size()) ? findIndex(blocks[b], lineNumber) : 0;
+    while (true) {
+        while (i > 0) {
+            i--;
+            if (blocks[b][i].parsedLine != NULL) return &blocks[b][i];
+        }
+        if (b == 0) return NULL;
+        b--;
+        i = blocks[b].size();
+    }
+}
+
+/*
+ * Implementation notes: lineChanged
+ * ---------------------------------
+ * The jumps to the line are copied into relinkLines now, rather than
+ * looked up when the program is linked, because the statement that
+ * makes a jump may itself be removed before then.
+ */
+
+void Program::lineChanged(int lineNumber) {
+    relinkLines.push_back(lineNumber);
+    arraysChanged = true;
+    unordered_map<int, vector<int> >::const_iterator it = jumpSources.find(lineNumber);
+    if (it != jumpSources.end()) {
+        relinkLines.insert(relinkLines.end(), it->second.begin(), it->second.end());
+    }
+}
+
+/*
+ * Implementation notes: addJumpSource, removeJumpSource
+ * -----------------------------------------------------
+ * A target line rarely has more than a few jumps to it, so the sources
+ * are kept in a plain array.  An entry is removed when its array
+ * becomes empty, which keeps the index no larger than the program.
+ */
+
+static int getJumpLine(Statement *stmt) {
+    if (stmt == NULL) return -1;
+    if (stmt->getType() == GOTO_STMT) return ((GotoStmt *) stmt)->getLineNumber();
+    if (stmt->getType() == IF_STMT) return ((IfStmt *) stmt)->getLineNumber();
+    if (stmt->getType() == GOSUB_STMT) return ((GosubStmt *) stmt)->getLineNumber();
+    return -1;
+}
+
+void Program::addJumpSource(int lineNumber, Statement *stmt) {
+    int target = getJumpLine(stmt);
+    if (target != -1) jumpSources[target].push_back(lineNumber);
+}
+
+void Program::removeJumpSource(int lineNumber, Statement *stmt) {
+    int target = getJumpLine(stmt);
+    if (target == -1) return;
+    unordered_map<int, vector<int> >::iterator it = jumpSources.find(target);
+    if (it == jumpSources.end()) return;
+    vector<int> & sources = it->second;
+    vector<int>::iterator sp = find(sources.begin(), sources.end(), lineNumber);
+    if (sp != sources.end()) sources.erase(sp);
+    if (sources.empty()) jumpSources.erase(it);
+}
+
+int Program::findBlock(int lineNumber) {
+    return lower_bound(blockLast.begin(), blockLast.end(), lineNumber) - blockLast.begin();
+}
+
+Program::Line *Program::findLine(int lineNumber) {
+    return findPosition(lineNumber) ? &blocks[lastBlock][lastIndex] : NULL;
+}
+
+/*
+ * Implementation notes: findPosition
+ * ----------------------------------
+ * The remembered position is checked before searching.  Edits can move
+ * lines without updating it, so it is trusted only if it is in range
+ * and holds the line being looked for.
+ */
+
+bool Program::findPosition(int lineNumber) {
+    if (lastBlock < (int) blocks.size() && lastIndex < (int) blocks[lastBlock].size()
+            && blocks[lastBlock][lastIndex].lineNumber == lineNumber) {
+        return true;
+    }
+    int b = findBlock(lineNumber);
+    if (b == (int) blocks.size()) return false;
+    int i = findIndex(blocks[b], lineNumber);
+    if (blocks[b][i].lineNumber != lineNumber) return false;
+    lastBlock = b;
+    lastIndex = i;
+    return true;
+}
+
+int Program::findIndex(const Block & block, int lineNumber) {
+    int lo = 0;
+    int hi = block.size();
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (block[mid].lineNumber < lineNumber) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
     }
+    return lo;
 }
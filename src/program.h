@@ -9,8 +9,10 @@
 #define _program_h
 
 #include <string>
+#include <unordered_map>
+#include <vector>
+#include "arena.h"
 #include "statement.h"
-#include "hashmap.h"
 using namespace std;
 
 /*
@@ -26,6 +28,29 @@ using namespace std;
  *    pointer to a Statement.
  */
 
+/*
+ * Type: LineCode
+ * --------------
+ * This structure holds the instruction words compiled from one line,
+ * which Bytecode::compile keeps with the line so that a line that has
+ * not changed need not be compiled again.  The operand of each jump,
+ * whose position in words is listed in jumps, holds the target line
+ * number rather than an address, since addresses move whenever an
+ * earlier line changes size.  The jumps listed in loopJumps, which FOR
+ * and NEXT make, also hold a line number, but go to the line after it.
+ * The field maxStack is the deepest the operand stack gets in the line,
+ * and valid is false until the line has been compiled and again
+ * whenever its statement is replaced.
+ */
+
+struct LineCode {
+   std::vector<int> words;
+   std::vector<int> jumps;
+   std::vector<int> loopJumps;
+   int maxStack;
+   bool valid;
+};
+
 class Program {
 
 public:
@@ -94,15 +119,17 @@ public:
 
 /*
  * Method: setParsedStatement
- * Usage: program.setParsedStatement(lineNumber, stmt);
- * ----------------------------------------------------
+ * Usage: program.setParsedStatement(lineNumber, stmt, arena);
+ * -----------------------------------------------------------
  * Adds the parsed representation of the statement to the statement
  * at the specified line number.  If no such line exists, this
- * method raises an error.  If a previous parsed representation
- * exists, the memory for that statement is reclaimed.
+ * method raises an error.  The line takes over the contents of arena,
+ * which must hold the statement and its expressions and nothing that
+ * belongs to another line, and leaves it empty.  If a previous parsed
+ * representation exists, its arena is freed.
  */
 
-   void setParsedStatement(int lineNumber, Statement *stmt);
+   void setParsedStatement(int lineNumber, Statement *stmt, Arena & arena);
 
 /*
  * Method: getParsedStatement
@@ -115,6 +142,20 @@ public:
 
    Statement *getParsedStatement(int lineNumber);
 
+/*
+ * Methods: setEliminatedNodes, getEliminatedNodes
+ * Usage: program.setEliminatedNodes(lineNumber, count);
+ *        int total = program.getEliminatedNodes();
+ * -----------------------------------------------------
+ * These methods record the number of expression nodes that the
+ * optimizer removed from the statement on a line and return the total
+ * for the whole program.  The count for a line is reset whenever the
+ * line is replaced.
+ */
+
+   void setEliminatedNodes(int lineNumber, int count);
+   int getEliminatedNodes();
+
 /*
  * Method: getFirstLineNumber
  * Usage: int lineNumber = program.getFirstLineNumber();
@@ -136,121 +177,253 @@ public:
 
    int getNextLineNumber(int lineNumber);
 
+/*
+ * Method: link
+ * Usage: program.link();
+ * ----------------------
+ * Connects each statement to the statement on the following line and
+ * each GOTO, IF and GOSUB statement to the statement on its target
+ * line, so that running the program needs no line-number lookups.  If a
+ * jump names a line that does not exist, this method raises an error.
+ * The program remembers which links each edit invalidates, so after an
+ * edit only the edited line, the line before it, and the jumps to it
+ * are linked again, however long the program is.  Each NEXT is also
+ * paired with the FOR that it closes, which raises an error if a NEXT
+ * has no open FOR, names a different variable from the innermost open
+ * FOR, or if a FOR is never closed.  Finally, if the program uses
+ * arrays, the subscripts that are certain to be in range are marked
+ * so that they are not checked, which raises an error if an array is
+ * dimensioned twice or used with the wrong number of subscripts.
+ * Calling link on an unchanged program does nothing.
+ */
+
+   void link();
+
+/*
+ * Method: getFirstStatement
+ * Usage: Statement *stmt = program.getFirstStatement();
+ * -----------------------------------------------------
+ * Returns the parsed statement on the first line of the program, or
+ * NULL if the program is empty.  The program is linked first if it
+ * has changed since it was last linked.
+ */
+
+   Statement *getFirstStatement();
+
+/*
+ * Method: getLineCode
+ * Usage: LineCode *lineCode = program.getLineCode(lineNumber);
+ * ------------------------------------------------------------
+ * Returns the compiled code kept with the specified line, or NULL if
+ * there is no such line.  The pointer is valid until the next edit.
+ */
+
+   LineCode *getLineCode(int lineNumber);
+
+/*
+ * Methods: getData, restoreData
+ * Usage: if (program.getData(values)) ...
+ *        program.restoreData(state);
+ * ---------------------------------------
+ * The getData method fills values with the constants of the DATA
+ * statements in line order and returns true if the program has a DATA
+ * or MAT READ statement, which means that a run must begin by loading
+ * the values into the pool that MAT READ takes them from.  The
+ * restoreData method does that loading for a run of the parsed
+ * statements; compiled code does it in its first instruction.
+ */
+
+   bool getData(std::vector<int> & values);
+   void restoreData(EvalState & state);
+
 private:
 
-   /*Type for a doubly linked list cell where pointers point to previous cell or next cell in the list */
+/*
+ * Implementation notes: line storage
+ * ----------------------------------
+ * The lines are kept in line-number order in a two-level structure
+ * that behaves like a shallow B-tree.  The lower level is a sequence
+ * of blocks, each a small sorted array of at most MAX_BLOCK_SIZE lines
+ * stored contiguously.  The upper level is the array blockLast, which
+ * holds the largest line number in each block.  Finding a line takes
+ * one binary search in blockLast and one in the block; inserting or
+ * removing a line shifts at most one block's worth of entries, and a
+ * block that overflows is split in half.  Walking the program in order
+ * reads each block from front to back, which is friendly to the cache
+ * and to the hardware prefetcher.  Each line owns the arena that holds
+ * its statement, so replacing or removing a line, or clearing the
+ * program, frees the nodes of the old statements in bulk.
+ */
 
-    struct BasicStruct {
-     std::string line = "";
-     Statement *parsedLine = NULL;
-     int lineNumber = 0;
-    };
+/*
+ * Implementation notes: incremental linking
+ * -----------------------------------------
+ * Every edit appends to relinkLines the numbers of the lines whose
+ * links it may have broken: the edited line itself, whose predecessor
+ * must be pointed at whatever now follows it, and every line with a
+ * jump to it.  The jumps are found in jumpSources, a reverse index
+ * from each target line number to the lines that name it, which is
+ * kept up to date as statements are added and removed.  The index
+ * includes jumps to lines that do not exist, so that adding the line
+ * later repairs them.  Which NEXT closes which FOR depends on every
+ * loop in the program, so an edit that adds or removes a FOR or NEXT
+ * sets loopsChanged instead, and the loops are paired again in one
+ * walk; other edits leave the pairing alone.  Whether a subscript can
+ * go out of range may depend on any line, so every edit sets
+ * arraysChanged, but the arrays are examined again only while
+ * arrayLines, the number of lines that dimension or use an array, is
+ * not zero.  In the same way dataLines counts the DATA and MAT READ
+ * lines, so that a program without them need not be searched for DATA.
+ */
 
-    struct Cell {
-      BasicStruct data;
-      Cell *nextlink = NULL;
-      Cell *previouslink = NULL;
+    static const int MAX_BLOCK_SIZE = 128;
+
+    struct Line {
+        int lineNumber;
+        Statement *parsedLine;
+        std::string source;
+        int eliminated;
+        Arena arena;
+        LineCode code;
     };
 
-    /*Instance Variables */
-    //XXXX BEGINNING ENTRY FOR DOUBLY LINKED LIST XXXX////
-    HashMap<int, Cell *> basicMap;
-    Cell *head = NULL;
-    Cell *tail = NULL;
+    typedef std::vector<Line> Block;
+
+    /* Instance Variables */
+
+    std::vector<Block> blocks;
+    std::vector<int> blockLast;
+    std::vector<int> relinkLines;
+    std::unordered_map<int, std::vector<int> > jumpSources;
+    bool loopsChanged;
+    bool arraysChanged;
+    int arrayLines;
+    int dataLines;
+    int lastBlock;
+    int lastIndex;
 
     /* Private Methods */
 
 /*
- * Method: insertCellToList();
- * Usage: insertCellToList(cp);
+ * Method: findLine();
+ * Usage: Line *lp = findLine(lineNumber);
+ * ------------------------------------------------------------
+ *  Returns a pointer to the line with the specified number, or NULL if
+ *  there is no such line.  The pointer is valid until the next edit.
+ */
+
+    Line *findLine(int lineNumber);
+
+/*
+ * Method: findPosition();
+ * Usage: if (findPosition(lineNumber)) . . .
  * ------------------------------------------------------------
- *  Inserts cell into a doubly linked list.
+ *  Looks for the line with the specified number and returns true if it
+ *  exists, in which case lastBlock and lastIndex give its position.
  */
 
+    bool findPosition(int lineNumber);
+
+/*
+ * Method: findBlock();
+ * Usage: int b = findBlock(lineNumber);
+ * ------------------------------------------------------------
+ *  Returns the index of the first block whose last line number is at
+ *  least lineNumber, or the number of blocks if there is none.
+ */
 
-    void insertCellToList(Cell *cp) {
-        if(head==NULL) {
-            head = cp;
-            tail = cp;
-        } else if(cp->data.lineNumber > tail->data.lineNumber) {
-            cp->previouslink = tail;
-            tail->nextlink = cp;
-            tail = cp;
-        } else if(cp->data.lineNumber < head->data.lineNumber) {
-            cp->nextlink = head;
-            head->previouslink = cp;
-            head = cp;
-        } else if(cp->data.lineNumber == head->data.lineNumber &&
-                  cp->data.lineNumber == tail->data.lineNumber) {
-            delete head;
-            head = cp;
-            tail = cp;
-        } else if(cp->data.lineNumber == head->data.lineNumber) {
-            cp->nextlink = head->nextlink;
-            head->nextlink->previouslink = cp;
-            delete head;
-            head = cp;
-        } else if(cp->data.lineNumber == tail->data.lineNumber) {
-            tail->previouslink->nextlink = cp;
-            cp->previouslink = tail->previouslink;
-            delete tail;
-            tail = cp;
-        } else {
-            Cell *current = head;
-            while(current != tail) {
-                if(cp->data.lineNumber < current->nextlink->data.lineNumber) {
-                    current->nextlink->previouslink = cp;
-                    cp->nextlink = current->nextlink;
-                    current->nextlink = cp;
-                    cp->previouslink = current;
-                    break;
-                } else {
-                    current = current->nextlink;
-                }
-            }
-        }
-
-    }
+    int findBlock(int lineNumber);
 
 /*
- * Method: removeCellFromList();
- * Usage: removeCellFromList(cp);
+ * Method: findIndex();
+ * Usage: int i = findIndex(block, lineNumber);
  * ------------------------------------------------------------
- *  Removes cell from a doubly linked list.
+ *  Returns the index of the first line in the block whose number is
+ *  at least lineNumber, or the size of the block if there is none.
  */
 
+    static int findIndex(const Block & block, int lineNumber);
+
+/*
+ * Methods: findStatementAfter(), findStatementBefore();
+ * Usage: Statement *stmt = findStatementAfter(lineNumber);
+ *        Line *lp = findStatementBefore(lineNumber);
+ * ------------------------------------------------------------
+ *  Return the statement on the first line after lineNumber that has
+ *  one, and the last line before lineNumber that has a statement, or
+ *  NULL if there is none.  The line need not exist.
+ */
+
+    Statement *findStatementAfter(int lineNumber);
+    Line *findStatementBefore(int lineNumber);
+
+/*
+ * Method: getJumpTarget();
+ * Usage: Statement *stmt = getJumpTarget(target, source);
+ * ------------------------------------------------------------
+ *  Returns the statement on the target line of a jump made from the
+ *  source line, raising an error if the target line does not exist.
+ */
+
+    Statement *getJumpTarget(int target, int source);
+
+/*
+ * Methods: linkAll(), relinkLine(), linkJump();
+ * Usage: linkAll();
+ *        relinkLine(lineNumber);
+ *        linkJump(line);
+ * ------------------------------------------------------------
+ *  Link the whole program in one walk, link the line with the given
+ *  number (if it exists) and the line before it, and resolve the jump
+ *  on a single line.
+ */
+
+    void linkAll();
+    void relinkLine(int lineNumber);
+    void linkJump(Line & line);
+
+/*
+ * Methods: linkLoops(), checkLoopChange();
+ * Usage: linkLoops();
+ *        checkLoopChange(stmt);
+ * ------------------------------------------------------------
+ *  Pair every FOR in the program with its NEXT, and note that the
+ *  loops must be paired again if stmt is a FOR or NEXT.
+ */
+
+    void linkLoops();
+    void checkLoopChange(Statement *stmt);
+
+/*
+ * Methods: linkArrays(), countArrayLine(), countDataLine();
+ * Usage: linkArrays();
+ *        countArrayLine(stmt, delta);
+ *        countDataLine(stmt, delta);
+ * ------------------------------------------------------------
+ *  Decide which array subscripts in the program need to be checked,
+ *  and add delta to arrayLines if stmt dimensions or uses an array.
+ *  The countDataLine method adds delta to dataLines if stmt is a DATA
+ *  or MAT READ statement.
+ */
+
+    void linkArrays();
+    void countArrayLine(Statement *stmt, int delta);
+    void countDataLine(Statement *stmt, int delta);
+
+/*
+ * Methods: lineChanged(), addJumpSource(), removeJumpSource();
+ * Usage: lineChanged(lineNumber);
+ *        addJumpSource(lineNumber, stmt);
+ *        removeJumpSource(lineNumber, stmt);
+ * ------------------------------------------------------------
+ *  Record that the statement on a line has changed, and add or remove
+ *  the jump made by stmt on that line in the reverse jump index.
+ */
 
+    void lineChanged(int lineNumber);
+    void addJumpSource(int lineNumber, Statement *stmt);
+    void removeJumpSource(int lineNumber, Statement *stmt);
 
-    void removeCellFromList(int lineNumber) {
-        if(head->data.lineNumber == lineNumber &&
-           tail->data.lineNumber == lineNumber) {
-               Cell *temp = head;
-               head = NULL;
-               tail = NULL;
-               delete temp;
-        } else if(head->data.lineNumber == lineNumber) {
-               Cell *temp = head->nextlink;
-               temp->previouslink = NULL;
-               delete head;
-               head = temp;
-       } else if (tail->data.lineNumber == lineNumber) {
-               Cell *temp = tail->previouslink;
-               temp->nextlink = NULL;
-               delete tail;
-               tail = temp;
-       } else {
-            Cell *current = head;
-            while(current != tail) {
-                if (current->data.lineNumber == lineNumber) {
-                    current->previouslink->nextlink = current->nextlink;
-                    current->nextlink->previouslink = current->previouslink;
-                    break;
-                } else {
-                    current = current->nextlink;
-                }
-            }
-       }
-    }
 };
 
 #endif
@@ -0,0 +1,109 @@
+/*
+ * File: resolver.cpp
+ * ------------------
+ * This file implements the symbol-resolution pass.
+ */
+
+#include "evalstate.h"
+#include "exp.h"
+#include "resolver.h"
+#include "statement.h"
+using namespace std;
+
+/* Private function prototypes */
+
+static LoopControl resolveLoop(const string & var, EvalState & state);
+
+void resolveSymbols(Statement *stmt, EvalState & state) {
+   switch (stmt->getType()) {
+    case LET_STMT: {
+      LetStmt *let = (LetStmt *) stmt;
+      if (let->getElement() != NULL) {
+         resolveSymbols(let->getElement(), state);
+      } else {
+         let->setSlot(state.getSlot(let->getVar()));
+      }
+      resolveSymbols(let->getExp(), state);
+      break;
+    }
+    case PRINT_STMT:
+      resolveSymbols(((PrintStmt *) stmt)->getExp(), state);
+      break;
+    case INPUT_STMT: {
+      InputStmt *input = (InputStmt *) stmt;
+      input->setSlot(state.getSlot(input->getVar()));
+      break;
+    }
+    case IF_STMT:
+      resolveSymbols(((IfStmt *) stmt)->getLHS(), state);
+      resolveSymbols(((IfStmt *) stmt)->getRHS(), state);
+      break;
+    case FOR_STMT: {
+      ForStmt *forStmt = (ForStmt *) stmt;
+      forStmt->setControl(resolveLoop(forStmt->getVar(), state));
+      resolveSymbols(forStmt->getStart(), state);
+      resolveSymbols(forStmt->getLimit(), state);
+      resolveSymbols(forStmt->getStep(), state);
+      break;
+    }
+    case NEXT_STMT: {
+      NextStmt *next = (NextStmt *) stmt;
+      next->setControl(resolveLoop(next->getVar(), state));
+      break;
+    }
+    case DIM_STMT: {
+      DimStmt *dim = (DimStmt *) stmt;
+      dim->setSlot(state.getArraySlot(dim->getVar()));
+      break;
+    }
+    case MAT_STMT: {
+      MatStmt *mat = (MatStmt *) stmt;
+      mat->setSlots(state.getArraySlot(mat->getDest()), state.getArraySlot(mat->getLHS()),
+                    state.getArraySlot(mat->getRHS()));
+      if (mat->getScalar() != NULL) resolveSymbols(mat->getScalar(), state);
+      break;
+    }
+    default:
+      break;
+   }
+}
+
+void resolveSymbols(Expression *exp, EvalState & state) {
+   switch (exp->getType()) {
+    case IDENTIFIER: {
+      IdentifierExp *id = (IdentifierExp *) exp;
+      id->setSlot(state.getSlot(id->getName()));
+      break;
+    }
+    case COMPOUND:
+      resolveSymbols(((CompoundExp *) exp)->getLHS(), state);
+      resolveSymbols(((CompoundExp *) exp)->getRHS(), state);
+      break;
+    case ARRAY: {
+      ArrayExp *element = (ArrayExp *) exp;
+      element->setSlot(state.getArraySlot(element->getName()));
+      resolveSymbols(element->getRow(), state);
+      if (element->getColumn() != NULL) resolveSymbols(element->getColumn(), state);
+      break;
+    }
+    default:
+      break;
+   }
+}
+
+/*
+ * Function: resolveLoop
+ * Usage: LoopControl control = resolveLoop(var, state);
+ * -----------------------------------------------------
+ * Returns the loop control block of a loop on the variable var.  The
+ * period in the names of the hidden variables keeps them apart from
+ * every variable that a program can name.
+ */
+
+static LoopControl resolveLoop(const string & var, EvalState & state) {
+   LoopControl control;
+   control.counter = state.getSlot(var);
+   control.limit = state.getSlot(var + ".limit");
+   control.step = state.getSlot(var + ".step");
+   return control;
+}
@@ -0,0 +1,29 @@
+/*
+ * File: resolver.h
+ * ----------------
+ * This interface exports the symbol-resolution pass, which assigns
+ * EvalState slots to the variables named in a parsed statement.
+ */
+
+#ifndef _resolver_h
+#define _resolver_h
+
+#include "evalstate.h"
+#include "exp.h"
+#include "statement.h"
+
+/*
+ * Function: resolveSymbols
+ * Usage: resolveSymbols(stmt, state);
+ *        resolveSymbols(exp, state);
+ * ----------------------------------
+ * Walks the statement or expression and records in each variable
+ * reference the slot that the EvalState assigns to its name.  Every
+ * statement must be resolved against the EvalState in which it will
+ * later be executed.
+ */
+
+void resolveSymbols(Statement *stmt, EvalState & state);
+void resolveSymbols(Expression *exp, EvalState & state);
+
+#endif
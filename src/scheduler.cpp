@@ -0,0 +1,84 @@
+/*
+ * File: scheduler.cpp
+ * -------------------
+ * This file implements the Scheduler class.
+ */
+
+#include <deque>
+#include <string>
+#include <vector>
+#include "error.h"
+#include "interpreter.h"
+#include "scheduler.h"
+using namespace std;
+
+Scheduler::Scheduler(int quantum) {
+   this->quantum = (quantum > 0) ? quantum : DEFAULT_QUANTUM;
+}
+
+int Scheduler::add(Interpreter & interp) {
+   Task task;
+   task.interp = &interp;
+   tasks.push_back(task);
+   int id = tasks.size() - 1;
+   if (interp.getStatus() == STEP_YIELDED) ready.push_back(id);
+   return id;
+}
+
+/*
+ * Implementation notes: runOnce
+ * -----------------------------
+ * The round covers only the programs in the queue when it begins, so a
+ * program that yields goes to the back and waits for the next round.
+ * When a program ends, its output is flushed, so that nothing is left
+ * in its buffer however long the scheduler goes on running others.
+ */
+
+bool Scheduler::runOnce() {
+   int n = ready.size();
+   for (int i = 0; i < n; i++) {
+      int id = ready.front();
+      ready.pop_front();
+      Task & task = tasks[id];
+      StepStatus status;
+      try {
+         status = task.interp->step(quantum);
+      } catch (ErrorException & ex) {
+         task.error = ex.getMessage();
+         status = STEP_FINISHED;
+      }
+      if (status == STEP_YIELDED) {
+         ready.push_back(id);
+      } else if (status == STEP_FINISHED) {
+         task.interp->getState().getOutput().flush();
+      }
+   }
+   return !ready.empty();
+}
+
+void Scheduler::run() {
+   while (runOnce()) {
+      /* Empty */
+   }
+}
+
+void Scheduler::provideInput(int id, int value) {
+   tasks[id].interp->provideInput(value);
+   ready.push_back(id);
+}
+
+StepStatus Scheduler::getStatus(int id) const {
+   return tasks[id].interp->getStatus();
+}
+
+string Scheduler::getError(int id) const {
+   return tasks[id].error;
+}
+
+int Scheduler::size() const {
+   return tasks.size();
+}
+
+int Scheduler::getReadyCount() const {
+   return ready.size();
+}
@@ -0,0 +1,130 @@
+/*
+ * File: scheduler.h
+ * -----------------
+ * This interface exports the Scheduler class, which shares a single
+ * thread among many BASIC programs.
+ */
+
+#ifndef _scheduler_h
+#define _scheduler_h
+
+#include <deque>
+#include <string>
+#include <vector>
+#include "interpreter.h"
+
+/*
+ * Class: Scheduler
+ * ----------------
+ * This class multiplexes any number of interpreters on the calling
+ * thread.  Programs that can run are kept in a queue and given slices
+ * of the same number of statements in turn, so that each one advances
+ * at the same rate however long the others run.  A program that blocks
+ * on INPUT leaves the queue until provideInput supplies its value, and
+ * a program that ends or raises an error leaves it for good.
+ */
+
+class Scheduler {
+
+public:
+
+/* Constant: DEFAULT_QUANTUM -- Statements in each slice by default */
+
+   static const int DEFAULT_QUANTUM = 1000;
+
+/*
+ * Constructor: Scheduler
+ * Usage: Scheduler scheduler;
+ *        Scheduler scheduler(quantum);
+ * ------------------------------------
+ * Creates a scheduler with no programs, which gives each program
+ * slices of the specified number of statements.
+ */
+
+   explicit Scheduler(int quantum = DEFAULT_QUANTUM);
+
+/*
+ * Method: add
+ * Usage: int id = scheduler.add(interp);
+ * --------------------------------------
+ * Adds the interpreter to the end of the queue and returns the number
+ * by which the other methods refer to it.  Numbers are assigned from
+ * zero in the order programs are added.  The interpreter must outlive
+ * the scheduler.
+ */
+
+   int add(Interpreter & interp);
+
+/*
+ * Method: runOnce
+ * Usage: while (scheduler.runOnce()) . . .
+ * ----------------------------------------
+ * Gives one slice to each program that was ready to run when the call
+ * began, and returns true if any program is still ready to run.
+ * Calling runOnce repeatedly lets the caller do other work, such as
+ * answering INPUT requests, between rounds.
+ */
+
+   bool runOnce();
+
+/*
+ * Method: run
+ * Usage: scheduler.run();
+ * -----------------------
+ * Runs rounds until every program has either ended or blocked.
+ */
+
+   void run();
+
+/*
+ * Method: provideInput
+ * Usage: scheduler.provideInput(id, value);
+ * -----------------------------------------
+ * Supplies a value to the program with the specified number, which
+ * must be blocked on INPUT, and returns it to the queue.
+ */
+
+   void provideInput(int id, int value);
+
+/*
+ * Methods: getStatus, getError
+ * Usage: StepStatus status = scheduler.getStatus(id);
+ *        string msg = scheduler.getError(id);
+ * ---------------------------------------------------
+ * Return the status of the program with the specified number and the
+ * message for the error that ended it, which is empty if none did.
+ */
+
+   StepStatus getStatus(int id) const;
+   std::string getError(int id) const;
+
+/*
+ * Methods: size, getReadyCount
+ * Usage: int n = scheduler.size();
+ *        int n = scheduler.getReadyCount();
+ * -----------------------------------------
+ * Return the number of programs added and the number now waiting in
+ * the queue to run.
+ */
+
+   int size() const;
+   int getReadyCount() const;
+
+private:
+
+/* Type used for each program the scheduler manages */
+
+   struct Task {
+      Interpreter *interp;
+      std::string error;
+   };
+
+/* Instance variables */
+
+   std::vector<Task> tasks;     /* Every program, indexed by number  */
+   std::deque<int> ready;       /* Programs waiting for a slice      */
+   int quantum;                 /* Statements in each slice          */
+
+};
+
+#endif
@@ -8,6 +8,7 @@
  */
 
 #include <string>
+#include <vector>
 #include "statement.h"
 #include "exp.h"
 #include "parser.h"
@@ -15,10 +16,6 @@
 #include "string.h"
 using namespace std;
 
-/* Constant Variable  */
-
-const int STOP = -999;
-
 /* Implementation of the Statement class
  * -------------------------------------
  * The Statement class itself implements only those methods that
@@ -26,13 +23,21 @@ const int STOP = -999;
  */
 
 Statement::Statement() {
-    /* Empty */
+    next = NULL;
 }
 
 Statement::~Statement() {
     /* Empty */
 }
 
+void Statement::setNext(Statement *stmt) {
+    next = stmt;
+}
+
+Statement *Statement::getNext() {
+    return next;
+}
+
 /*
  * Implementation notes: RemStmt
  * -----------------------------
@@ -41,47 +46,102 @@ Statement::~Statement() {
  *
  */
 
-RemStmt::RemStmt(TokenScanner & scanner){
+RemStmt::RemStmt(Lexer & lexer, Arena & arena){
 
 }
 
 RemStmt::~RemStmt() {
-    delete exp;
+    /* Empty */
 }
 
 void RemStmt::execute(EvalState & state) {
 
 }
 
+StatementType RemStmt::getType() {
+    return REM_STMT;
+}
+
 
 /*
  * Implementation notes: LetStmt
  * -----------------------------
  * The LetStmt subclass creates an object that handles assignment operations in
- * BASIC. The scanner reads the first token as a variable name, ignores the equal
+ * BASIC. The lexer reads the first token as a variable name, ignores the equal
  * sign that follows - throwing an error if one does not - and evaluates the
  * expression on the right hand side of the equals sign. This variable and value
- * are stored as key and value in the symbolMap which belongs to the EvalState Class
+ * are stored as key and value in the symbolMap which belongs to the EvalState Class.
+ * A variable followed by a parenthesis is an array element, whose
+ * subscripts are evaluated before the expression.  The kind of the
+ * variable is decided once, here, so that execute asks the expression
+ * for a value of that kind directly.
  */
 
-LetStmt::LetStmt(TokenScanner & scanner){
-    var = scanner.nextToken();
-    if(scanner.nextToken() != "=") {
+LetStmt::LetStmt(Lexer & lexer, Arena & arena){
+    slot = -1;
+    element = NULL;
+    var = lexer.getText(lexer.nextToken());
+    kind = getNameKind(var);
+    Token token = lexer.nextToken();
+    if (token.kind == TOKEN_OPERATOR && token.value == '(') {
+        lexer.unreadToken();
+        element = readArray(var, lexer, arena);
+        token = lexer.nextToken();
+    }
+    if (token.kind != TOKEN_OPERATOR || token.value != '=') {
         error("Improper LET statement. Enter line in the form of LET variable = expression");
     } else {
-        exp = readE(scanner, 0);
-        if (scanner.hasMoreTokens()) {
-            error("Extraneous token " + scanner.nextToken());
+        exp = readE(lexer, arena, 0);
+        checkConstant(exp, (element == NULL) ? kind : INT_VALUE, var);
+        if (lexer.hasMoreTokens()) {
+            error("Extraneous token " + lexer.getText(lexer.nextToken()));
         }
     }
 }
 
 LetStmt::~LetStmt() {
-    delete exp;
+    /* Empty */
 }
 
 void LetStmt::execute(EvalState & state) {
-    state.setValue(var, exp->eval(state));
+    if (element != NULL) {
+        int index = element->getIndex(state);
+        state.setElement(element->getSlot(), index, exp->eval(state));
+        return;
+    }
+    switch (kind) {
+     case LONG_VALUE: state.setLong(slot, exp->evalLong(state)); break;
+     case DOUBLE_VALUE: state.setDouble(slot, exp->evalDouble(state)); break;
+     default: state.setValue(slot, exp->eval(state)); break;
+    }
+}
+
+StatementType LetStmt::getType() {
+    return LET_STMT;
+}
+
+string LetStmt::getVar() {
+    return var;
+}
+
+Expression *LetStmt::getExp() {
+    return exp;
+}
+
+void LetStmt::setExp(Expression *exp) {
+    this->exp = exp;
+}
+
+void LetStmt::setSlot(int slot) {
+    this->slot = slot;
+}
+
+int LetStmt::getSlot() {
+    return slot;
+}
+
+ArrayExp *LetStmt::getElement() {
+    return element;
 }
 
 /*
@@ -92,19 +152,35 @@ void LetStmt::execute(EvalState & state) {
  * method prints the expression to the console.
  */
 
-PrintStmt::PrintStmt(TokenScanner & scanner){
-    exp = readE(scanner, 0);
-    if (scanner.hasMoreTokens()) {
-        error("Extraneous token " + scanner.nextToken());
+PrintStmt::PrintStmt(Lexer & lexer, Arena & arena){
+    exp = readE(lexer, arena, 0);
+    if (lexer.hasMoreTokens()) {
+        error("Extraneous token " + lexer.getText(lexer.nextToken()));
     }
 }
 
 PrintStmt::~PrintStmt() {
-    delete exp;
+    /* Empty */
 }
 
 void PrintStmt::execute(EvalState & state) {
-    cout << exp->eval(state) << endl;
+    switch (exp->getKind()) {
+     case LONG_VALUE: state.getOutput().printLong(exp->evalLong(state)); break;
+     case DOUBLE_VALUE: state.getOutput().printDouble(exp->evalDouble(state)); break;
+     default: state.getOutput().printInteger(exp->eval(state)); break;
+    }
+}
+
+StatementType PrintStmt::getType() {
+    return PRINT_STMT;
+}
+
+Expression *PrintStmt::getExp() {
+    return exp;
+}
+
+void PrintStmt::setExp(Expression *exp) {
+    this->exp = exp;
 }
 
 /*
@@ -114,110 +190,710 @@ void PrintStmt::execute(EvalState & state) {
  * the user for a value to associate with that variable name. The program insists
  * that the user enters an integer otherwise an error is thown. In this version the
  * user cannot define a variable as a function of other previously defined variables.
+ * Since only integers are read, the variable may not have a type suffix.
  */
 
-InputStmt::InputStmt(TokenScanner & scanner){
-    var = scanner.nextToken();
-    if (scanner.hasMoreTokens()) {
-        error("Extraneous token " + scanner.nextToken());
+InputStmt::InputStmt(Lexer & lexer, Arena & arena){
+    slot = -1;
+    var = lexer.getText(lexer.nextToken());
+    if (getNameKind(var) != INT_VALUE) {
+        error("Illegal variable in INPUT statement");
+    }
+    if (lexer.hasMoreTokens()) {
+        error("Extraneous token " + lexer.getText(lexer.nextToken()));
     }
 }
 
 InputStmt::~InputStmt() {
-    delete exp;
+    /* Empty */
 }
 
 void InputStmt::execute(EvalState & state) {
-    value = getInteger(" ? ");
-    state.setValue(var, value);
+    value = state.readInput();
+    state.setValue(slot, value);
+}
+
+StatementType InputStmt::getType() {
+    return INPUT_STMT;
+}
+
+string InputStmt::getVar() {
+    return var;
+}
+
+void InputStmt::setSlot(int slot) {
+    this->slot = slot;
 }
+
+int InputStmt::getSlot() {
+    return slot;
+}
+
 /*
  * Implementation notes: GotoStmt
  * -----------------------------
- *
+ * The GotoStmt subclass stores the target line number as written and
+ * the statement on that line once the program has been linked, so
+ * that execute transfers control without looking the line up.
  */
 
-GotoStmt::GotoStmt(TokenScanner & scanner){
-    lineNumber = stringToInteger(scanner.nextToken());
-    if (scanner.hasMoreTokens()) {
-        error("Extraneous token " + scanner.nextToken());
+GotoStmt::GotoStmt(Lexer & lexer, Arena & arena){
+    target = NULL;
+    lineNumber = lexer.getInteger(lexer.nextToken());
+    if (lexer.hasMoreTokens()) {
+        error("Extraneous token " + lexer.getText(lexer.nextToken()));
     }
 }
 
 GotoStmt::~GotoStmt() {
-    delete exp;
+    /* Empty */
 }
 
 void GotoStmt::execute(EvalState & state) {
-    state.setCurrentLine(lineNumber);
+    state.setNextStatement(target);
+}
+
+StatementType GotoStmt::getType() {
+    return GOTO_STMT;
+}
+
+int GotoStmt::getLineNumber() {
+    return lineNumber;
+}
+
+void GotoStmt::setTarget(Statement *stmt) {
+    target = stmt;
+}
+
+Statement *GotoStmt::getTarget() {
+    return target;
 }
 
 /*
  * Implementation notes: IfStmt
  * -----------------------------
- *
+ * The comparison operator is decoded when the statement is parsed, so
+ * that execute needs only a switch on the decoded value.  The kind of
+ * the comparison is decided at the same time, and both sides are
+ * evaluated in that kind, the left one first.
  */
 
-IfStmt::IfStmt(TokenScanner & scanner){
-    expLhs = readE(scanner, 0);
-    op = scanner.nextToken();
-    expRhs = readE(scanner, 0);
-    if(toUpperCase(scanner.nextToken()) != "THEN") {
+template <typename T>
+static bool compareValues(OperatorType op, T lhs, T rhs) {
+    switch (op) {
+     case EQUAL_OP: return lhs == rhs;
+     case LESS_OP: return lhs < rhs;
+     case GREATER_OP: return lhs > rhs;
+     default: return false;
+    }
+}
+
+IfStmt::IfStmt(Lexer & lexer, Arena & arena){
+    target = NULL;
+    expLhs = readE(lexer, arena, 0);
+    Token token = lexer.nextToken();
+    op = (token.kind == TOKEN_OPERATOR) ? charToOperator(token.value) : ILLEGAL_OP;
+    if (op == ASSIGN_OP) op = EQUAL_OP;
+    if (op != EQUAL_OP && op != LESS_OP && op != GREATER_OP) {
+        error("Illegal comparison operator " + lexer.getText(token));
+    }
+    expRhs = readE(lexer, arena, 0);
+    kind = widerKind(expLhs->getKind(), expRhs->getKind());
+    if (lexer.getKeyword(lexer.nextToken()) != KEYWORD_THEN) {
         error("Illegal Format: condition must be followed by THEN");
     }
-    lineNumber = stringToInteger(scanner.nextToken());
-    if (scanner.hasMoreTokens()) {
-        error("Extraneous token " + scanner.nextToken());
+    lineNumber = lexer.getInteger(lexer.nextToken());
+    if (lexer.hasMoreTokens()) {
+        error("Extraneous token " + lexer.getText(lexer.nextToken()));
     }
 }
 
 IfStmt::~IfStmt() {
-    delete expLhs;
-    delete expRhs;
+    /* Empty */
 }
 
 void IfStmt::execute(EvalState & state) {
-    int evalLeft = expLhs->eval(state);
-    int evalRight = expRhs->eval(state);
-    if(((op == "=") && (evalLeft == evalRight)) ||
-      ((op == ">") && (evalLeft > evalRight)) ||
-      ((op == "<") && (evalLeft < evalRight)))   {
-        state.setCurrentLine(lineNumber);
+    bool condition;
+    switch (kind) {
+     case LONG_VALUE: {
+        long long evalLeft = expLhs->evalLong(state);
+        condition = compareValues(op, evalLeft, expRhs->evalLong(state));
+        break;
+     }
+     case DOUBLE_VALUE: {
+        double evalLeft = expLhs->evalDouble(state);
+        condition = compareValues(op, evalLeft, expRhs->evalDouble(state));
+        break;
+     }
+     default: {
+        int evalLeft = expLhs->eval(state);
+        condition = compareValues(op, evalLeft, expRhs->eval(state));
+        break;
+     }
     }
+    if (condition) {
+        state.setNextStatement(target);
+    }
+}
+
+StatementType IfStmt::getType() {
+    return IF_STMT;
+}
+
+Expression *IfStmt::getLHS() {
+    return expLhs;
+}
+
+OperatorType IfStmt::getOp() {
+    return op;
+}
+
+Expression *IfStmt::getRHS() {
+    return expRhs;
+}
+
+void IfStmt::setLHS(Expression *lhs) {
+    expLhs = lhs;
+}
+
+void IfStmt::setRHS(Expression *rhs) {
+    expRhs = rhs;
+}
+
+ValueKind IfStmt::getKind() {
+    return kind;
 }
 
+int IfStmt::getLineNumber() {
+    return lineNumber;
+}
+
+void IfStmt::setTarget(Statement *stmt) {
+    target = stmt;
+}
+
+Statement *IfStmt::getTarget() {
+    return target;
+}
 
 /*
- * Implementation notes: EndStmt
+ * Implementation notes: ForStmt
  * -----------------------------
- *
+ * All three expressions are evaluated before the counter is set, so
+ * that a limit or step that mentions the counter sees its old value.
+ * The limit and step are stored in the loop control block, which is
+ * all that the matching NEXT needs to decide whether to loop again.
+ * The counter must be an int variable, since the control block holds
+ * ints.
  */
 
-EndStmt::EndStmt(TokenScanner & scanner){
-    if (scanner.hasMoreTokens()) {
-        error("Extraneous token " + scanner.nextToken());
+ForStmt::ForStmt(Lexer & lexer, Arena & arena){
+    loopEnd = NULL;
+    loopEndLine = -1;
+    control.counter = control.limit = control.step = -1;
+    Token token = lexer.nextToken();
+    if (token.kind != TOKEN_WORD || getNameKind(lexer.getText(token)) != INT_VALUE) {
+        error("Illegal variable in FOR statement");
+    }
+    var = lexer.getText(token);
+    token = lexer.nextToken();
+    if (token.kind != TOKEN_OPERATOR || token.value != '=') {
+        error("Improper FOR statement. Enter line in the form of FOR variable = expression TO expression");
+    }
+    start = readE(lexer, arena, 0);
+    if (lexer.getKeyword(lexer.nextToken()) != KEYWORD_TO) {
+        error("Illegal Format: starting value must be followed by TO");
+    }
+    limit = readE(lexer, arena, 0);
+    if (lexer.getKeyword(lexer.nextToken()) == KEYWORD_STEP) {
+        step = readE(lexer, arena, 0);
+    } else {
+        lexer.unreadToken();
+        step = arena.make<ConstantExp>(1);
+    }
+    checkConstant(start, INT_VALUE, var);
+    checkConstant(limit, INT_VALUE, var);
+    checkConstant(step, INT_VALUE, var);
+    if (lexer.hasMoreTokens()) {
+        error("Extraneous token " + lexer.getText(lexer.nextToken()));
     }
-    stopCondition = STOP;
 }
 
-EndStmt::~EndStmt() {
-    delete exp;
+ForStmt::~ForStmt() {
+    /* Empty */
 }
 
-void EndStmt::execute(EvalState & state) {
-    state.setCurrentLine(stopCondition);
+void ForStmt::execute(EvalState & state) {
+    int value = start->eval(state);
+    int limitValue = limit->eval(state);
+    int stepValue = step->eval(state);
+    state.setValue(control.counter, value);
+    state.setValue(control.limit, limitValue);
+    state.setValue(control.step, stepValue);
+    if (!loopContinues(value, limitValue, stepValue)) {
+        state.setNextStatement(loopEnd->getNext());
+    }
+}
+
+StatementType ForStmt::getType() {
+    return FOR_STMT;
+}
+
+string ForStmt::getVar() {
+    return var;
+}
+
+Expression *ForStmt::getStart() {
+    return start;
+}
+
+Expression *ForStmt::getLimit() {
+    return limit;
+}
+
+Expression *ForStmt::getStep() {
+    return step;
+}
+
+void ForStmt::setStart(Expression *start) {
+    this->start = start;
+}
+
+void ForStmt::setLimit(Expression *limit) {
+    this->limit = limit;
+}
+
+void ForStmt::setStep(Expression *step) {
+    this->step = step;
+}
+
+void ForStmt::setControl(const LoopControl & control) {
+    this->control = control;
+}
+
+const LoopControl & ForStmt::getControl() {
+    return control;
+}
+
+void ForStmt::setLoopEnd(Statement *stmt, int lineNumber) {
+    loopEnd = stmt;
+    loopEndLine = lineNumber;
+}
+
+Statement *ForStmt::getLoopEnd() {
+    return loopEnd;
+}
+
+int ForStmt::getLoopEndLine() {
+    return loopEndLine;
+}
+
+/*
+ * Implementation notes: NextStmt
+ * ------------------------------
+ * Program::link pairs each NEXT with a FOR, but a GOTO can still enter
+ * the body of a loop whose FOR has never run.  FOR always sets the step
+ * along with the counter and limit, so an undefined step is how NEXT
+ * detects that case.  The sum of the counter and step is formed in a
+ * wider type, so that overflow ends the loop instead of wrapping the
+ * counter back below the limit.
+ */
+
+NextStmt::NextStmt(Lexer & lexer, Arena & arena){
+    loopStart = NULL;
+    loopStartLine = -1;
+    control.counter = control.limit = control.step = -1;
+    Token token = lexer.nextToken();
+    if (token.kind != TOKEN_WORD || getNameKind(lexer.getText(token)) != INT_VALUE) {
+        error("Illegal variable in NEXT statement");
+    }
+    var = lexer.getText(token);
+    if (lexer.hasMoreTokens()) {
+        error("Extraneous token " + lexer.getText(lexer.nextToken()));
+    }
+}
+
+NextStmt::~NextStmt() {
+    /* Empty */
+}
+
+void NextStmt::execute(EvalState & state) {
+    if (!state.isDefined(control.step)) error("NEXT without FOR");
+    int stepValue = state.getValue(control.step);
+    long long value = (long long) state.getValue(control.counter) + stepValue;
+    state.setValue(control.counter, (int) value);
+    if (loopContinues(value, state.getValue(control.limit), stepValue)) {
+        state.setNextStatement(loopStart->getNext());
+    }
+}
+
+StatementType NextStmt::getType() {
+    return NEXT_STMT;
+}
+
+string NextStmt::getVar() {
+    return var;
+}
+
+void NextStmt::setControl(const LoopControl & control) {
+    this->control = control;
+}
+
+const LoopControl & NextStmt::getControl() {
+    return control;
+}
+
+void NextStmt::setLoopStart(Statement *stmt, int lineNumber) {
+    loopStart = stmt;
+    loopStartLine = lineNumber;
+}
+
+Statement *NextStmt::getLoopStart() {
+    return loopStart;
+}
+
+int NextStmt::getLoopStartLine() {
+    return loopStartLine;
+}
+
+/*
+ * Implementation notes: GosubStmt
+ * -------------------------------
+ * The return address is the linked successor of the GOSUB, so RETURN
+ * resumes with a pointer rather than a line number to look up.  A GOSUB
+ * on the last line pushes NULL, and the RETURN then ends the program.
+ */
+
+GosubStmt::GosubStmt(Lexer & lexer, Arena & arena){
+    target = NULL;
+    lineNumber = lexer.getInteger(lexer.nextToken());
+    if (lexer.hasMoreTokens()) {
+        error("Extraneous token " + lexer.getText(lexer.nextToken()));
+    }
+}
+
+GosubStmt::~GosubStmt() {
+    /* Empty */
+}
+
+void GosubStmt::execute(EvalState & state) {
+    state.pushReturn(getNext());
+    state.setNextStatement(target);
+}
+
+StatementType GosubStmt::getType() {
+    return GOSUB_STMT;
+}
+
+int GosubStmt::getLineNumber() {
+    return lineNumber;
+}
+
+void GosubStmt::setTarget(Statement *stmt) {
+    target = stmt;
+}
+
+Statement *GosubStmt::getTarget() {
+    return target;
+}
+
+/*
+ * Implementation notes: ReturnStmt
+ * --------------------------------
+ * The tree walker is the only engine that pushes statements, and every
+ * run begins with an empty stack, so whatever RETURN pops is one.
+ */
+
+ReturnStmt::ReturnStmt(Lexer & lexer, Arena & arena){
+    if (lexer.hasMoreTokens()) {
+        error("Extraneous token " + lexer.getText(lexer.nextToken()));
+    }
+}
+
+ReturnStmt::~ReturnStmt() {
+    /* Empty */
+}
+
+void ReturnStmt::execute(EvalState & state) {
+    state.setNextStatement((Statement *) state.popReturn());
+}
+
+StatementType ReturnStmt::getType() {
+    return RETURN_STMT;
+}
+
+
+/*
+ * Implementation notes: DimStmt
+ * -----------------------------
+ * The bounds are stored as the number of values each subscript can
+ * take, which is one more than the bound, since subscripts start at
+ * zero.  The size is checked here so that a program that asks for too
+ * much storage is rejected when it is entered rather than when it runs.
+ */
+
+static int readBound(Lexer & lexer) {
+    Token token = lexer.nextToken();
+    if (token.kind != TOKEN_NUMBER || !token.isInteger || token.value < 0) {
+        error("Improper DIM statement. Enter line in the form of DIM array(n) or DIM array(n, m)");
+    }
+    return token.value;
+}
+
+DimStmt::DimStmt(Lexer & lexer, Arena & arena){
+    slot = -1;
+    columns = 0;
+    Token token = lexer.nextToken();
+    Token paren = lexer.nextToken();
+    if (token.kind != TOKEN_WORD || paren.kind != TOKEN_OPERATOR || paren.value != '(') {
+        error("Improper DIM statement. Enter line in the form of DIM array(n) or DIM array(n, m)");
+    }
+    var = lexer.getText(token);
+    checkArrayName(var);
+    long long size = (long long) readBound(lexer) + 1;
+    rows = (int) size;
+    token = lexer.nextToken();
+    if (token.kind == TOKEN_OPERATOR && token.value == ',') {
+        long long count = (long long) readBound(lexer) + 1;
+        columns = (int) count;
+        size *= count;
+        token = lexer.nextToken();
+    }
+    if (token.kind != TOKEN_OPERATOR || token.value != ')') {
+        error("Improper DIM statement. Enter line in the form of DIM array(n) or DIM array(n, m)");
+    }
+    if (size > MAX_ARRAY_SIZE) error("Array " + var + " is too large");
+    if (lexer.hasMoreTokens()) {
+        error("Extraneous token " + lexer.getText(lexer.nextToken()));
+    }
+}
+
+DimStmt::~DimStmt() {
+    /* Empty */
+}
+
+void DimStmt::execute(EvalState & state) {
+    state.dimension(slot, rows, columns);
+}
+
+StatementType DimStmt::getType() {
+    return DIM_STMT;
+}
+
+string DimStmt::getVar() {
+    return var;
+}
+
+int DimStmt::getRows() {
+    return rows;
+}
+
+int DimStmt::getColumns() {
+    return columns;
+}
+
+void DimStmt::setSlot(int slot) {
+    this->slot = slot;
 }
 
+int DimStmt::getSlot() {
+    return slot;
+}
 
 
+/*
+ * Implementation notes: MatStmt
+ * -----------------------------
+ * The form of the statement is decided by the token after the equal
+ * sign: TRN introduces a transpose, an opening parenthesis a scalar
+ * multiple, and a name either a copy or, if an operator and a second
+ * name follow, a sum, difference or product.  The dimensions of the
+ * arrays are checked when the statement runs, by executeMat.
+ */
 
+static const string MAT_USAGE = "Improper MAT statement. Enter line in the form of "
+                                "MAT C = A + B, MAT C = A * B, MAT C = (k) * A, "
+                                "MAT C = TRN(A), MAT READ A or MAT PRINT A";
 
+static bool isOperator(const Token & token, char op) {
+    return token.kind == TOKEN_OPERATOR && token.value == op;
+}
 
+static string readArrayName(Lexer & lexer) {
+    Token token = lexer.nextToken();
+    if (token.kind != TOKEN_WORD) error(MAT_USAGE);
+    string name = lexer.getText(token);
+    checkArrayName(name);
+    return name;
+}
 
+MatStmt::MatStmt(Lexer & lexer, Arena & arena){
+    scalar = NULL;
+    destSlot = lhsSlot = rhsSlot = -1;
+    Token token = lexer.nextToken();
+    Keyword keyword = lexer.getKeyword(token);
+    if (keyword == KEYWORD_READ || keyword == KEYWORD_PRINT) {
+        op = (keyword == KEYWORD_READ) ? MAT_READ : MAT_PRINT;
+        dest = lhs = rhs = readArrayName(lexer);
+    } else {
+        lexer.unreadToken();
+        dest = readArrayName(lexer);
+        if (!isOperator(lexer.nextToken(), '=')) error(MAT_USAGE);
+        token = lexer.nextToken();
+        if (lexer.getKeyword(token) == KEYWORD_TRN) {
+            op = MAT_TRN;
+            if (!isOperator(lexer.nextToken(), '(')) error(MAT_USAGE);
+            lhs = rhs = readArrayName(lexer);
+            if (!isOperator(lexer.nextToken(), ')')) error(MAT_USAGE);
+        } else if (isOperator(token, '(')) {
+            op = MAT_SCALE;
+            scalar = readE(lexer, arena, 0);
+            checkConstant(scalar, INT_VALUE, dest);
+            if (!isOperator(lexer.nextToken(), ')') || !isOperator(lexer.nextToken(), '*')) {
+                error(MAT_USAGE);
+            }
+            lhs = rhs = readArrayName(lexer);
+        } else {
+            lexer.unreadToken();
+            op = MAT_COPY;
+            lhs = rhs = readArrayName(lexer);
+            if (lexer.hasMoreTokens()) {
+                token = lexer.nextToken();
+                if (isOperator(token, '+')) {
+                    op = MAT_ADD;
+                } else if (isOperator(token, '-')) {
+                    op = MAT_SUB;
+                } else if (isOperator(token, '*')) {
+                    op = MAT_MUL;
+                } else {
+                    error(MAT_USAGE);
+                }
+                rhs = readArrayName(lexer);
+            }
+        }
+    }
+    if (lexer.hasMoreTokens()) {
+        error("Extraneous token " + lexer.getText(lexer.nextToken()));
+    }
+}
 
+MatStmt::~MatStmt() {
+    /* Empty */
+}
 
+void MatStmt::execute(EvalState & state) {
+    int k = (scalar == NULL) ? 0 : scalar->eval(state);
+    executeMat(op, destSlot, lhsSlot, rhsSlot, k, state);
+}
 
+StatementType MatStmt::getType() {
+    return MAT_STMT;
+}
 
+MatOperation MatStmt::getOperation() {
+    return op;
+}
 
+string MatStmt::getDest() {
+    return dest;
+}
 
+string MatStmt::getLHS() {
+    return lhs;
+}
+
+string MatStmt::getRHS() {
+    return rhs;
+}
+
+Expression *MatStmt::getScalar() {
+    return scalar;
+}
+
+void MatStmt::setScalar(Expression *scalar) {
+    this->scalar = scalar;
+}
+
+void MatStmt::setSlots(int dest, int lhs, int rhs) {
+    destSlot = dest;
+    lhsSlot = lhs;
+    rhsSlot = rhs;
+}
 
+int MatStmt::getDestSlot() {
+    return destSlot;
+}
+
+int MatStmt::getLHSSlot() {
+    return lhsSlot;
+}
+
+int MatStmt::getRHSSlot() {
+    return rhsSlot;
+}
+
+
+/*
+ * Implementation notes: DataStmt
+ * ------------------------------
+ * The lexer has no negative numbers, so a minus sign before a constant
+ * is read as part of it here.
+ */
+
+DataStmt::DataStmt(Lexer & lexer, Arena & arena){
+    while (true) {
+        Token token = lexer.nextToken();
+        bool negative = isOperator(token, '-');
+        if (negative) token = lexer.nextToken();
+        if (token.kind != TOKEN_NUMBER || !token.isInteger) {
+            error("Improper DATA statement. Enter line in the form of DATA n, n, ...");
+        }
+        values.push_back(negative ? 0 - token.value : token.value);
+        if (!lexer.hasMoreTokens()) break;
+        if (!isOperator(lexer.nextToken(), ',')) {
+            error("Improper DATA statement. Enter line in the form of DATA n, n, ...");
+        }
+    }
+}
+
+DataStmt::~DataStmt() {
+    /* Empty */
+}
+
+void DataStmt::execute(EvalState & state) {
+    /* Empty */
+}
+
+StatementType DataStmt::getType() {
+    return DATA_STMT;
+}
+
+const vector<int> & DataStmt::getValues() {
+    return values;
+}
+
+
+/*
+ * Implementation notes: EndStmt
+ * -----------------------------
+ * The EndStmt subclass stops the program by clearing the statement
+ * that would otherwise execute next.
+ */
+
+EndStmt::EndStmt(Lexer & lexer, Arena & arena){
+    if (lexer.hasMoreTokens()) {
+        error("Extraneous token " + lexer.getText(lexer.nextToken()));
+    }
+}
+
+EndStmt::~EndStmt() {
+    /* Empty */
+}
+
+void EndStmt::execute(EvalState & state) {
+    state.setNextStatement(NULL);
+}
+
+StatementType EndStmt::getType() {
+    return END_STMT;
+}
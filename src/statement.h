@@ -12,9 +12,58 @@
 #ifndef _statement_h
 #define _statement_h
 
+#include <vector>
 #include "evalstate.h"
+#include "arena.h"
 #include "exp.h"
-#include "tokenscanner.h"
+#include "lexer.h"
+#include "matrix.h"
+#include "value.h"
+
+/*
+ * Type: StatementType
+ * -------------------
+ * This enumerated type is used to differentiate the statement
+ * subclasses so that passes over the program, such as the bytecode
+ * compiler, can inspect a statement without calling execute.
+ */
+
+enum StatementType {
+   REM_STMT, LET_STMT, PRINT_STMT, INPUT_STMT, GOTO_STMT, IF_STMT, END_STMT,
+   FOR_STMT, NEXT_STMT, GOSUB_STMT, RETURN_STMT, DIM_STMT, MAT_STMT, DATA_STMT
+};
+
+/*
+ * Type: LoopControl
+ * -----------------
+ * This structure holds the loop control block of a FOR loop: the
+ * EvalState slots of the counter variable and of the two hidden
+ * variables in which FOR stores the limit and the step once they have
+ * been evaluated.  The hidden variables are named after the counter
+ * with a suffix that no BASIC identifier can contain, so the FOR and
+ * NEXT of a loop find the same slots without consulting each other.
+ */
+
+struct LoopControl {
+   int counter;
+   int limit;
+   int step;
+};
+
+/*
+ * Function: loopContinues
+ * Usage: if (loopContinues(value, limit, step)) . . .
+ * ---------------------------------------------------
+ * Returns true if a loop whose counter has reached value runs its body
+ * again, which is the case while the counter has not passed the limit
+ * in the direction of the step.  A step of zero counts upward.  NEXT
+ * passes the sum of the counter and step without wrapping it, so that
+ * a loop whose limit is near the end of the integer range still ends.
+ */
+
+inline bool loopContinues(long long value, int limit, int step) {
+   return (step >= 0) ? value <= limit : value >= limit;
+}
 
 /*
  * Class: Statement
@@ -41,11 +90,11 @@ public:
 
 /*
  * Destructor: ~Statement
- * Usage: delete stmt;
- * -------------------
- * The destructor deallocates the storage for this expression.
- * It must be declared virtual to ensure that the correct subclass
- * destructor is called when deleting a statement.
+ * Usage: usually implicit
+ * -----------------------
+ * Statements are created in an Arena, which runs the destructor when
+ * it is cleared.  A statement does not free its expressions, which
+ * belong to the same arena.
  */
 
    virtual ~Statement();
@@ -63,6 +112,33 @@ public:
 
    virtual void execute(EvalState & state) = 0;
 
+/*
+ * Method: getType
+ * Usage: StatementType type = stmt->getType();
+ * --------------------------------------------
+ * Returns the type of the statement, which identifies the subclass
+ * to which the statement belongs.
+ */
+
+   virtual StatementType getType() = 0;
+
+/*
+ * Methods: setNext, getNext
+ * Usage: stmt->setNext(successor);
+ *        Statement *successor = stmt->getNext();
+ * ----------------------------------------------
+ * These methods record and return the statement on the following
+ * line of the program, which Program::link fills in before a run.
+ * The last statement in the program has no successor.
+ */
+
+   void setNext(Statement *stmt);
+   Statement *getNext();
+
+private:
+
+   Statement *next;
+
 };
 
 
@@ -79,19 +155,17 @@ public:
 
 /*
  * Constructor: RemStmt
- * Usage: Expression *exp = new RemStmt(scanner)
- * ----------------------------------
+ * Usage: Statement *stmt = arena.make<RemStmt>(lexer, arena);
+ * -----------------------------------------------------------
  *
  */
 
-    RemStmt(TokenScanner & scanner);
+    RemStmt(Lexer & lexer, Arena & arena);
 
 /* Prototypes for the virtual methods overridden by this class */
     virtual ~RemStmt();
     virtual void execute(EvalState & state);
-
-private:
-    Expression *exp;
+    virtual StatementType getType();
 };
 
 
@@ -100,6 +174,8 @@ private:
  * ----------------------
  * This subclass stores the value exp in the variable on the right hand side
  * of the equal sign to the symbolMap associated with the EvalState Class.
+ * The variable may also be an element of an array.  The value is
+ * converted to the kind of the variable, which its suffix decides.
  */
 
 class LetStmt : public Statement {
@@ -108,28 +184,70 @@ public:
 
 /*
  * Constructor: LetStmt
- * Usage: Expression *exp = new LetStmt(scanner)
- * ----------------------------------
+ * Usage: Statement *stmt = arena.make<LetStmt>(lexer, arena);
+ * -----------------------------------------------------------
  *
  */
 
-    LetStmt(TokenScanner & scanner);
+    LetStmt(Lexer & lexer, Arena & arena);
 
 /* Prototypes for the virtual methods overridden by this class */
 
     virtual ~LetStmt();
     virtual void execute(EvalState & state);
+    virtual StatementType getType();
+
+/*
+ * Methods: getVar, getExp, setExp
+ * Usage: string var = ((LetStmt *) stmt)->getVar();
+ *        Expression *exp = ((LetStmt *) stmt)->getExp();
+ *        ((LetStmt *) stmt)->setExp(exp);
+ * -------------------------------------------------------
+ * These methods return the components of a LET statement.  The setExp
+ * method replaces the expression without freeing the old one, so that
+ * an optimization pass can reuse its parts.
+ */
+
+    std::string getVar();
+    Expression *getExp();
+    void setExp(Expression *exp);
+
+/*
+ * Methods: setSlot, getSlot
+ * Usage: ((LetStmt *) stmt)->setSlot(state.getSlot(var));
+ * -------------------------------------------------------
+ * These methods record and return the EvalState slot assigned to
+ * the variable on the left of the equal sign.
+ */
+
+    void setSlot(int slot);
+    int getSlot();
+
+/*
+ * Method: getElement
+ * Usage: ArrayExp *element = ((LetStmt *) stmt)->getElement();
+ * ------------------------------------------------------------
+ * Returns the array element on the left of the equal sign, or NULL if
+ * the statement assigns a simple variable.  The element has its own
+ * slot, and the slot of the statement is not used.
+ */
+
+    ArrayExp *getElement();
 
 private:
     Expression *exp;
+    ArrayExp *element;
     std::string var;
+    ValueKind kind;
+    int slot;
 };
 
 
 /*
  * SubClass: PrintStmt
  * ----------------------
- * This subclass prints an expression to the console
+ * This subclass prints an expression to the console in the form that
+ * suits its kind.
  */
 
 class PrintStmt : public Statement {
@@ -138,17 +256,30 @@ public:
 
 /*
  *  Constructor: PrintStmt
- *  Usage: Expression *exp = new PrintStmt(scanner)
- *  ----------------------------------------------
+ *  Usage: Statement *stmt = arena.make<PrintStmt>(lexer, arena);
+ * -------------------------------------------------------------
  *  Prints the value exp to the console
  */
 
-    PrintStmt(TokenScanner & scanner);
+    PrintStmt(Lexer & lexer, Arena & arena);
 
 
 /*  Prototypes for the virtual methods overridden by this class */
     virtual ~PrintStmt();
     virtual void execute(EvalState & state);
+    virtual StatementType getType();
+
+/*
+ * Methods: getExp, setExp
+ * Usage: Expression *exp = ((PrintStmt *) stmt)->getExp();
+ *        ((PrintStmt *) stmt)->setExp(exp);
+ * --------------------------------------------------------
+ * These methods return and replace the expression printed by this
+ * statement.  As with LetStmt, setExp does not free the old one.
+ */
+
+    Expression *getExp();
+    void setExp(Expression *exp);
 
 private:
     Expression *exp;
@@ -168,22 +299,43 @@ public:
 
 /*
  * Constructor: InputStmt
- * Usage: Expression *exp = new InputStmt(scanner)
- * ----------------------------------
+ * Usage: Statement *stmt = arena.make<InputStmt>(lexer, arena);
+ * -------------------------------------------------------------
  * Stores the value exp in EvalState's symbol map. The client of the program
  * must enter a variable name.
  */
 
-    InputStmt(TokenScanner & scanner);
+    InputStmt(Lexer & lexer, Arena & arena);
 
 /* Prototypes for the virtual methods overridden by this class */
     virtual ~InputStmt();
     virtual void execute(EvalState & state);
+    virtual StatementType getType();
+
+/*
+ * Method: getVar
+ * Usage: string var = ((InputStmt *) stmt)->getVar();
+ * ---------------------------------------------------
+ * Returns the name of the variable read by this statement.
+ */
+
+    std::string getVar();
+
+/*
+ * Methods: setSlot, getSlot
+ * Usage: ((InputStmt *) stmt)->setSlot(state.getSlot(var));
+ * ---------------------------------------------------------
+ * These methods record and return the EvalState slot assigned to
+ * the variable read by this statement.
+ */
+
+    void setSlot(int slot);
+    int getSlot();
 
 private:
-    Expression *exp;
     int value;
     std::string var;
+    int slot;
 };
 
 
@@ -204,15 +356,36 @@ public:
  *
  */
 
-    GotoStmt(TokenScanner & scanner);
+    GotoStmt(Lexer & lexer, Arena & arena);
 
 /* Prototypes for the virtual methods overridden by this class */
     virtual ~GotoStmt();
     virtual void execute(EvalState & state);
+    virtual StatementType getType();
+
+/*
+ * Method: getLineNumber
+ * Usage: int target = ((GotoStmt *) stmt)->getLineNumber();
+ * ---------------------------------------------------------
+ * Returns the line number to which this statement transfers control.
+ */
+
+    int getLineNumber();
+
+/*
+ * Methods: setTarget, getTarget
+ * Usage: ((GotoStmt *) stmt)->setTarget(program.getParsedStatement(n));
+ * ---------------------------------------------------------------------
+ * These methods record and return the statement on the target line,
+ * which Program::link fills in so that execute needs no lookup.
+ */
+
+    void setTarget(Statement *stmt);
+    Statement *getTarget();
 
 private:
     int lineNumber;
-    Expression *exp;
+    Statement *target;
 };
 
 
@@ -234,17 +407,486 @@ public:
  * ----------------------------------
  *
  */
-    IfStmt(TokenScanner & scanner);
+    IfStmt(Lexer & lexer, Arena & arena);
 
 /* Prototypes for the virtual methods overridden by this class */
     virtual ~IfStmt();
     virtual void execute(EvalState & state);
+    virtual StatementType getType();
+
+/*
+ * Methods: getLHS, getOp, getRHS, getLineNumber
+ * Usage: Expression *lhs = ((IfStmt *) stmt)->getLHS();
+ *        OperatorType op = ((IfStmt *) stmt)->getOp();
+ *        Expression *rhs = ((IfStmt *) stmt)->getRHS();
+ *        int target = ((IfStmt *) stmt)->getLineNumber();
+ * -------------------------------------------------------
+ * These methods return the components of an IF statement.  The
+ * operator is always one of EQUAL_OP, LESS_OP or GREATER_OP.
+ */
+
+    Expression *getLHS();
+    OperatorType getOp();
+    Expression *getRHS();
+    int getLineNumber();
+
+/*
+ * Methods: setLHS, setRHS
+ * Usage: ((IfStmt *) stmt)->setLHS(lhs);
+ *        ((IfStmt *) stmt)->setRHS(rhs);
+ * -------------------------------------
+ * These methods replace the expressions on either side of the
+ * comparison.  As with LetStmt, the old expressions are not freed.
+ */
+
+    void setLHS(Expression *lhs);
+    void setRHS(Expression *rhs);
+
+/*
+ * Method: getKind
+ * Usage: ValueKind kind = ((IfStmt *) stmt)->getKind();
+ * -----------------------------------------------------
+ * Returns the kind in which the two sides are compared, which is the
+ * wider of their kinds.
+ */
+
+    ValueKind getKind();
+
+/*
+ * Methods: setTarget, getTarget
+ * Usage: ((IfStmt *) stmt)->setTarget(program.getParsedStatement(n));
+ * -------------------------------------------------------------------
+ * These methods record and return the statement on the target line,
+ * which Program::link fills in so that execute needs no lookup.
+ */
+
+    void setTarget(Statement *stmt);
+    Statement *getTarget();
 
 private:
     Expression *expLhs;
     Expression *expRhs;
-    std::string op;
+    OperatorType op;
+    ValueKind kind;
     int lineNumber;
+    Statement *target;
+};
+
+
+/*
+ * SubClass: ForStmt
+ * ----------------------
+ * This subclass begins a counting loop.  It sets the counter to its
+ * starting value and stores the limit and step in the loop control
+ * block; if the counter is already past the limit, the body is skipped
+ * and control passes to the statement after the matching NEXT.
+ */
+
+class ForStmt : public Statement {
+
+public:
+
+/*
+ * Constructor: ForStmt
+ * Usage: Statement *stmt = arena.make<ForStmt>(lexer, arena);
+ * -----------------------------------------------------------
+ * Reads the rest of a statement of the form
+ *
+ *    FOR var = start TO limit [STEP step]
+ *
+ * in which the step is 1 if it is omitted.
+ */
+
+    ForStmt(Lexer & lexer, Arena & arena);
+
+/* Prototypes for the virtual methods overridden by this class */
+    virtual ~ForStmt();
+    virtual void execute(EvalState & state);
+    virtual StatementType getType();
+
+/*
+ * Methods: getVar, getStart, getLimit, getStep
+ * Usage: string var = ((ForStmt *) stmt)->getVar();
+ *        Expression *start = ((ForStmt *) stmt)->getStart();
+ *        Expression *limit = ((ForStmt *) stmt)->getLimit();
+ *        Expression *step = ((ForStmt *) stmt)->getStep();
+ * -------------------------------------------------------
+ * These methods return the components of a FOR statement.
+ */
+
+    std::string getVar();
+    Expression *getStart();
+    Expression *getLimit();
+    Expression *getStep();
+
+/*
+ * Methods: setStart, setLimit, setStep
+ * Usage: ((ForStmt *) stmt)->setStart(start);
+ * -------------------------------------------
+ * These methods replace the expressions of the statement.  As with
+ * LetStmt, the old expressions are not freed.
+ */
+
+    void setStart(Expression *start);
+    void setLimit(Expression *limit);
+    void setStep(Expression *step);
+
+/*
+ * Methods: setControl, getControl
+ * Usage: ((ForStmt *) stmt)->setControl(control);
+ * -----------------------------------------------
+ * These methods record and return the slots of the loop control block,
+ * which resolveSymbols assigns.
+ */
+
+    void setControl(const LoopControl & control);
+    const LoopControl & getControl();
+
+/*
+ * Methods: setLoopEnd, getLoopEnd, getLoopEndLine
+ * Usage: ((ForStmt *) stmt)->setLoopEnd(next, lineNumber);
+ * --------------------------------------------------------
+ * These methods record and return the matching NEXT statement and the
+ * number of its line, which Program::link fills in.
+ */
+
+    void setLoopEnd(Statement *stmt, int lineNumber);
+    Statement *getLoopEnd();
+    int getLoopEndLine();
+
+private:
+    std::string var;
+    Expression *start;
+    Expression *limit;
+    Expression *step;
+    LoopControl control;
+    Statement *loopEnd;
+    int loopEndLine;
+};
+
+
+/*
+ * SubClass: NextStmt
+ * ----------------------
+ * This subclass ends a counting loop.  It adds the step to the counter
+ * and, unless the counter has passed the limit, sends control back to
+ * the statement after the matching FOR.  Both values come from the loop
+ * control block, so each NEXT makes a single comparison.
+ */
+
+class NextStmt : public Statement {
+
+public:
+
+/*
+ * Constructor: NextStmt
+ * Usage: Statement *stmt = arena.make<NextStmt>(lexer, arena);
+ * ------------------------------------------------------------
+ * Reads the counter variable that follows NEXT.
+ */
+
+    NextStmt(Lexer & lexer, Arena & arena);
+
+/* Prototypes for the virtual methods overridden by this class */
+    virtual ~NextStmt();
+    virtual void execute(EvalState & state);
+    virtual StatementType getType();
+
+/*
+ * Method: getVar
+ * Usage: string var = ((NextStmt *) stmt)->getVar();
+ * --------------------------------------------------
+ * Returns the name of the counter variable.
+ */
+
+    std::string getVar();
+
+/*
+ * Methods: setControl, getControl
+ * Usage: ((NextStmt *) stmt)->setControl(control);
+ * ------------------------------------------------
+ * These methods record and return the slots of the loop control block,
+ * which resolveSymbols assigns.
+ */
+
+    void setControl(const LoopControl & control);
+    const LoopControl & getControl();
+
+/*
+ * Methods: setLoopStart, getLoopStart, getLoopStartLine
+ * Usage: ((NextStmt *) stmt)->setLoopStart(forStmt, lineNumber);
+ * --------------------------------------------------------------
+ * These methods record and return the matching FOR statement and the
+ * number of its line, which Program::link fills in.
+ */
+
+    void setLoopStart(Statement *stmt, int lineNumber);
+    Statement *getLoopStart();
+    int getLoopStartLine();
+
+private:
+    std::string var;
+    LoopControl control;
+    Statement *loopStart;
+    int loopStartLine;
+};
+
+
+/*
+ * SubClass: GosubStmt
+ * ----------------------
+ * This subclass calls a subroutine.  It pushes the statement that
+ * follows it onto the return stack in the EvalState and then transfers
+ * control to its target line exactly as GotoStmt does.
+ */
+
+class GosubStmt : public Statement {
+
+public:
+
+/*
+ * Constructor: GosubStmt
+ * Usage: Statement *stmt = arena.make<GosubStmt>(lexer, arena);
+ * -------------------------------------------------------------
+ * Reads the line number that follows GOSUB.
+ */
+
+    GosubStmt(Lexer & lexer, Arena & arena);
+
+/* Prototypes for the virtual methods overridden by this class */
+    virtual ~GosubStmt();
+    virtual void execute(EvalState & state);
+    virtual StatementType getType();
+
+/*
+ * Method: getLineNumber
+ * Usage: int target = ((GosubStmt *) stmt)->getLineNumber();
+ * ----------------------------------------------------------
+ * Returns the line number of the first line of the subroutine.
+ */
+
+    int getLineNumber();
+
+/*
+ * Methods: setTarget, getTarget
+ * Usage: ((GosubStmt *) stmt)->setTarget(program.getParsedStatement(n));
+ * ----------------------------------------------------------------------
+ * These methods record and return the statement on the target line,
+ * which Program::link fills in so that execute needs no lookup.
+ */
+
+    void setTarget(Statement *stmt);
+    Statement *getTarget();
+
+private:
+    int lineNumber;
+    Statement *target;
+};
+
+
+/*
+ * SubClass: ReturnStmt
+ * ----------------------
+ * This subclass returns from a subroutine by popping the statement
+ * that follows the most recent GOSUB from the return stack.
+ */
+
+class ReturnStmt : public Statement {
+
+public:
+
+/*
+ * Constructor: ReturnStmt
+ * Usage: Statement *stmt = arena.make<ReturnStmt>(lexer, arena);
+ * --------------------------------------------------------------
+ * Checks that nothing follows RETURN.
+ */
+
+    ReturnStmt(Lexer & lexer, Arena & arena);
+
+/* Prototypes for the virtual methods overridden by this class */
+    virtual ~ReturnStmt();
+    virtual void execute(EvalState & state);
+    virtual StatementType getType();
+};
+
+
+/*
+ * SubClass: DimStmt
+ * ----------------------
+ * This subclass dimensions an array.  DIM A(n) gives A the elements
+ * A(0) through A(n), and DIM A(n, m) gives it the elements A(i, j)
+ * for i from 0 to n and j from 0 to m.  The bounds must be integer
+ * constants, and every element starts out as zero.
+ */
+
+class DimStmt : public Statement {
+
+public:
+
+/*
+ * Constructor: DimStmt
+ * Usage: Statement *stmt = arena.make<DimStmt>(lexer, arena);
+ * -----------------------------------------------------------
+ * Reads the name of the array and its bounds, raising an error if a
+ * bound is not an integer constant or the array would be too large.
+ */
+
+    DimStmt(Lexer & lexer, Arena & arena);
+
+/* Prototypes for the virtual methods overridden by this class */
+    virtual ~DimStmt();
+    virtual void execute(EvalState & state);
+    virtual StatementType getType();
+
+/*
+ * Methods: getVar, getRows, getColumns
+ * Usage: string var = ((DimStmt *) stmt)->getVar();
+ *        int rows = ((DimStmt *) stmt)->getRows();
+ *        int columns = ((DimStmt *) stmt)->getColumns();
+ * -------------------------------------------------------
+ * These methods return the name of the array, the number of values
+ * its first subscript may take, and the number its second may take,
+ * which is zero if the array has only one subscript.
+ */
+
+    std::string getVar();
+    int getRows();
+    int getColumns();
+
+/*
+ * Methods: setSlot, getSlot
+ * Usage: ((DimStmt *) stmt)->setSlot(state.getArraySlot(var));
+ * ------------------------------------------------------------
+ * These methods record and return the EvalState slot of the array.
+ */
+
+    void setSlot(int slot);
+    int getSlot();
+
+private:
+    std::string var;
+    int rows;
+    int columns;
+    int slot;
+};
+
+
+/*
+ * SubClass: MatStmt
+ * ----------------------
+ * This subclass performs one of the whole-array operations listed in
+ * matrix.h, such as MAT C = A * B.  The arrays are named by C, A and B
+ * in the forms shown there; MAT READ and MAT PRINT name only C.
+ */
+
+class MatStmt : public Statement {
+
+public:
+
+/*
+ * Constructor: MatStmt
+ * Usage: Statement *stmt = arena.make<MatStmt>(lexer, arena);
+ * -----------------------------------------------------------
+ * Reads the rest of a MAT statement, raising an error if it is not in
+ * one of the forms of a MAT operation.
+ */
+
+    MatStmt(Lexer & lexer, Arena & arena);
+
+/* Prototypes for the virtual methods overridden by this class */
+    virtual ~MatStmt();
+    virtual void execute(EvalState & state);
+    virtual StatementType getType();
+
+/*
+ * Methods: getOperation, getDest, getLHS, getRHS
+ * Usage: MatOperation op = ((MatStmt *) stmt)->getOperation();
+ *        string dest = ((MatStmt *) stmt)->getDest();
+ * ------------------------------------------------------------
+ * These methods return the operation and the names of the arrays C, A
+ * and B.  An operation that uses fewer arrays repeats the last one it
+ * names, so that every name is always an array of the statement.
+ */
+
+    MatOperation getOperation();
+    std::string getDest();
+    std::string getLHS();
+    std::string getRHS();
+
+/*
+ * Methods: getScalar, setScalar
+ * Usage: Expression *scalar = ((MatStmt *) stmt)->getScalar();
+ * ------------------------------------------------------------
+ * These methods return and replace the expression k of MAT C = (k) * A,
+ * which is NULL for the other operations.
+ */
+
+    Expression *getScalar();
+    void setScalar(Expression *scalar);
+
+/*
+ * Methods: setSlots, getDestSlot, getLHSSlot, getRHSSlot
+ * Usage: ((MatStmt *) stmt)->setSlots(dest, lhs, rhs);
+ * ----------------------------------------------------
+ * These methods record and return the EvalState slots of the arrays.
+ */
+
+    void setSlots(int dest, int lhs, int rhs);
+    int getDestSlot();
+    int getLHSSlot();
+    int getRHSSlot();
+
+private:
+    MatOperation op;
+    std::string dest;
+    std::string lhs;
+    std::string rhs;
+    Expression *scalar;
+    int destSlot;
+    int lhsSlot;
+    int rhsSlot;
+};
+
+
+/*
+ * SubClass: DataStmt
+ * ----------------------
+ * This subclass holds the constants of a DATA statement, which MAT READ
+ * reads.  Executing the statement does nothing: a run collects the
+ * values of every DATA statement, in line order, before it begins.
+ */
+
+class DataStmt : public Statement {
+
+public:
+
+/*
+ * Constructor: DataStmt
+ * Usage: Statement *stmt = arena.make<DataStmt>(lexer, arena);
+ * ------------------------------------------------------------
+ * Reads a list of integer constants separated by commas, each of which
+ * may be preceded by a minus sign.
+ */
+
+    DataStmt(Lexer & lexer, Arena & arena);
+
+/* Prototypes for the virtual methods overridden by this class */
+    virtual ~DataStmt();
+    virtual void execute(EvalState & state);
+    virtual StatementType getType();
+
+/*
+ * Method: getValues
+ * Usage: const vector<int> & values = ((DataStmt *) stmt)->getValues();
+ * ---------------------------------------------------------------------
+ * Returns the constants of the statement.
+ */
+
+    const std::vector<int> & getValues();
+
+private:
+    std::vector<int> values;
 };
 
 
@@ -266,15 +908,12 @@ public:
  */
 
 
-    EndStmt(TokenScanner & scanner);
+    EndStmt(Lexer & lexer, Arena & arena);
 
 /* Prototypes for the virtual methods overridden by this class */
     virtual ~EndStmt();
     virtual void execute(EvalState & state);
-
-private:
-    int stopCondition;
-    Expression *exp;
+    virtual StatementType getType();
 };
 
 
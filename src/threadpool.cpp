@@ -0,0 +1,140 @@
+/*
+ * File: threadpool.cpp
+ * --------------------
+ * This file implements the ThreadPool class.
+ */
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "threadpool.h"
+using namespace std;
+
+static int defaultThreadCount() {
+   int n = thread::hardware_concurrency();
+   return (n > 0) ? n : 1;
+}
+
+ThreadPool::ThreadPool(int nThreads) :
+   queues((nThreads > 0) ? nThreads : defaultThreadCount()) {
+   task = NULL;
+   generation = 0;
+   busy = 0;
+   stopping = false;
+   for (size_t i = 0; i < queues.size(); i++) {
+      threads.push_back(thread(&ThreadPool::workerLoop, this, (int) i));
+   }
+}
+
+ThreadPool::~ThreadPool() {
+   {
+      lock_guard<mutex> guard(lock);
+      stopping = true;
+   }
+   wake.notify_all();
+   for (size_t i = 0; i < threads.size(); i++) {
+      threads[i].join();
+   }
+}
+
+int ThreadPool::getThreadCount() const {
+   return threads.size();
+}
+
+/*
+ * Implementation notes: run
+ * -------------------------
+ * The indices are dealt out in contiguous blocks, so that neighboring
+ * tasks, which callers often lay out next to one another in memory,
+ * tend to run on the same thread.  No task adds to the queues once the
+ * batch has started, so a worker that finds every queue empty has
+ * nothing more to do in this batch.
+ */
+
+void ThreadPool::run(int nTasks, const function<void(int)> & fn) {
+   if (nTasks <= 0) return;
+   int nQueues = queues.size();
+   for (int i = 0; i < nQueues; i++) {
+      int start = (long long) nTasks * i / nQueues;
+      int finish = (long long) nTasks * (i + 1) / nQueues;
+      lock_guard<mutex> guard(queues[i].lock);
+      for (int k = start; k < finish; k++) {
+         queues[i].tasks.push_back(k);
+      }
+   }
+   unique_lock<mutex> guard(lock);
+   task = &fn;
+   failure = exception_ptr();
+   busy = threads.size();
+   generation++;
+   wake.notify_all();
+   done.wait(guard, [this] { return busy == 0; });
+   task = NULL;
+   if (failure) {
+      exception_ptr ex = failure;
+      failure = exception_ptr();
+      rethrow_exception(ex);
+   }
+}
+
+void ThreadPool::workerLoop(int index) {
+   long seen = 0;
+   while (true) {
+      const function<void(int)> *fn;
+      {
+         unique_lock<mutex> guard(lock);
+         wake.wait(guard, [this, seen] { return stopping || generation != seen; });
+         if (stopping) return;
+         seen = generation;
+         fn = task;
+      }
+      int taskIndex;
+      while (takeTask(index, taskIndex)) {
+         try {
+            (*fn)(taskIndex);
+         } catch (...) {
+            lock_guard<mutex> guard(lock);
+            if (!failure) failure = current_exception();
+         }
+      }
+      lock_guard<mutex> guard(lock);
+      if (--busy == 0) done.notify_all();
+   }
+}
+
+/*
+ * Implementation notes: takeTask
+ * ------------------------------
+ * A worker takes its own tasks from the back of its queue and steals
+ * from the front of the others, so that an owner and a thief contend
+ * for the same index only when a single one remains.  Victims are
+ * tried in order starting from the next worker, which spreads the
+ * thieves of a busy batch across different queues.
+ */
+
+bool ThreadPool::takeTask(int index, int & taskIndex) {
+   int nQueues = queues.size();
+   {
+      TaskQueue & own = queues[index];
+      lock_guard<mutex> guard(own.lock);
+      if (!own.tasks.empty()) {
+         taskIndex = own.tasks.back();
+         own.tasks.pop_back();
+         return true;
+      }
+   }
+   for (int k = 1; k < nQueues; k++) {
+      TaskQueue & victim = queues[(index + k) % nQueues];
+      lock_guard<mutex> guard(victim.lock);
+      if (!victim.tasks.empty()) {
+         taskIndex = victim.tasks.front();
+         victim.tasks.pop_front();
+         return true;
+      }
+   }
+   return false;
+}
@@ -0,0 +1,114 @@
+/*
+ * File: threadpool.h
+ * ------------------
+ * This interface exports the ThreadPool class, which runs a batch of
+ * independent tasks on a fixed set of worker threads.
+ */
+
+#ifndef _threadpool_h
+#define _threadpool_h
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Class: ThreadPool
+ * -----------------
+ * This class keeps a set of worker threads that run batches of tasks,
+ * each identified by its index in the batch.  The pool schedules by
+ * work stealing: each worker starts with its own contiguous share of
+ * the indices, takes them from the back of its own queue, and, when
+ * that queue is empty, takes indices from the front of the queues of
+ * the other workers.  A batch of tasks whose costs differ widely is
+ * therefore still spread evenly across the threads, while each worker
+ * usually touches only its own queue.
+ */
+
+class ThreadPool {
+
+public:
+
+/*
+ * Constructor: ThreadPool
+ * Usage: ThreadPool pool;
+ *        ThreadPool pool(nThreads);
+ * ---------------------------------
+ * Creates a pool with the specified number of worker threads.  If
+ * nThreads is zero or omitted, the pool has one thread for each
+ * hardware thread of the machine.
+ */
+
+   explicit ThreadPool(int nThreads = 0);
+
+/*
+ * Destructor: ~ThreadPool
+ * Usage: usually implicit
+ * -----------------------
+ * Stops and joins the worker threads.
+ */
+
+   ~ThreadPool();
+
+/*
+ * Method: getThreadCount
+ * Usage: int n = pool.getThreadCount();
+ * -------------------------------------
+ * Returns the number of worker threads in the pool.
+ */
+
+   int getThreadCount() const;
+
+/*
+ * Method: run
+ * Usage: pool.run(nTasks, task);
+ * ------------------------------
+ * Calls task(i) for every i from 0 to nTasks - 1, spread across the
+ * worker threads, and returns when all the calls have finished.  The
+ * calls may run in any order and at the same time as one another.  If
+ * any call throws an exception, the remaining tasks still run, and the
+ * first exception is rethrown from run.  Only one thread at a time may
+ * call run on a given pool.
+ */
+
+   void run(int nTasks, const std::function<void(int)> & task);
+
+private:
+
+/* Type used for the queue of task indices that belongs to each worker */
+
+   struct TaskQueue {
+      std::mutex lock;
+      std::deque<int> tasks;
+   };
+
+/* Instance variables */
+
+   std::vector<std::thread> threads;    /* The worker threads             */
+   std::vector<TaskQueue> queues;       /* One queue for each worker      */
+   std::mutex lock;                     /* Guards the fields below        */
+   std::condition_variable wake;        /* Signals a new batch or a stop  */
+   std::condition_variable done;        /* Signals the end of a batch     */
+   const std::function<void(int)> *task;   /* The function for the batch  */
+   long generation;                     /* Number of batches started      */
+   int busy;                            /* Workers still in this batch    */
+   bool stopping;                       /* True when the pool is closing  */
+   std::exception_ptr failure;          /* First exception in this batch  */
+
+/* Private methods */
+
+   void workerLoop(int index);
+   bool takeTask(int index, int & taskIndex);
+
+/* Copying a pool of threads is not supported */
+
+   ThreadPool(const ThreadPool &);
+   ThreadPool & operator=(const ThreadPool &);
+
+};
+
+#endif
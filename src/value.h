@@ -0,0 +1,135 @@
+/*
+ * File: value.h
+ * -------------
+ * This interface exports the kinds of numeric value that a BASIC
+ * program can hold and the conversions between them.
+ */
+
+#ifndef _value_h
+#define _value_h
+
+#include <string>
+
+/*
+ * Type: ValueKind
+ * ---------------
+ * This enumerated type identifies the three kinds of value.  A variable
+ * whose name ends in % holds a 64-bit integer, one whose name ends in #
+ * holds a double, and any other variable holds a 32-bit integer, as
+ * every variable did before the suffixes existed.  The kinds are listed
+ * from narrowest to widest, so the kind of an operation on two values
+ * is simply the larger of their kinds.
+ */
+
+enum ValueKind { INT_VALUE, LONG_VALUE, DOUBLE_VALUE };
+
+/*
+ * Function: getNameKind
+ * Usage: ValueKind kind = getNameKind(name);
+ * ------------------------------------------
+ * Returns the kind of value held by the variable with the specified
+ * name, which is given by the last character of the name.
+ */
+
+inline ValueKind getNameKind(const std::string & name) {
+   char last = name.empty() ? '\0' : name[name.length() - 1];
+   return (last == '%') ? LONG_VALUE : (last == '#') ? DOUBLE_VALUE : INT_VALUE;
+}
+
+/*
+ * Function: widerKind
+ * Usage: ValueKind kind = widerKind(lhs, rhs);
+ * --------------------------------------------
+ * Returns the kind in which an operation on values of the two kinds is
+ * carried out.
+ */
+
+inline ValueKind widerKind(ValueKind lhs, ValueKind rhs) {
+   return (lhs > rhs) ? lhs : rhs;
+}
+
+/*
+ * Functions: longToInt, doubleToLong, doubleToInt
+ * Usage: int n = longToInt(value);
+ *        long long n = doubleToLong(value);
+ *        int n = doubleToInt(value);
+ * -----------------------------------------------
+ * These functions convert a value to a narrower kind, which happens
+ * when it is assigned to a variable of that kind or used where only an
+ * int is allowed, such as in a subscript.  A 64-bit integer keeps its
+ * low 32 bits, just as addInt and the other int operations below wrap
+ * around.  A double loses its fraction; one too large for a 64-bit
+ * integer gives the nearest 64-bit integer, and one that is not a
+ * number gives zero, since C++ leaves converting either undefined.
+ */
+
+inline int longToInt(long long value) {
+   return (int) (unsigned) (unsigned long long) value;
+}
+
+inline long long doubleToLong(double value) {
+   if (value != value) return 0;
+   if (value >= 9223372036854775807.0) return 9223372036854775807LL;
+   if (value <= -9223372036854775807.0) return -9223372036854775807LL - 1;
+   return (long long) value;
+}
+
+inline int doubleToInt(double value) {
+   return longToInt(doubleToLong(value));
+}
+
+/*
+ * Functions: addInt, subtractInt, multiplyInt, divideInt
+ * Usage: int sum = addInt(lhs, rhs);
+ * ----------------------------------
+ * These functions perform int arithmetic that wraps around on
+ * overflow.  The arithmetic is done on unsigned values, whose overflow
+ * is defined, since overflow on signed values is undefined in C++.
+ * The processor traps the one quotient that overflows, the most
+ * negative int divided by -1, so divideInt treats a divisor of -1 as a
+ * negation, which gives the most negative int itself.  The divisor of
+ * divideInt must not be zero.
+ */
+
+inline int addInt(int lhs, int rhs) {
+   return (int) ((unsigned) lhs + (unsigned) rhs);
+}
+
+inline int subtractInt(int lhs, int rhs) {
+   return (int) ((unsigned) lhs - (unsigned) rhs);
+}
+
+inline int multiplyInt(int lhs, int rhs) {
+   return (int) ((unsigned) lhs * (unsigned) rhs);
+}
+
+inline int divideInt(int lhs, int rhs) {
+   return (rhs == -1) ? subtractInt(0, lhs) : lhs / rhs;
+}
+
+/*
+ * Functions: addLong, subtractLong, multiplyLong, divideLong
+ * Usage: long long sum = addLong(lhs, rhs);
+ * -----------------------------------------
+ * These functions perform 64-bit integer arithmetic that wraps around
+ * on overflow, as the arithmetic on ints does, rather than leaving the
+ * result undefined.  The divisor of divideLong must not be zero.
+ */
+
+inline long long addLong(long long lhs, long long rhs) {
+   return (long long) ((unsigned long long) lhs + (unsigned long long) rhs);
+}
+
+inline long long subtractLong(long long lhs, long long rhs) {
+   return (long long) ((unsigned long long) lhs - (unsigned long long) rhs);
+}
+
+inline long long multiplyLong(long long lhs, long long rhs) {
+   return (long long) ((unsigned long long) lhs * (unsigned long long) rhs);
+}
+
+inline long long divideLong(long long lhs, long long rhs) {
+   return (rhs == -1) ? subtractLong(0, lhs) : lhs / rhs;
+}
+
+#endif
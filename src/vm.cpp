@@ -0,0 +1,534 @@
+/*
+ * File: vm.cpp
+ * ------------
+ * This file implements the dispatch loop of the BASIC virtual machine.
+ */
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include "bytecode.h"
+#include "error.h"
+#include "evalstate.h"
+#include "matrix.h"
+#include "profiler.h"
+#include "value.h"
+#include "vm.h"
+using namespace std;
+
+/*
+ * Implementation notes: dispatch
+ * ------------------------------
+ * When the compiler supports it, the loop uses GCC's computed-goto
+ * extension: every handler ends by jumping straight to the handler of
+ * the next instruction, which gives each handler its own indirect
+ * branch and avoids the bounds check that a switch performs.  Other
+ * compilers get an ordinary switch inside a loop.  The macros below
+ * hide the difference so that each handler is written only once.
+ *
+ * The loop is a template whose parameter says whether the run is being
+ * profiled.  In the profiled instantiation, VM_NEXT reports every
+ * instruction address to the Profiler before dispatching; in the
+ * ordinary one the test is a compile-time constant and disappears, so
+ * a run without profiling executes exactly the same code as before.
+ */
+
+#if defined(__GNUC__)
+#  define VM_COMPUTED_GOTO
+#endif
+
+#define VM_PROFILE() if (PROFILE) profiler->enter(pc)
+
+#define VM_SLICE()                                                      \
+   if (SLICED && starts[pc]) {                                          \
+      if (budget == 0) {                                                \
+         slice->pc = pc;                                                \
+         slice->budget = 0;                                             \
+         return VM_YIELDED;                                             \
+      }                                                                 \
+      budget--;                                                         \
+   }
+
+#ifdef VM_COMPUTED_GOTO
+#  define VM_CASE(op) L_##op:
+#  define VM_NEXT() do { VM_PROFILE(); VM_SLICE(); goto *dispatch[code[pc]]; } while (false)
+#  define VM_LOOP() VM_NEXT();
+#  define VM_LOOP_END()
+#else
+#  define VM_CASE(op) case op:
+#  define VM_NEXT() continue
+#  define VM_LOOP() while (true) { VM_PROFILE(); VM_SLICE(); switch (code[pc]) {
+#  define VM_LOOP_END() } }
+#endif
+
+/*
+ * Implementation notes: sliced runs
+ * ---------------------------------
+ * The second template parameter selects the version of the loop used
+ * by executeSlice.  Before dispatching an instruction that begins a
+ * statement, that version charges the statement to the budget, and
+ * returns instead if the budget is spent.  Because the operand stack
+ * is empty at every statement boundary, the only state to save is the
+ * address.  An INPUT statement with no value to read returns its charge
+ * to the budget before suspending, so that it is charged only once,
+ * when it finally runs.  As with profiling, the instantiations used by
+ * executeBytecode contain none of this code.
+ *
+ * A return address is a pointer to the instruction after the GOSUB,
+ * so RETURN converts it back to an address with one subtraction.  The
+ * return stack lives in the EvalState, which keeps it across slices;
+ * Interpreter empties it when a sliced run begins, and run does so for
+ * every other run.
+ */
+
+/*
+ * Constant: LOCAL_STACK_SIZE
+ * --------------------------
+ * The size of the operand stack that the loop allocates in its own
+ * frame.  Only programs whose expressions are nested more deeply than
+ * this need a stack on the heap, which keeps the cost of starting a
+ * run, and in particular of each slice of a sliced run, low.
+ */
+
+static const int LOCAL_STACK_SIZE = 64;
+
+/*
+ * Implementation notes: wide values
+ * ---------------------------------
+ * A 64-bit integer or double occupies two words of the operand stack,
+ * which need not be aligned for it, so it is read and written with
+ * memcpy, which the compiler turns into a single unaligned move.
+ */
+
+template <typename T>
+static inline T peek(const int *sp) {
+   T value;
+   memcpy(&value, sp, sizeof value);
+   return value;
+}
+
+template <typename T>
+static inline void poke(int *sp, T value) {
+   memcpy(sp, &value, sizeof value);
+}
+
+#define VM_WIDE_BINARY(T, expression)                                  \
+   {                                                                    \
+      sp -= 2;                                                          \
+      T lhs = peek<T>(sp - 2);                                          \
+      T rhs = peek<T>(sp);                                              \
+      poke<T>(sp - 2, expression);                                      \
+      pc++;                                                             \
+      VM_NEXT();                                                        \
+   }
+
+#define VM_WIDE_JUMP(T, condition)                                     \
+   {                                                                    \
+      sp -= 4;                                                          \
+      T lhs = peek<T>(sp);                                              \
+      T rhs = peek<T>(sp + 2);                                          \
+      pc = (condition) ? code[pc + 1] : pc + 2;                         \
+      VM_NEXT();                                                        \
+   }
+
+template <bool PROFILE, bool SLICED>
+static VMStatus run(const Bytecode & bytecode, EvalState & state,
+                    Profiler *profiler, VMSlice *slice) {
+   const int *code = bytecode.getCode();
+   if (code == NULL) return VM_FINISHED;
+   const unsigned char *starts = bytecode.getStatementStarts();
+   int localStack[LOCAL_STACK_SIZE];
+   vector<int> stackStorage;
+   int *sp = localStack;
+   if (bytecode.getMaxStack() >= LOCAL_STACK_SIZE) {
+      stackStorage.resize(bytecode.getMaxStack() + 1);
+      sp = &stackStorage[0];
+   }
+   if (!SLICED) state.clearReturns();
+   int pc = SLICED ? slice->pc : 0;
+   int budget = SLICED ? slice->budget : 0;
+   OutputBuffer & out = state.getOutput();
+
+#ifdef VM_COMPUTED_GOTO
+   static void *dispatch[OP_COUNT] = {
+      &&L_OP_PUSH, &&L_OP_LOAD, &&L_OP_STORE, &&L_OP_ADD, &&L_OP_SUB,
+      &&L_OP_MUL, &&L_OP_DIV, &&L_OP_DUP, &&L_OP_POP, &&L_OP_PRINT,
+      &&L_OP_INPUT, &&L_OP_JUMP, &&L_OP_JUMP_EQ, &&L_OP_JUMP_GT,
+      &&L_OP_JUMP_LT, &&L_OP_END, &&L_OP_FOR, &&L_OP_NEXT,
+      &&L_OP_GOSUB, &&L_OP_RETURN, &&L_OP_DIM, &&L_OP_INDEX,
+      &&L_OP_INDEX2, &&L_OP_LOAD_ELEMENT, &&L_OP_STORE_ELEMENT, &&L_OP_MAT,
+      &&L_OP_MAT_SCALE, &&L_OP_RESTORE, &&L_OP_DATA, &&L_OP_PUSH2,
+      &&L_OP_LOAD_LONG, &&L_OP_LOAD_DOUBLE, &&L_OP_STORE_LONG,
+      &&L_OP_STORE_DOUBLE, &&L_OP_ADD_LONG, &&L_OP_SUB_LONG, &&L_OP_MUL_LONG,
+      &&L_OP_DIV_LONG, &&L_OP_ADD_DOUBLE, &&L_OP_SUB_DOUBLE,
+      &&L_OP_MUL_DOUBLE, &&L_OP_DIV_DOUBLE, &&L_OP_PRINT_LONG,
+      &&L_OP_PRINT_DOUBLE, &&L_OP_JUMP_EQ_LONG, &&L_OP_JUMP_GT_LONG,
+      &&L_OP_JUMP_LT_LONG, &&L_OP_JUMP_EQ_DOUBLE, &&L_OP_JUMP_GT_DOUBLE,
+      &&L_OP_JUMP_LT_DOUBLE, &&L_OP_INT_TO_LONG, &&L_OP_INT_TO_DOUBLE,
+      &&L_OP_LONG_TO_INT, &&L_OP_LONG_TO_DOUBLE, &&L_OP_DOUBLE_TO_INT,
+      &&L_OP_DOUBLE_TO_LONG
+   };
+#endif
+
+   VM_LOOP()
+
+   VM_CASE(OP_PUSH) {
+      *sp++ = code[pc + 1];
+      pc += 2;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_LOAD) {
+      int slot = code[pc + 1];
+      if (!state.isDefined(slot)) error(state.getName(slot) + " is undefined");
+      *sp++ = state.getValue(slot);
+      pc += 2;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_STORE) {
+      state.setValue(code[pc + 1], *--sp);
+      pc += 2;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_ADD) {
+      sp--;
+      sp[-1] = addInt(sp[-1], sp[0]);
+      pc++;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_SUB) {
+      sp--;
+      sp[-1] = subtractInt(sp[-1], sp[0]);
+      pc++;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_MUL) {
+      sp--;
+      sp[-1] = multiplyInt(sp[-1], sp[0]);
+      pc++;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_DIV) {
+      sp--;
+      if (sp[0] == 0) error("Division by zero");
+      sp[-1] = divideInt(sp[-1], sp[0]);
+      pc++;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_DUP) {
+      sp[0] = sp[-1];
+      sp++;
+      pc++;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_POP) {
+      sp--;
+      pc++;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_PRINT) {
+      out.printInteger(*--sp);
+      pc++;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_INPUT) {
+      if (SLICED && slice->hasInput) {
+         slice->hasInput = false;
+         state.setValue(code[pc + 1], slice->inputValue);
+      } else if (SLICED && !state.hasInputStream()) {
+         out.flush();
+         if (starts[pc]) budget++;
+         slice->pc = pc;
+         slice->budget = budget;
+         return VM_BLOCKED;
+      } else {
+         state.setValue(code[pc + 1], state.readInput());
+      }
+      pc += 2;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_JUMP) {
+      pc = code[pc + 1];
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_JUMP_EQ) {
+      sp -= 2;
+      pc = (sp[0] == sp[1]) ? code[pc + 1] : pc + 2;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_JUMP_GT) {
+      sp -= 2;
+      pc = (sp[0] > sp[1]) ? code[pc + 1] : pc + 2;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_JUMP_LT) {
+      sp -= 2;
+      pc = (sp[0] < sp[1]) ? code[pc + 1] : pc + 2;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_FOR) {
+      sp -= 3;
+      state.setValue(code[pc + 1], sp[0]);
+      state.setValue(code[pc + 2], sp[1]);
+      state.setValue(code[pc + 3], sp[2]);
+      pc = loopContinues(sp[0], sp[1], sp[2]) ? pc + 5 : code[pc + 4];
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_NEXT) {
+      int step = code[pc + 3];
+      if (!state.isDefined(step)) error("NEXT without FOR");
+      int stepValue = state.getValue(step);
+      long long value = (long long) state.getValue(code[pc + 1]) + stepValue;
+      state.setValue(code[pc + 1], (int) value);
+      pc = loopContinues(value, state.getValue(code[pc + 2]), stepValue) ? code[pc + 4] : pc + 5;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_GOSUB) {
+      state.pushReturn(code + pc + 2);
+      pc = code[pc + 1];
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_RETURN) {
+      pc = (const int *) state.popReturn() - code;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_DIM) {
+      state.dimension(code[pc + 1], code[pc + 2], code[pc + 3]);
+      pc += 4;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_INDEX) {
+      state.checkIndex(code[pc + 1], sp[-1]);
+      pc += 2;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_INDEX2) {
+      sp--;
+      sp[-1] = state.checkIndex(code[pc + 1], sp[-1], sp[0]);
+      pc += 2;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_LOAD_ELEMENT) {
+      sp[-1] = state.getElement(code[pc + 1], sp[-1]);
+      pc += 2;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_STORE_ELEMENT) {
+      sp -= 2;
+      state.setElement(code[pc + 1], sp[0], sp[1]);
+      pc += 2;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_MAT) {
+      executeMat(MatOperation(code[pc + 1]), code[pc + 2], code[pc + 3], code[pc + 4], 0, state);
+      pc += 5;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_MAT_SCALE) {
+      executeMat(MAT_SCALE, code[pc + 1], code[pc + 2], code[pc + 2], *--sp, state);
+      pc += 3;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_RESTORE) {
+      pc = restoreData(code, pc, state);
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_DATA) {
+      pc += 2;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_PUSH2) {
+      sp[0] = code[pc + 1];
+      sp[1] = code[pc + 2];
+      sp += 2;
+      pc += 3;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_LOAD_LONG) {
+      int slot = code[pc + 1];
+      if (!state.isDefined(slot)) error(state.getName(slot) + " is undefined");
+      poke(sp, state.getLong(slot));
+      sp += 2;
+      pc += 2;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_LOAD_DOUBLE) {
+      int slot = code[pc + 1];
+      if (!state.isDefined(slot)) error(state.getName(slot) + " is undefined");
+      poke(sp, state.getDouble(slot));
+      sp += 2;
+      pc += 2;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_STORE_LONG) {
+      sp -= 2;
+      state.setLong(code[pc + 1], peek<long long>(sp));
+      pc += 2;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_STORE_DOUBLE) {
+      sp -= 2;
+      state.setDouble(code[pc + 1], peek<double>(sp));
+      pc += 2;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_ADD_LONG) VM_WIDE_BINARY(long long, addLong(lhs, rhs))
+   VM_CASE(OP_SUB_LONG) VM_WIDE_BINARY(long long, subtractLong(lhs, rhs))
+   VM_CASE(OP_MUL_LONG) VM_WIDE_BINARY(long long, multiplyLong(lhs, rhs))
+
+   VM_CASE(OP_DIV_LONG) {
+      if (peek<long long>(sp - 2) == 0) error("Division by zero");
+      VM_WIDE_BINARY(long long, divideLong(lhs, rhs))
+   }
+
+   VM_CASE(OP_ADD_DOUBLE) VM_WIDE_BINARY(double, lhs + rhs)
+   VM_CASE(OP_SUB_DOUBLE) VM_WIDE_BINARY(double, lhs - rhs)
+   VM_CASE(OP_MUL_DOUBLE) VM_WIDE_BINARY(double, lhs * rhs)
+
+   VM_CASE(OP_DIV_DOUBLE) {
+      if (peek<double>(sp - 2) == 0) error("Division by zero");
+      VM_WIDE_BINARY(double, lhs / rhs)
+   }
+
+   VM_CASE(OP_PRINT_LONG) {
+      sp -= 2;
+      out.printLong(peek<long long>(sp));
+      pc++;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_PRINT_DOUBLE) {
+      sp -= 2;
+      out.printDouble(peek<double>(sp));
+      pc++;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_JUMP_EQ_LONG) VM_WIDE_JUMP(long long, lhs == rhs)
+   VM_CASE(OP_JUMP_GT_LONG) VM_WIDE_JUMP(long long, lhs > rhs)
+   VM_CASE(OP_JUMP_LT_LONG) VM_WIDE_JUMP(long long, lhs < rhs)
+   VM_CASE(OP_JUMP_EQ_DOUBLE) VM_WIDE_JUMP(double, lhs == rhs)
+   VM_CASE(OP_JUMP_GT_DOUBLE) VM_WIDE_JUMP(double, lhs > rhs)
+   VM_CASE(OP_JUMP_LT_DOUBLE) VM_WIDE_JUMP(double, lhs < rhs)
+
+   VM_CASE(OP_INT_TO_LONG) {
+      poke<long long>(sp - 1, sp[-1]);
+      sp++;
+      pc++;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_INT_TO_DOUBLE) {
+      poke<double>(sp - 1, sp[-1]);
+      sp++;
+      pc++;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_LONG_TO_INT) {
+      sp--;
+      sp[-1] = longToInt(peek<long long>(sp - 1));
+      pc++;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_LONG_TO_DOUBLE) {
+      poke<double>(sp - 2, peek<long long>(sp - 2));
+      pc++;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_DOUBLE_TO_INT) {
+      sp--;
+      sp[-1] = doubleToInt(peek<double>(sp - 1));
+      pc++;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_DOUBLE_TO_LONG) {
+      poke<long long>(sp - 2, doubleToLong(peek<double>(sp - 2)));
+      pc++;
+      VM_NEXT();
+   }
+
+   VM_CASE(OP_END) {
+      if (SLICED) {
+         slice->pc = pc;
+         slice->budget = budget;
+      }
+      return VM_FINISHED;
+   }
+
+#ifndef VM_COMPUTED_GOTO
+    default:
+      error("Illegal instruction in compiled program");
+#endif
+   VM_LOOP_END()
+}
+
+void executeBytecode(const Bytecode & code, EvalState & state) {
+   run<false, false>(code, state, NULL, NULL);
+}
+
+/*
+ * Implementation notes: executeBytecode with a profiler
+ * -----------------------------------------------------
+ * The profiler is stopped even if the run ends with an error, so that
+ * the time spent in the line that failed is still charged to it.
+ */
+
+void executeBytecode(const Bytecode & code, EvalState & state, Profiler & profiler) {
+   profiler.start(code);
+   try {
+      run<true, false>(code, state, &profiler, NULL);
+   } catch (...) {
+      profiler.stop();
+      throw;
+   }
+   profiler.stop();
+}
+
+VMStatus executeSlice(const Bytecode & code, EvalState & state, VMSlice & slice) {
+   return run<false, true>(code, state, NULL, &slice);
+}
+
+int restoreData(const int *code, int pc, EvalState & state) {
+   int n = code[pc + 1];
+   state.clearData();
+   for (int k = 0; k < n; k++) {
+      state.addData(code[pc + 3 + 2 * k]);
+   }
+   return pc + 2 + 2 * n;
+}
@@ -0,0 +1,95 @@
+/*
+ * File: vm.h
+ * ----------
+ * This interface exports the virtual machine that executes the
+ * compiled form of a BASIC program produced by bytecode.h.
+ */
+
+#ifndef _vm_h
+#define _vm_h
+
+#include "bytecode.h"
+#include "evalstate.h"
+#include "profiler.h"
+
+/*
+ * Function: executeBytecode
+ * Usage: executeBytecode(code, state);
+ * ------------------------------------
+ * Runs the compiled program from its first instruction until it
+ * reaches an END statement or falls off the last line.  Variables
+ * are read from and written to the EvalState, so the values left by
+ * the run are visible to later commands, just as they are after the
+ * statements themselves are executed.
+ */
+
+void executeBytecode(const Bytecode & code, EvalState & state);
+
+/*
+ * Function: executeBytecode
+ * Usage: executeBytecode(code, state, profiler);
+ * ----------------------------------------------
+ * Runs the program exactly as above while recording in the profiler
+ * how many times each line executes and how long it takes.  Only runs
+ * made through this version pay for the measurement.
+ */
+
+void executeBytecode(const Bytecode & code, EvalState & state, Profiler & profiler);
+
+/*
+ * Type: VMStatus
+ * --------------
+ * This enumerated type describes why executeSlice returned: the slice
+ * used up its statement budget, the program reached an INPUT statement
+ * for which no value is available, or the program ended.
+ */
+
+enum VMStatus { VM_YIELDED, VM_BLOCKED, VM_FINISHED };
+
+/*
+ * Type: VMSlice
+ * -------------
+ * This structure records where a program that runs in slices stopped
+ * and what the next slice may do.  The pc field is the address at
+ * which the next slice begins, which is zero for a new run.  The
+ * budget field is the number of statements the slice may begin; on
+ * return it holds the number left unused.  If hasInput is true,
+ * inputValue is the value for the next INPUT statement, and the flag
+ * is cleared when the statement consumes it.
+ */
+
+struct VMSlice {
+   int pc;
+   int budget;
+   bool hasInput;
+   int inputValue;
+};
+
+/*
+ * Function: executeSlice
+ * Usage: VMStatus status = executeSlice(code, state, slice);
+ * ----------------------------------------------------------
+ * Runs the program from slice.pc until it has begun slice.budget
+ * statements, until it ends, or until an INPUT statement finds neither
+ * a value in the slice nor an input stream in the EvalState.  A slice
+ * never stops in the middle of a statement, so the program can be
+ * resumed by calling executeSlice again with the same slice.  A run
+ * that is never resumed needs no cleanup.  Errors are raised as they
+ * are by executeBytecode, and end the run.
+ */
+
+VMStatus executeSlice(const Bytecode & code, EvalState & state, VMSlice & slice);
+
+/*
+ * Function: restoreData
+ * Usage: pc = restoreData(code, pc, state);
+ * -----------------------------------------
+ * Performs the OP_RESTORE instruction at address pc, replacing the
+ * DATA values in the EvalState with those of the OP_DATA instructions
+ * that follow it, and returns the address of the instruction after
+ * the last of them.  The native code in jit.h calls it too.
+ */
+
+int restoreData(const int *code, int pc, EvalState & state);
+
+#endif